@@ -13,12 +13,13 @@ struct ChatServer
   AcceptorAsync server;
   Driver &driver;
 
-  // storage for connected client connection sockets
-  std::unordered_map<Address, SocketTcpAsync> clients;
-
   // send buffer pool
+  // (declared first to outlive the send queues of the clients)
   BufferPool pool;
 
+  // storage for connected client connection sockets
+  std::unordered_map<Address, SocketTcpAsync> clients;
+
   // bind a TCP server socket to given address
   // (you can turn this into a TLS-encrypted server
   // by adding arguments for certificate and key file path)
@@ -63,17 +64,18 @@ struct ChatServer
 
   void HandleReceive(Address clientAddr, BufferPtr receiveBuffer)
   {
-    auto prefixed = to_string(clientAddr) + " says: " + *receiveBuffer;
+    auto sendBuffer = pool.Get();
+    *sendBuffer = to_string(clientAddr) + " says: " + *receiveBuffer;
 
     // print whatever has just been received
-    std::cout << prefixed << std::endl;
+    std::cout << *sendBuffer << std::endl;
 
-    // forward to all but source client
+    // forward to all but source client, sharing a single buffer
+    // that returns to the pool once sent to everyone
+    SharedBufferPtr message = std::move(sendBuffer);
     for(auto &&client : clients) {
       if(client.first != clientAddr) {
-        auto sendBuffer = pool.Get();
-        *sendBuffer = prefixed;
-        (void)client.second.Send(std::move(sendBuffer));
+        (void)client.second.Send(message);
         // TODO keep history and send to new clients on connect
       }
     }
@@ -1,67 +1,57 @@
-#include "sockpuppet/socket_buffered.h" // for SocketTcpBuffered
+#include "sockpuppet/http_async.h" // for HttpClientAsync
 
 #include <cstdlib> // for EXIT_SUCCESS
 #include <iostream> // for std::cout
-#include <numeric> // for std::accumulate
 #include <stdexcept> // for std::exception
-#include <vector> // for std::vector
+#include <string> // for std::string
 
 using namespace sockpuppet;
 
-namespace {
-std::string HttpGet(std::string const &host, std::string const &path)
-{
-  return "GET " + path + " HTTP/1.1\nHost: " + host + "\n\n";
-}
-
-bool IsHtmlEnd(std::string const &response)
-{
-  return (response.find("</html>") != std::string::npos);
-}
-} // unnamed namespace
-
 int main(int, char **)
 try {
   std::string serv = "http://";
   std::string host = "www.google.com";
   std::string path = "/";
+  int const requestCount = 3;
 
-  // connect to server
   Address addr(serv + host);
-  SocketTcpBuffered buff(addr);
-
-  // send HTTP GET request
-  auto request = HttpGet(host, path);
-  (void)buff.Send(request.c_str(), request.size());
-
-  std::vector<size_t> sizes;
-  for(;;) {
-    // receive response (fragment)
-    auto rx = buff.Receive(std::chrono::seconds(30));
-
-    // break on timeout
-    if(!rx) {
-      break;
-    }
-
-    // print and collect statistics
-    auto &&response = *rx;
-    std::cout << *response;
-    sizes.push_back(response->size());
-
-    // early break on response end
-    if(IsHtmlEnd(*response)) {
-      break;
+  Driver driver;
+  HttpClientAsync client(driver,
+                         1U, // connections per host
+                         requestCount, // pipeline depth
+                         std::chrono::seconds(60), // idle timeout
+                         std::chrono::seconds(10), // connect timeout
+                         1024U * 1024U); // maximum response size
+
+  // all requests are sent on the same connection without waiting for
+  // the responses; the driver is stopped once all have been answered
+  int pending = requestCount;
+  auto done = [&]() {
+    if(--pending == 0) {
+      driver.Stop();
     }
+  };
+  for(int i = 0; i < requestCount; ++i) {
+    client.Request(addr, "GET", path, "Host: " + host + "\r\n", {},
+      [&, i](HttpResponseView const &response) {
+        if(i == 0) {
+          std::cout << response.body << "\n\n";
+        }
+        std::cout << "response #" << i
+                  << ": status " << response.status
+                  << ", " << response.body.size() << " bytes"
+                  << std::endl;
+        done();
+      },
+      [&, i](char const *reason) {
+        std::cerr << "request #" << i << " failed: " << reason << std::endl;
+        done();
+      },
+      std::chrono::seconds(30));
   }
+  driver.Run();
 
-  // print statistics
-  std::cout << "\n\nreceived "
-            << std::accumulate(std::begin(sizes), std::end(sizes), size_t(0U))
-            << " bytes in "
-            << sizes.size()
-            << " buffers"
-            << std::endl;
+  std::cout << "used " << client.ConnectionCount() << " connection(s)" << std::endl;
 
   return EXIT_SUCCESS;
 } catch (std::exception const &e) {
@@ -1,8 +1,9 @@
-#include "sockpuppet/socket_async.h" // for AcceptorAsync
+#include "sockpuppet/http_async.h" // for HttpServerAsync
 
 #include <csignal> // for std::signal
 #include <cstdlib> // for EXIT_SUCCESS
 #include <iostream> // for std::cerr
+#include <memory> // for std::unique_ptr
 #include <stdexcept> // for std::runtime_error
 #include <string> // for std::string
 #include <vector> // for std::vector
@@ -11,9 +12,7 @@ using namespace sockpuppet;
 
 namespace {
 
-std::string const response =
-  std::string("HTTP/1.1 200\r\nContent-Type: text/html\r\n\r\n")
-  + R"(<!DOCTYPE html>
+char const page[] = R"(<!DOCTYPE html>
 <html lang="en">
   <head>
     <meta charset="utf-8">
@@ -24,34 +23,39 @@ std::string const response =
   </body>
 </html>)";
 
-void HandleConnect(SocketTcp clientSock, Address clientAddr)
-try {
-  // here we intentionally misuse the connect handler; instead of
-  // only storing the client connection we do the whole HTTP handling and
-  // immediately afterwards close the connection
-
-  char buffer[256];
-  while(clientSock.Receive(buffer, sizeof(buffer),
-                           std::chrono::milliseconds(10))) {
-    // simply keep receiving whatever the client sends
-    // until we run into the timeout
-    // assume this to be an HTTP GET
-  }
-
-  std::cout << "sending HTTP response to "
-            << to_string(clientAddr) << std::endl;
+// responses are serialized once and sent as-is for every request
+HttpResponse const notFound(404U, "text/plain", "not found");
+std::unique_ptr<HttpResponse const> served;
 
-  (void)clientSock.Send(response.c_str(), response.size());
+HttpResponse const &HandleRequest(HttpRequest const &request)
+{
+  std::cout << request.method << " " << request.target << std::endl;
 
-  // destroying the handler socket closes the connection
-} catch (std::exception const &e) {
-  std::cerr << e.what() << std::endl;
+  if(request.target == "/") {
+    return *served;
+  }
+  return notFound;
 }
 
 } // unnamed namespace
 
-int main(int, char **)
+int main(int argc, char *argv[])
 try {
+  if(argc > 2) {
+    std::cout << "Usage: " << argv[0]
+              << " [FILE_PATH]\n\n"
+                 "\tFILE_PATH is the file to serve instead of a built-in page"
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+  if(argc == 2) {
+    // the file content is sent straight from the OS file cache
+    served = std::make_unique<HttpResponse const>(
+        HttpResponse::File(200U, "application/octet-stream", argv[1]));
+  } else {
+    served = std::make_unique<HttpResponse const>(200U, "text/html", page);
+  }
+
   // socket driver to run multiple servers in one thread
   static Driver driver;
 
@@ -74,14 +78,14 @@ try {
   // prepare a server for each interface address
   // (you can turn this into a TLS-encrypted server
   // by adding arguments for certificate and key file path)
-  std::vector<AcceptorAsync> servers;
+  std::vector<HttpServerAsync> servers;
   {
     for(auto &&addr : addrs) {
       try {
         servers.emplace_back(
             Acceptor(addr),
             driver,
-            HandleConnect);
+            HandleRequest);
       } catch(std::exception const &e) {
         // if binding one server fails, just go on
         std::cerr << e.what() << std::endl;
@@ -0,0 +1,247 @@
+#ifndef SOCKPUPPET_HTTP_ASYNC_H
+#define SOCKPUPPET_HTTP_ASYNC_H
+
+#include "sockpuppet/address.h" // for Address
+#include "sockpuppet/socket.h" // for Acceptor
+#include "sockpuppet/socket_async.h" // for Driver
+
+#include <cstddef> // for size_t
+#include <functional> // for std::function
+#include <memory> // for std::unique_ptr
+#include <optional> // for std::optional
+#include <string> // for std::string
+#include <string_view> // for std::string_view
+
+namespace sockpuppet {
+
+struct HttpServerImpl;
+struct HttpClientImpl;
+
+/// HTTP/1.x request received by an \ref HttpServerAsync.
+/// All views refer to the receive ring of the connection
+/// and are valid during the request handler call only.
+struct HttpRequest
+{
+  std::string_view method; ///< Request method, e.g. "GET".
+  std::string_view target; ///< Request target, e.g. "/health?verbose".
+  int minorVersion; ///< 1 for HTTP/1.1, 0 for HTTP/1.0.
+  std::string_view headers; ///< Header lines, each terminated by CRLF.
+  std::string_view body; ///< Request body of the size given by Content-Length.
+
+  /// Look up a header field of the request.
+  /// @param  name  Field name, compared case-insensitively.
+  /// @return  Field value without surrounding whitespace
+  ///          or nullopt if the request does not carry the field.
+  std::optional<std::string_view> Header(std::string_view name) const;
+};
+
+/// HTTP/1.1 response that is serialized once on creation and sent as-is,
+/// e.g. to prepare the response to a fixed resource once up front
+/// and return it for any number of requests.
+struct HttpResponse
+{
+  /// Serialize a response along with the matching Content-Length.
+  /// @param  status  Status code, e.g. 200.
+  /// @param  contentType  Media type of the body; empty to omit the field.
+  /// @param  body  Response body.
+  /// @param  headers  Additional header lines, each terminated by CRLF.
+  /// @throws  If the status code is invalid or does not permit a body.
+  HttpResponse(unsigned int status,
+               std::string_view contentType = {},
+               std::string_view body = {},
+               std::string_view headers = {});
+
+  /// Serialize a response whose body is a file, which is sent without
+  /// copying it through user space where supported (see SocketTcpAsync::SendFile).
+  /// The file is opened anew per request and must keep its size.
+  /// @param  status  Status code, e.g. 200.
+  /// @param  contentType  Media type of the body; empty to omit the field.
+  /// @param  filePath  Path of the file to send as body.
+  /// @param  headers  Additional header lines, each terminated by CRLF.
+  /// @throws  If the status code is invalid or does not permit a body
+  ///          or if the file size cannot be determined.
+  static HttpResponse File(unsigned int status,
+                           std::string_view contentType,
+                           std::string filePath,
+                           std::string_view headers = {});
+
+  std::string wire; ///< Status line, header lines, empty line and body.
+  size_t headSize; ///< Size of status line and header lines excluding the empty line.
+  std::string filePath; ///< File to send as body following the wire content; empty if none.
+  size_t fileSize = 0U; ///< Size of the file announced by Content-Length.
+};
+
+/// Callback for requests received by an \ref HttpServerAsync.
+/// @param  Complete request received from a client.
+/// @return  Response to send, which is copied for sending right away
+///          (except for a file body); may refer to a static response
+///          or to one reused by the handler.
+using HttpRequestHandler = std::function<HttpResponse const &(HttpRequest const &)>;
+
+/// HTTP/1.1 server run by a socket driver. Client connections are kept
+/// open for subsequent requests (keep-alive) and requests are parsed
+/// from the receive ring of their connection without copying. Requests
+/// sent back-to-back without waiting for the responses (pipelining)
+/// are answered in order with a single send per receipt.
+/// Malformed or unsupported requests are answered with an error status
+/// and close their connection.
+struct HttpServerAsync
+{
+  /// Create an HTTP server accepting clients on given server socket.
+  /// @param  sock  TCP server socket to accept clients on; a TLS-enabled
+  ///               server socket results in an HTTPS server.
+  /// @param  driver  Socket driver to run the server and its connections.
+  /// @param  handleRequest  (Bound) function to call per request.
+  /// @param  idleTimeout  Time after which a connection without requests
+  ///                      is closed; a negative value keeps idle connections open.
+  /// @param  maxRequestSize  Maximum size of a request including its body;
+  ///                         determines the receive ring size of each connection.
+  /// @throws  If an invalid handler or maximum request size is provided.
+  HttpServerAsync(Acceptor &&sock,
+                  Driver &driver,
+                  HttpRequestHandler handleRequest,
+                  Duration idleTimeout = std::chrono::seconds(60),
+                  size_t maxRequestSize = 8192U);
+
+  /// Get the local (bound-to) address of the server socket.
+  /// @throws  If the address lookup fails.
+  Address LocalAddress() const;
+
+  /// Get the number of client connections currently open.
+  size_t ConnectionCount() const;
+
+  HttpServerAsync(HttpServerAsync const &other) = delete;
+  HttpServerAsync(HttpServerAsync &&other) noexcept;
+  ~HttpServerAsync();
+  HttpServerAsync &operator=(HttpServerAsync const &other) = delete;
+  HttpServerAsync &operator=(HttpServerAsync &&other) noexcept;
+
+  /// Bridge to hide away the OS-specifics.
+  std::unique_ptr<HttpServerImpl> impl;
+};
+
+/// HTTP/1.x response received by an \ref HttpClientAsync.
+/// All views refer to the receive ring of the connection (or the decoded
+/// body of a chunked response) and are valid during the response handler call only.
+struct HttpResponseView
+{
+  unsigned int status; ///< Status code, e.g. 200.
+  int minorVersion; ///< 1 for HTTP/1.1, 0 for HTTP/1.0.
+  std::string_view headers; ///< Header lines, each terminated by CRLF.
+  std::string_view body; ///< Response body with any chunked transfer coding removed.
+
+  /// Look up a header field of the response.
+  /// @param  name  Field name, compared case-insensitively.
+  /// @return  Field value without surrounding whitespace
+  ///          or nullopt if the response does not carry the field.
+  std::optional<std::string_view> Header(std::string_view name) const;
+};
+
+/// Callback for responses received by an \ref HttpClientAsync.
+/// @param  Complete response to the request.
+using HttpResponseHandler = std::function<void(HttpResponseView const &)>;
+
+/// Callback for requests of an \ref HttpClientAsync that failed.
+/// @param  Reason why the request failed, e.g. a connect error or timeout.
+using HttpErrorHandler = std::function<void(char const *)>;
+
+/// HTTP/1.1 client run by a socket driver. Connections are kept open
+/// per server address and reused for subsequent requests (keep-alive);
+/// up to a given number of requests are sent on a connection without
+/// waiting for the responses (pipelining). Responses are parsed
+/// incrementally from the receive ring of their connection and support
+/// both Content-Length and chunked transfer coding.
+/// Idempotent requests whose connection was closed before their response
+/// started (e.g. when an idle connection was closed by the server
+/// concurrently) are retried once on another connection.
+struct HttpClientAsync
+{
+  /// Create an HTTP client.
+  /// @param  driver  Socket driver to run the client and its connections.
+  /// @param  maxPerHost  Maximum number of concurrent connections
+  ///                     per server address; 0 for unlimited.
+  /// @param  pipelineDepth  Maximum number of requests in flight per connection;
+  ///                        non-idempotent requests are only sent on
+  ///                        connections without requests in flight.
+  /// @param  idleTimeout  Time after which an unused connection is closed;
+  ///                      a negative value keeps idle connections open.
+  /// @param  connectTimeout  Timeout to use when connecting; a negative
+  ///                         value leaves the timeout to the OS.
+  /// @param  maxResponseSize  Maximum size of a response including its body;
+  ///                          determines the receive ring size of each connection.
+  /// @throws  If an invalid pipeline depth or maximum response size is provided.
+  HttpClientAsync(Driver &driver,
+                  size_t maxPerHost = 4U,
+                  size_t pipelineDepth = 1U,
+                  Duration idleTimeout = std::chrono::seconds(60),
+                  Duration connectTimeout = Duration(-1),
+                  size_t maxResponseSize = 65536U);
+
+#ifdef SOCKPUPPET_WITH_TLS
+  /// Create an HTTPS client.
+  /// @param  driver  Socket driver to run the client and its connections.
+  /// @param  maxPerHost  Maximum number of concurrent connections
+  ///                     per server address; 0 for unlimited.
+  /// @param  pipelineDepth  Maximum number of requests in flight per connection;
+  ///                        non-idempotent requests are only sent on
+  ///                        connections without requests in flight.
+  /// @param  idleTimeout  Time after which an unused connection is closed;
+  ///                      a negative value keeps idle connections open.
+  /// @param  connectTimeout  Timeout to use when connecting; a negative
+  ///                         value leaves the timeout to the OS.
+  /// @param  maxResponseSize  Maximum size of a response including its body;
+  ///                          determines the receive ring size of each connection.
+  /// @param  certFilePath  Path to certificate file in PEM format
+  /// @param  keyFilePath  Path to private key file in PEM format.
+  /// @throws  If an invalid pipeline depth or maximum response size is provided.
+  HttpClientAsync(Driver &driver,
+                  size_t maxPerHost,
+                  size_t pipelineDepth,
+                  Duration idleTimeout,
+                  Duration connectTimeout,
+                  size_t maxResponseSize,
+                  char const *certFilePath,
+                  char const *keyFilePath);
+#endif // SOCKPUPPET_WITH_TLS
+
+  /// Send a request to given server address on an open connection if one
+  /// is available, connecting anew while below the per-host limit and
+  /// queuing the request otherwise. A Host header field is added unless
+  /// given and a Content-Length header field is added for a request body.
+  /// @param  serverAddress  Server address to connect to.
+  /// @param  method  Request method, e.g. "GET".
+  /// @param  target  Request target, e.g. "/health?verbose".
+  /// @param  headers  Additional header lines, each terminated by CRLF.
+  /// @param  body  Request body.
+  /// @param  handleResponse  (Bound) function to call with the response.
+  /// @param  handleError  (Bound) function to call if the request failed.
+  /// @param  timeout  Time to wait for the complete response including
+  ///                  connecting and queuing; a negative value waits forever.
+  /// @throws  If an invalid handler is provided.
+  /// @note  Each request reports exactly one of response or error,
+  ///        both in the thread context of the driver.
+  void Request(Address const &serverAddress,
+               std::string_view method,
+               std::string_view target,
+               std::string_view headers,
+               std::string_view body,
+               HttpResponseHandler handleResponse,
+               HttpErrorHandler handleError,
+               Duration timeout = Duration(-1));
+
+  /// Get the number of server connections currently open or being opened.
+  size_t ConnectionCount() const;
+
+  HttpClientAsync(HttpClientAsync const &other) = delete;
+  HttpClientAsync(HttpClientAsync &&other) noexcept;
+  ~HttpClientAsync();
+  HttpClientAsync &operator=(HttpClientAsync const &other) = delete;
+  HttpClientAsync &operator=(HttpClientAsync &&other) noexcept;
+
+  /// Bridge to hide away the OS-specifics.
+  std::unique_ptr<HttpClientImpl> impl;
+};
+
+} // namespace sockpuppet
+
+#endif // SOCKPUPPET_HTTP_ASYNC_H
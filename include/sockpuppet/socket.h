@@ -5,8 +5,11 @@
 
 #include <chrono> // for std::chrono
 #include <cstddef> // for size_t
+#include <cstdint> // for uint64_t
 #include <memory> // for std::unique_ptr
 #include <optional> // for std::optional
+#include <string> // for std::string
+#include <string_view> // for std::string_view
 #include <utility> // for std::pair
 
 namespace sockpuppet {
@@ -14,6 +17,152 @@ namespace sockpuppet {
 struct SocketImpl;
 using Duration = std::chrono::milliseconds;
 
+/// TCP transport tuning to apply to a connected or listening socket.
+/// Options left unset keep the OS defaults.
+/// @note  Some options are specific to the OS (mostly Linux);
+///        setting these elsewhere fails with an exception.
+struct TcpOptions
+{
+  /// Send small messages immediately instead of coalescing them
+  /// (disable Nagle's algorithm, TCP_NODELAY).
+  std::optional<bool> noDelay;
+
+  /// Hold back partial frames until uncorked or a full frame is
+  /// available (TCP_CORK, TCP_NOPUSH on BSD/macOS).
+  std::optional<bool> cork;
+
+  /// Acknowledge received data immediately instead of delaying
+  /// acknowledgements (TCP_QUICKACK). The OS may revert this over time.
+  std::optional<bool> quickAck;
+
+  /// Probe idle connections to detect dead peers (SO_KEEPALIVE).
+  std::optional<bool> keepAlive;
+
+  /// Idle time before the first keep-alive probe (TCP_KEEPIDLE),
+  /// in whole seconds.
+  std::optional<Duration> keepAliveIdle;
+
+  /// Time between keep-alive probes (TCP_KEEPINTVL), in whole seconds.
+  std::optional<Duration> keepAliveInterval;
+
+  /// Number of unanswered keep-alive probes before the connection
+  /// is dropped (TCP_KEEPCNT).
+  std::optional<int> keepAliveCount;
+
+  /// Maximum time sent data may remain unacknowledged before the
+  /// connection is dropped (TCP_USER_TIMEOUT).
+  std::optional<Duration> userTimeout;
+
+  /// Amount of unsent data in the socket send buffer below which the socket
+  /// is reported writable (TCP_NOTSENT_LOWAT); keeps queued data
+  /// in the application where it can still be prioritized/dropped.
+  std::optional<size_t> notSentLowWat;
+
+  /// Name of the congestion control algorithm, e.g. "bbr" or "cubic"
+  /// (TCP_CONGESTION).
+  std::optional<std::string> congestion;
+
+  /// Preset for request/response traffic with small messages:
+  /// no Nagle delay, immediate acknowledgements (where supported)
+  /// and fast detection of dead peers.
+  static TcpOptions LowLatency();
+};
+
+/// Snapshot of the TCP transport state of a connection (TCP_INFO)
+/// to diagnose slow or congested peers.
+struct TcpInfo
+{
+  /// Smoothed round trip time.
+  std::chrono::microseconds rtt;
+
+  /// Round trip time variance.
+  std::chrono::microseconds rttVar;
+
+  /// Congestion window in bytes.
+  size_t congestionWindow;
+
+  /// Total number of retransmitted segments.
+  size_t retransmits;
+
+  /// Bytes sent but not yet acknowledged by the peer (estimated from segments).
+  size_t bytesInFlight;
+
+  /// Bytes in the socket send buffer not yet sent;
+  /// zero if not reported by the OS.
+  size_t bytesNotSent;
+
+  /// Most recent delivery rate in bytes per second;
+  /// zero if not reported by the OS.
+  uint64_t deliveryRate;
+};
+
+#ifdef SOCKPUPPET_WITH_TLS
+struct TlsContextImpl;
+
+/// TLS session resumption policy. A resumed handshake reuses the keys of
+/// an earlier session and skips the asymmetric cryptography of a full one.
+struct TlsSessionOptions
+{
+  /// Issue session tickets to clients to resume
+  /// without the server keeping any state.
+  bool tickets = true;
+
+  /// Number of sessions a server keeps to be resumed by session ID;
+  /// zero disables the server-side cache.
+  size_t serverCacheSize = 20480U;
+
+  /// Number of server addresses for which a client keeps its latest
+  /// session to resume on the next connect; zero disables the client-side cache.
+  size_t clientCacheSize = 1024U;
+
+  /// Lifetime of sessions and tickets, in whole seconds.
+  /// Unset keeps the OpenSSL default.
+  std::optional<Duration> timeout;
+};
+
+/// Handshake counters of a TLS context across all of its sockets.
+struct TlsSessionStats
+{
+  /// Handshakes completed, both full and resumed.
+  size_t handshakes;
+
+  /// Handshakes that resumed an earlier session.
+  size_t resumed;
+};
+
+/// TLS certificate and private key, loaded once to be shared by
+/// any number of client and server sockets along with their session caches.
+/// Copies refer to the same context.
+struct TlsContext
+{
+  /// Load certificate and private key from files.
+  /// @param  certFilePath  Path to certificate file in PEM format
+  /// @param  keyFilePath  Path to private key file in PEM format.
+  /// @param  options  Session resumption policy.
+  /// @throws  If loading certificate/key or applying the options fails.
+  TlsContext(char const *certFilePath,
+             char const *keyFilePath,
+             TlsSessionOptions const &options = TlsSessionOptions());
+
+  /// Load certificate and private key from memory.
+  /// @param  certPem  Certificate in PEM format.
+  /// @param  keyPem  Private key in PEM format.
+  /// @param  options  Session resumption policy.
+  /// @throws  If parsing certificate/key or applying the options fails.
+  static TlsContext FromMemory(std::string_view certPem,
+                               std::string_view keyPem,
+                               TlsSessionOptions const &options = TlsSessionOptions());
+
+  /// Get the handshake counters of all sockets using the context.
+  TlsSessionStats SessionStats() const;
+
+  TlsContext(std::shared_ptr<TlsContextImpl> other);
+
+  /// Bridge to hide away the OpenSSL specifics.
+  std::shared_ptr<TlsContextImpl> impl;
+};
+#endif // SOCKPUPPET_WITH_TLS
+
 /// UDP (unreliable communication) socket class that is
 /// bound to provided address.
 struct SocketUdp
@@ -95,6 +244,17 @@ struct SocketTcp
   SocketTcp(Address const &connectAddress,
             char const *certFilePath,
             char const *keyFilePath);
+
+  /// Create a TLS-enabled TCP socket connected to given address
+  /// without reloading certificate/key.
+  /// @param  connectAddress  Peer address to connect to.
+  /// @param  context  TLS context to share with other sockets.
+  /// @throws  If connect fails.
+  /// @note  While the TCP connection is established immediately,
+  ///        the TLS handshake is performed later with subsequent
+  ///        send/receive operations.
+  SocketTcp(Address const &connectAddress,
+            TlsContext const &context);
 #endif // SOCKPUPPET_WITH_TLS
 
   /// Reliably send data to connected peer.
@@ -108,6 +268,36 @@ struct SocketTcp
               size_t size,
               Duration timeout = Duration(-1));
 
+  /// Reliably send a region of a file to connected peer
+  /// without copying it through user space where supported.
+  /// @param  filePath  Path of the file to send from.
+  /// @param  offset  Offset of the region to send.
+  /// @param  size  Size of the region to send; unset sends up to the end of file.
+  /// @param  timeout  Timeout to use; non-null causes blocking send,
+  ///                  a negative value allows unlimited blocking.
+  /// @return  Number of bytes sent. Always matches the region size on unlimited \p timeout.
+  /// @throws  If the file cannot be read, sending fails or the peer closes the connection.
+  /// @note  Not supported with TLS.
+  size_t SendFile(char const *filePath,
+                  size_t offset = 0U,
+                  std::optional<size_t> size = std::nullopt,
+                  Duration timeout = Duration(-1));
+
+  /// Reliably send a region of an opened file to connected peer
+  /// without copying it through user space where supported.
+  /// @param  fileDescriptor  Readable file descriptor to send from; its file position is not used.
+  /// @param  offset  Offset of the region to send.
+  /// @param  size  Size of the region to send; unset sends up to the end of file.
+  /// @param  timeout  Timeout to use; non-null causes blocking send,
+  ///                  a negative value allows unlimited blocking.
+  /// @return  Number of bytes sent. Always matches the region size on unlimited \p timeout.
+  /// @throws  If the file cannot be read, sending fails or the peer closes the connection.
+  /// @note  Not supported with TLS.
+  size_t SendFile(int fileDescriptor,
+                  size_t offset = 0U,
+                  std::optional<size_t> size = std::nullopt,
+                  Duration timeout = Duration(-1));
+
   /// Reliably receive data from connected peer.
   /// @param  data  Pointer to receive buffer to fill.
   /// @param  size  Available receive buffer size.
@@ -134,6 +324,15 @@ struct SocketTcp
   /// @throws  If getting the socket parameter fails.
   size_t ReceiveBufferSize() const;
 
+  /// Apply TCP transport options to the connection.
+  /// @param  options  Options to set; unset options are left untouched.
+  /// @throws  If setting an option fails or is not supported by the OS.
+  void SetOptions(TcpOptions const &options);
+
+  /// Get a snapshot of the transport state of the connection.
+  /// @throws  If the lookup fails or is not supported by the OS.
+  TcpInfo Info() const;
+
   SocketTcp(std::unique_ptr<SocketImpl> &&other);
   SocketTcp(SocketTcp const &other) = delete;
   SocketTcp(SocketTcp &&other) noexcept;
@@ -171,6 +370,19 @@ struct Acceptor
   Acceptor(Address const &bindAddress,
            char const *certFilePath,
            char const *keyFilePath);
+
+  /// Create a TLS-enabled TCP server socket bound to given address
+  /// without reloading certificate/key.
+  /// @param  bindAddress  Local interface address to bind to.
+  ///                      Unspecified service or port number 0
+  ///                      binds to an OS-assigned port.
+  /// @param  context  TLS context to share with other sockets.
+  /// @throws  If binding fails.
+  /// @note  While incoming TCP connections are established immediately,
+  ///        their TLS handshake is performed later with subsequent
+  ///        send/receive operations.
+  Acceptor(Address const &bindAddress,
+           TlsContext const &context);
 #endif // SOCKPUPPET_WITH_TLS
 
   /// Listen and accept incoming TCP connections and report the source.
@@ -186,6 +398,12 @@ struct Acceptor
   /// @throws  If the address lookup fails.
   Address LocalAddress() const;
 
+  /// Apply TCP transport options to the server socket
+  /// to be inherited by subsequently accepted client sockets.
+  /// @param  options  Options to set; unset options are left untouched.
+  /// @throws  If setting an option fails or is not supported by the OS.
+  void SetOptions(TcpOptions const &options);
+
   Acceptor(Acceptor const &other) = delete;
   Acceptor(Acceptor &&other) noexcept;
   ~Acceptor();
@@ -8,6 +8,11 @@
 #include <functional> // for std::function
 #include <future> // for std::future
 #include <memory> // for std::unique_ptr
+#include <memory_resource> // for std::pmr::memory_resource
+#include <optional> // for std::optional
+#include <string> // for std::string
+#include <string_view> // for std::string_view
+#include <utility> // for std::pair
 
 namespace sockpuppet {
 
@@ -24,6 +29,17 @@ struct Driver
   /// @throws  If creating the internal event signalling fails.
   Driver();
 
+  /// Create a driver whose attached sockets obtain the memory for their
+  /// send queue entries, send futures and receipt source addresses from
+  /// given resource, e.g. a pool that makes the steady-state send/receive
+  /// path free of heap allocations.
+  /// @param  resource  Memory resource to use; must be thread-safe (e.g.
+  ///                   std::pmr::synchronized_pool_resource), as sending threads
+  ///                   and holders of futures and addresses obtain and release
+  ///                   memory, and outlive the driver and all of these.
+  /// @throws  If creating the internal event signalling fails.
+  explicit Driver(std::pmr::memory_resource *resource);
+
   /// Run one iteration on the attached sockets.
   /// @param  timeout  Maximum allowed time to use; non-null allows
   ///                  blocking if all attached sockets are idle,
@@ -42,6 +58,23 @@ struct Driver
   /// @throws  If the internal event signalling fails.
   void Stop();
 
+  /// Get the NUMA node the thread stepping the driver is bound to.
+  /// Receive buffers of the attached sockets are reallocated on this
+  /// node if they were allocated elsewhere, e.g. by the thread that
+  /// constructed the sockets.
+  /// @return  Node number, nullopt if not bound by \ref SetNumaNode
+  ///          or not stepped since.
+  std::optional<unsigned int> NumaNode() const;
+
+  /// Restrict the thread that steps the driver next (i.e. the one
+  /// running Run()) to the CPUs of a NUMA node; the receive buffers
+  /// of the attached sockets follow on their next receipt.
+  /// @param  node  NUMA node number as known to the OS.
+  /// @throws  If the node is unknown or not supported by the OS.
+  /// @note  Buffers of a \ref SharedBufferPool are not moved, as these
+  ///        may be used by sockets of several drivers.
+  void SetNumaNode(unsigned int node);
+
   Driver(Driver const &) = delete;
   Driver(Driver &&other) noexcept;
   ~Driver();
@@ -113,6 +146,10 @@ struct ToDo
 };
 
 struct SocketAsyncImpl;
+struct ConnectorAsyncImpl;
+struct ConnectionPoolImpl;
+struct LeaseImpl;
+struct RelayImpl;
 
 /// Callback for UDP received data.
 /// @param  Received data buffer borrowed from socket.
@@ -125,13 +162,46 @@ using ReceiveFromHandler = std::function<void(BufferPtr, Address)>;
 ///         Zero-size receipt cannot happen in TCP.
 using ReceiveHandler = std::function<void(BufferPtr)>;
 
-/// Callback for accepted incoming TCP connections.
+/// Callback for TCP received data in the receive ring of the socket.
+/// @param  View of all unconsumed data received from connected peer;
+///         valid during the call only.
+/// @return  Number of bytes consumed from the front of the view; the
+///          remainder is passed again along with the next receipt.
+using ReceiveViewHandler = std::function<size_t(std::string_view)>;
+
+/// Callback providing the memory to receive into directly, e.g. the free
+/// space of a message arena or decode ring, instead of a pooled buffer.
+/// @return  Writable memory (data and size); must stay valid until
+///          the subsequent receipt handler has been called.
+using ReceiveIntoProvider = std::function<std::pair<char *, size_t>()>;
+
+/// Callback for TCP data received into memory from \ref ReceiveIntoProvider.
+/// @param  Number of bytes received to the front of the memory provided;
+///         never zero.
+using ReceiveIntoHandler = std::function<void(size_t)>;
+
+/// Callback for UDP data received into memory from \ref ReceiveIntoProvider.
+/// @param  Number of bytes received to the front of the memory provided;
+///         datagrams larger than the memory provided are truncated.
+/// @param  Receipt source address.
+using ReceiveFromIntoHandler = std::function<void(size_t, Address)>;
+
+/// Callback for a complete message split from the TCP data received.
+/// @param  View of the message without its framing; valid during the call only.
+using MessageHandler = std::function<void(std::string_view)>;
+
+/// Callback for accepted incoming or established outgoing TCP connections.
 /// @param  Local socket connected to peer.
 /// @param  Address of peer connected to local socket.
 /// @note  Obtained basic socket can be used as-is or may be upgraded
 ///        to async socket with same or different driver.
 using ConnectHandler = std::function<void(SocketTcp, Address)>;
 
+/// Callback for failed outgoing TCP connections.
+/// @param  Address of peer the connection was attempted to.
+/// @param  Error/reason message.
+using ConnectErrorHandler = std::function<void(Address, char const *)>;
+
 /// Callback for TCP peer disconnect.
 /// @param  Address of peer that just disconnected from local socket.
 ///         Matches connect address the socket was created with or
@@ -140,6 +210,52 @@ using ConnectHandler = std::function<void(SocketTcp, Address)>;
 /// @note  After peer disconnect the socket is invalid and should be released.
 using DisconnectHandler = std::function<void(Address, char const *)>;
 
+/// Message boundaries within a TCP byte stream; splits the data of a
+/// receive ring into messages, which are passed without copying.
+struct Framing
+{
+  /// Messages preceded by their size as unsigned integer.
+  /// @param  width  Width of the size field in bytes (1 to 8).
+  /// @param  bigEndian  Byte order of the size field.
+  /// @param  maxSize  Maximum accepted message size.
+  /// @throws  If the width is not supported.
+  static Framing LengthPrefixed(size_t width = 4U,
+                                bool bigEndian = true,
+                                size_t maxSize = 65536U);
+
+  /// Messages terminated by a delimiter sequence.
+  /// @param  delimiter  Sequence that ends each message.
+  /// @param  maxSize  Maximum accepted message size, excluding the delimiter.
+  /// @throws  If the delimiter is empty.
+  static Framing Delimited(std::string delimiter,
+                           size_t maxSize = 65536U);
+
+  /// Create a receive handler splitting received data into messages.
+  /// @param  handleMessage  (Bound) function to call per complete message.
+  /// @return  Handler to create a SocketTcpAsync with receive ring from.
+  /// @throws  If an invalid handler is provided.
+  /// @note  Choose a receive ring capacity that fits a message of maximum size
+  ///        including its framing; larger messages disconnect the socket.
+  ///        Destroying the socket from within the handler stops passing
+  ///        further messages that have already been received.
+  ReceiveViewHandler Receiver(MessageHandler handleMessage) const;
+
+  /// Append the framing preceding a message (if any) to a buffer.
+  /// @param  buffer  Buffer to append the size field of the message to.
+  /// @param  size  Size of the message payload.
+  /// @throws  If the size exceeds the maximum message size.
+  void AppendHeader(std::string &buffer, size_t size) const;
+
+  /// Append the framing following a message (if any) to a buffer.
+  /// @param  buffer  Buffer to append the delimiter to.
+  void AppendTrailer(std::string &buffer) const;
+
+  size_t prefixWidth; ///< Size field width; zero for delimited messages.
+  bool bigEndian; ///< Size field byte order.
+  std::string delimiter; ///< Message terminator; empty for length-prefixed messages.
+  size_t maxSize; ///< Maximum accepted message size.
+};
+
 /// UDP (unreliable communication) socket class that adds an interface for
 /// an external socket driver to the buffered UDP class.
 struct SocketUdpAsync
@@ -153,6 +269,20 @@ struct SocketUdpAsync
                  Driver &driver,
                  ReceiveFromHandler handleReceiveFrom);
 
+  /// Create a UDP socket driven by given socket driver
+  /// that receives into memory provided by the user.
+  /// @param  buff  Buffered UDP socket to augment; its receive buffers are not used.
+  /// @param  driver  Socket driver to run the socket.
+  /// @param  provideReceive  (Bound) function to call for the memory
+  ///                         to receive the next datagram into.
+  /// @param  handleReceiveFrom  (Bound) function to call on receipt.
+  /// @throws  If an invalid handler is provided.
+  /// @note  Datagrams arriving while no memory is provided are dropped.
+  SocketUdpAsync(SocketUdpBuffered &&buff,
+                 Driver &driver,
+                 ReceiveIntoProvider provideReceive,
+                 ReceiveFromIntoHandler handleReceiveFrom);
+
   /// Enqueue data to unreliably send to address.
   /// @param  buffer  Borrowed buffer to enqueue for send and release after completition.
   ///                 Create using your own BufferPool.
@@ -166,6 +296,10 @@ struct SocketUdpAsync
   /// @throws  If the address lookup fails.
   Address LocalAddress() const;
 
+  /// Get a snapshot of the usage of the receive buffers (of all size
+  /// classes, or of all sockets sharing the pool).
+  BufferPoolStats ReceiveBufferStats() const;
+
   SocketUdpAsync(SocketUdpAsync const &other) = delete;
   SocketUdpAsync(SocketUdpAsync &&other) noexcept;
   ~SocketUdpAsync();
@@ -193,12 +327,84 @@ struct SocketTcpAsync
                  ReceiveHandler handleReceive,
                  DisconnectHandler handleDisconnect);
 
+  /// Create a TCP socket driven by given socket driver
+  /// that passes received data in its receive ring.
+  /// @param  buff  Buffered TCP socket with receive ring enabled.
+  /// @param  driver  Socket driver to run the socket.
+  /// @param  handleReceive  (Bound) function to call on receipt with all
+  ///                        unconsumed data; reports the amount consumed.
+  /// @param  handleDisconnect  (Bound) function to call when socket was
+  ///                           disconnected and has become invalid.
+  /// @throws  If an invalid handler is provided or the receive ring is not enabled.
+  /// @note  A receive ring filled up with unconsumed data disconnects the socket.
+  SocketTcpAsync(SocketTcpBuffered &&buff,
+                 Driver &driver,
+                 ReceiveViewHandler handleReceive,
+                 DisconnectHandler handleDisconnect);
+
+  /// Create a TCP socket driven by given socket driver
+  /// that receives into memory provided by the user, e.g. to decode
+  /// messages in place without copying them out of a pooled buffer.
+  /// @param  buff  Buffered TCP socket to augment; its receive buffers are not used.
+  /// @param  driver  Socket driver to run the socket.
+  /// @param  provideReceive  (Bound) function to call for the memory
+  ///                         to receive into once data is pending.
+  /// @param  handleReceive  (Bound) function to call on receipt.
+  /// @param  handleDisconnect  (Bound) function to call when socket was
+  ///                           disconnected and has become invalid.
+  /// @throws  If an invalid handler is provided.
+  /// @note  Providing no memory while data is pending disconnects the socket.
+  SocketTcpAsync(SocketTcpBuffered &&buff,
+                 Driver &driver,
+                 ReceiveIntoProvider provideReceive,
+                 ReceiveIntoHandler handleReceive,
+                 DisconnectHandler handleDisconnect);
+
   /// Enqueue data to reliably send to connected peer.
   /// @param  buffer  Borrowed buffer to enqueue for send and release after completition.
   ///                 Create using your own BufferPool.
   /// @return  Future object to fulfill when data was actually sent.
   std::future<void> Send(BufferPtr &&buffer);
 
+  /// Enqueue data shared with other owners to reliably send to connected peer,
+  /// e.g. to broadcast a message to many sockets without copying it.
+  /// @param  buffer  Immutable buffer to enqueue for send and release after completion.
+  /// @return  Future object to fulfill when data was actually sent.
+  std::future<void> Send(SharedBufferPtr buffer);
+
+  /// Enqueue a header and a payload to reliably send to connected peer
+  /// one after the other without concatenating them (gather send).
+  /// @param  header  Borrowed buffer to send first, e.g. filled by Framing::AppendHeader.
+  /// @param  payload  Borrowed buffer to send right after the header.
+  /// @return  Future object to fulfill when both were actually sent.
+  std::future<void> Send(BufferPtr &&header,
+                         BufferPtr &&payload);
+
+  /// Enqueue a region of a file to reliably send to connected peer
+  /// without copying it through user space where supported.
+  /// @param  filePath  Path of the file to send from; opened immediately.
+  /// @param  offset  Offset of the region to send.
+  /// @param  size  Size of the region to send; unset sends up to the end of file.
+  /// @return  Future object to fulfill when the region was actually sent.
+  /// @throws  If the file cannot be opened or the region exceeds the file.
+  /// @note  Not supported with TLS; the future reports the failure.
+  std::future<void> SendFile(char const *filePath,
+                             size_t offset = 0U,
+                             std::optional<size_t> size = std::nullopt);
+
+  /// Enqueue a region of an opened file to reliably send to connected peer
+  /// without copying it through user space where supported.
+  /// @param  fileDescriptor  Readable file descriptor to send from;
+  ///                         must be kept open until the future is fulfilled.
+  /// @param  offset  Offset of the region to send.
+  /// @param  size  Size of the region to send; unset sends up to the end of file.
+  /// @return  Future object to fulfill when the region was actually sent.
+  /// @throws  If the region exceeds the file.
+  /// @note  Not supported with TLS; the future reports the failure.
+  std::future<void> SendFile(int fileDescriptor,
+                             size_t offset = 0U,
+                             std::optional<size_t> size = std::nullopt);
+
   /// Get the local (bound-to) address of the socket.
   /// @throws  If the address lookup fails.
   Address LocalAddress() const;
@@ -207,6 +413,34 @@ struct SocketTcpAsync
   /// @throws  If the address lookup fails.
   Address PeerAddress() const;
 
+  /// Apply TCP transport options to the connection.
+  /// @param  options  Options to set; unset options are left untouched.
+  /// @throws  If setting an option fails or is not supported by the OS.
+  void SetOptions(TcpOptions const &options);
+
+  /// Get a snapshot of the transport state of the connection.
+  /// @throws  If the lookup fails or is not supported by the OS.
+  TcpInfo Info() const;
+
+  /// Get the amount of data enqueued for send but not yet handed to the OS;
+  /// a steadily growing queue indicates a peer that can't keep up.
+  /// @return  Number of bytes waiting in the send queue.
+  size_t SendQueueSize() const;
+
+  /// Get a snapshot of the usage of the receive buffers (of all size
+  /// classes, or of all sockets sharing the pool); a steadily growing
+  /// number of busy buffers indicates buffers that are never released.
+  BufferPoolStats ReceiveBufferStats() const;
+
+  /// Switch to zero-copy sending (MSG_ZEROCOPY) where data is transmitted
+  /// from the enqueued buffers directly instead of being copied to the OS.
+  /// Sent buffers are kept from returning to their pool until the OS has
+  /// released them, which is when the futures of \ref Send are fulfilled.
+  /// @throws  If zero-copy is not supported by the OS or the socket (TLS).
+  /// @note  Pays off for large buffers (upwards of ~10 KB) only;
+  ///        on loopback connections the OS silently falls back to copying.
+  void EnableZeroCopy();
+
   SocketTcpAsync(SocketTcpAsync const &other) = delete;
   SocketTcpAsync(SocketTcpAsync &&other) noexcept;
   ~SocketTcpAsync();
@@ -234,6 +468,12 @@ struct AcceptorAsync
   /// @throws  If the address lookup fails.
   Address LocalAddress() const;
 
+  /// Apply TCP transport options to the server socket
+  /// to be inherited by subsequently accepted client sockets.
+  /// @param  options  Options to set; unset options are left untouched.
+  /// @throws  If setting an option fails or is not supported by the OS.
+  void SetOptions(TcpOptions const &options);
+
   AcceptorAsync(AcceptorAsync const &other) = delete;
   AcceptorAsync(AcceptorAsync &&other) noexcept;
   ~AcceptorAsync();
@@ -244,6 +484,219 @@ struct AcceptorAsync
   std::unique_ptr<SocketAsyncImpl> impl;
 };
 
+/// TCP (reliable communication) socket class that connects to the provided
+/// peer address without blocking the caller; the connection is
+/// established by the given socket driver.
+/// If the address resolves to multiple hosts (e.g. IPv6 and IPv4),
+/// connects to these are raced with staggered starts and the first
+/// established connection is kept ("Happy Eyeballs", RFC 8305).
+struct ConnectorAsync
+{
+  /// Create a TCP client socket that connects to given address.
+  /// @param  connectAddress  Peer address to connect to.
+  /// @param  driver  Socket driver to run the socket.
+  /// @param  handleConnect  (Bound) function to call when the connection
+  ///                        is established.
+  /// @param  handleError  (Bound) function to call when the connection
+  ///                      failed or the timeout was exceeded.
+  /// @param  timeout  Timeout to use for all attempts combined;
+  ///                  a negative value leaves the timeout to the OS.
+  /// @throws  If an invalid handler is provided or connect fails immediately.
+  /// @note  Each connector reports exactly one of connect or error.
+  ///        Destroying the connector beforehand cancels the connect.
+  ConnectorAsync(Address const &connectAddress,
+                 Driver &driver,
+                 ConnectHandler handleConnect,
+                 ConnectErrorHandler handleError,
+                 Duration timeout = Duration(-1));
+
+#ifdef SOCKPUPPET_WITH_TLS
+  /// Create a TLS-enabled TCP client socket that connects to given address.
+  /// @param  connectAddress  Peer address to connect to.
+  /// @param  driver  Socket driver to run the socket.
+  /// @param  handleConnect  (Bound) function to call when the connection
+  ///                        is established.
+  /// @param  handleError  (Bound) function to call when the connection
+  ///                      failed or the timeout was exceeded.
+  /// @param  timeout  Timeout to use for all attempts combined;
+  ///                  a negative value leaves the timeout to the OS.
+  /// @param  certFilePath  Path to certificate file in PEM format
+  /// @param  keyFilePath  Path to private key file in PEM format.
+  /// @throws  If an invalid handler is provided, loading certificate/key
+  ///          or connect fails immediately.
+  /// @note  While the TCP connection is established by the driver,
+  ///        the TLS handshake is performed later with subsequent
+  ///        send/receive operations.
+  ConnectorAsync(Address const &connectAddress,
+                 Driver &driver,
+                 ConnectHandler handleConnect,
+                 ConnectErrorHandler handleError,
+                 Duration timeout,
+                 char const *certFilePath,
+                 char const *keyFilePath);
+#endif // SOCKPUPPET_WITH_TLS
+
+  ConnectorAsync(ConnectorAsync const &other) = delete;
+  ConnectorAsync(ConnectorAsync &&other) noexcept;
+  ~ConnectorAsync();
+  ConnectorAsync &operator=(ConnectorAsync const &other) = delete;
+  ConnectorAsync &operator=(ConnectorAsync &&other) noexcept;
+
+  /// Bridge to hide away the OS-specifics.
+  std::unique_ptr<ConnectorAsyncImpl> impl;
+};
+
+/// TCP (reliable communication) connection borrowed from a \ref ConnectionPool
+/// for exclusive use. Received data and disconnect are reported to the
+/// handlers given on acquire while the lease is held.
+/// @note  Destroying the lease returns the connection to the pool for reuse;
+///        only release it after the request/response exchange is complete
+///        as data received while idle invalidates the connection.
+struct SocketTcpLease
+{
+  /// Enqueue data to reliably send to connected peer.
+  /// @param  buffer  Borrowed buffer to enqueue for send and release after completition.
+  ///                 Create using your own BufferPool.
+  /// @return  Future object to fulfill when data was actually sent.
+  std::future<void> Send(BufferPtr &&buffer);
+
+  /// Get the local (bound-to) address of the socket.
+  /// @throws  If the address lookup fails.
+  Address LocalAddress() const;
+
+  /// Get the remote peer address of the socket.
+  /// @throws  If the address lookup fails.
+  Address PeerAddress() const;
+
+  /// Close the connection on lease destruction instead of returning it
+  /// to the pool, e.g. if the peer did not respond as expected.
+  void Discard();
+
+  SocketTcpLease(std::unique_ptr<LeaseImpl> &&other);
+  SocketTcpLease(SocketTcpLease const &other) = delete;
+  SocketTcpLease(SocketTcpLease &&other) noexcept;
+  ~SocketTcpLease();
+  SocketTcpLease &operator=(SocketTcpLease const &other) = delete;
+  SocketTcpLease &operator=(SocketTcpLease &&other) noexcept;
+
+  /// Bridge to implementation instance shared with the pool.
+  std::unique_ptr<LeaseImpl> impl;
+};
+
+/// Callback for TCP connections borrowed from a \ref ConnectionPool.
+/// @param  Connection leased for exclusive use until destroyed.
+using LeaseHandler = std::function<void(SocketTcpLease)>;
+
+/// Pool of outgoing TCP (reliable communication) connections keyed by
+/// peer address. Established connections are kept for reuse after their
+/// lease has been released and closed if unused for a given time.
+/// Idle connections are watched by the socket driver so connections
+/// closed by the peer are never handed out.
+struct ConnectionPool
+{
+  /// Create a pool of TCP client connections.
+  /// @param  driver  Socket driver to run the connections.
+  /// @param  maxPerHost  Maximum number of concurrent connections
+  ///                     per peer address; 0 for unlimited.
+  /// @param  idleTimeout  Time after which an unused connection is closed;
+  ///                      a negative value keeps idle connections open.
+  /// @param  connectTimeout  Timeout to use when connecting; a negative
+  ///                         value leaves the timeout to the OS.
+  ConnectionPool(Driver &driver,
+                 size_t maxPerHost = 0U,
+                 Duration idleTimeout = std::chrono::seconds(60),
+                 Duration connectTimeout = Duration(-1));
+
+#ifdef SOCKPUPPET_WITH_TLS
+  /// Create a pool of TLS-enabled TCP client connections.
+  /// @param  driver  Socket driver to run the connections.
+  /// @param  maxPerHost  Maximum number of concurrent connections
+  ///                     per peer address; 0 for unlimited.
+  /// @param  idleTimeout  Time after which an unused connection is closed;
+  ///                      a negative value keeps idle connections open.
+  /// @param  connectTimeout  Timeout to use when connecting; a negative
+  ///                         value leaves the timeout to the OS.
+  /// @param  certFilePath  Path to certificate file in PEM format
+  /// @param  keyFilePath  Path to private key file in PEM format.
+  ConnectionPool(Driver &driver,
+                 size_t maxPerHost,
+                 Duration idleTimeout,
+                 Duration connectTimeout,
+                 char const *certFilePath,
+                 char const *keyFilePath);
+#endif // SOCKPUPPET_WITH_TLS
+
+  /// Borrow a connection to given address, reusing an idle one if available.
+  /// If the per-host limit is reached, the request is queued until
+  /// another lease to the same address is released.
+  /// @param  connectAddress  Peer address to connect to.
+  /// @param  handleReceive  (Bound) function to call on receipt from
+  ///                        connected peer while leased.
+  /// @param  handleDisconnect  (Bound) function to call when the connection
+  ///                           was lost while leased.
+  /// @param  handleLease  (Bound) function to call with the leased connection.
+  /// @param  handleError  (Bound) function to call when connecting failed.
+  /// @throws  If an invalid handler is provided.
+  /// @note  Each request reports exactly one of lease or error,
+  ///        both in the thread context of the driver.
+  void Acquire(Address const &connectAddress,
+               ReceiveHandler handleReceive,
+               DisconnectHandler handleDisconnect,
+               LeaseHandler handleLease,
+               ConnectErrorHandler handleError);
+
+  ConnectionPool(ConnectionPool const &other) = delete;
+  ConnectionPool(ConnectionPool &&other) noexcept;
+  ~ConnectionPool();
+  ConnectionPool &operator=(ConnectionPool const &other) = delete;
+  ConnectionPool &operator=(ConnectionPool &&other) noexcept;
+
+  /// Bridge to implementation instance shared with the leases.
+  std::shared_ptr<ConnectionPoolImpl> impl;
+};
+
+/// Relay that forwards data in both directions between two connected
+/// TCP sockets run by a socket driver, without passing it to any handler.
+/// Data is moved within the OS (splice through a pipe) where supported and
+/// through one reused buffer per direction otherwise. Receipt from a side
+/// pauses while the opposite side does not take any more data.
+/// The end of stream from one side is passed on as a half-close.
+struct RelayAsync
+{
+  /// Create a relay between two connected TCP sockets.
+  /// @param  first  TCP socket to relay from and to.
+  /// @param  second  TCP socket to relay to and from.
+  /// @param  driver  Socket driver to run the relay.
+  /// @param  handleDisconnect  (Bound) function to call when the relay has
+  ///                           ended, i.e. when both sides have finished sending
+  ///                           or on the first error; reports the peer address
+  ///                           of the side that finished first or failed.
+  /// @param  bufferSize  Amount of data to hold per direction before
+  ///                     pausing receipt; may be adjusted by the OS.
+  /// @throws  If an invalid handler or buffer size is provided,
+  ///          a socket is TLS-encrypted or setting up a pipe fails.
+  RelayAsync(SocketTcp &&first,
+             SocketTcp &&second,
+             Driver &driver,
+             DisconnectHandler handleDisconnect,
+             size_t bufferSize = 65536U);
+
+  /// Get the amount of data forwarded from the first to the second socket.
+  size_t ForwardedToSecond() const;
+
+  /// Get the amount of data forwarded from the second to the first socket.
+  size_t ForwardedToFirst() const;
+
+  RelayAsync(RelayAsync const &other) = delete;
+  RelayAsync(RelayAsync &&other) noexcept;
+  ~RelayAsync();
+  RelayAsync &operator=(RelayAsync const &other) = delete;
+  RelayAsync &operator=(RelayAsync &&other) noexcept;
+
+  /// Bridge to hide away the OS-specifics.
+  std::unique_ptr<RelayImpl> impl;
+};
+
 // compatibility with legacy names
 using SocketTcpAsyncClient [[deprecated]] = SocketTcpAsync;
 using SocketTcpAsyncServer [[deprecated]] = AcceptorAsync;
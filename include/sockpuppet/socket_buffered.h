@@ -5,21 +5,41 @@
 #include "sockpuppet/socket.h" // for Duration
 
 #include <cstddef> // for size_t
-#include <deque> // for std::deque
 #include <memory> // for std::unique_ptr
-#include <mutex> // for std::mutex
 #include <optional> // for std::optional
-#include <stack> // for std::stack
 #include <string> // for std::string
+#include <string_view> // for std::string_view
 #include <utility> // for std::pair
+#include <vector> // for std::vector
 
 namespace sockpuppet {
 
+struct BufferShare;
+struct SharedBufferPoolImpl;
+
+/// Snapshot of the buffer usage of a pool, e.g. to right-size it
+/// or to detect buffers that are never released.
+struct BufferPoolStats
+{
+  size_t idle = 0U; ///< Buffers ready to be obtained.
+  size_t busy = 0U; ///< Buffers obtained and not released yet.
+  size_t highWater = 0U; ///< Maximum number of busy buffers so far.
+  size_t allocations = 0U; ///< Buffers allocated so far; kept until the pool is destroyed.
+  size_t exhaustions = 0U; ///< Requests refused (or receipts deferred) for lack of buffers.
+  size_t reservedSize = 0U; ///< Total capacity of all buffers as of their last release.
+
+  /// Add the figures of another pool, e.g. to sum up the pools of many sockets.
+  BufferPoolStats &operator+=(BufferPoolStats const &other);
+};
+
 /// Send/Receive buffer resource storage.
-/// Internally stores two buffer lists; busy and idle.
-/// Idle buffers may be obtained by the user and
-/// are moved to the busy list. Once released,
-/// it is automatically moved back again.
+/// Buffers of each size class live in arrays that grow in segments of
+/// doubling size and are freed only with the pool; idle ones are kept
+/// on a lock-free stack, from which they are popped when obtained and
+/// onto which they are pushed back when released.
+/// @note  A class holds up to 2^32 - 1 buffers. While \ref Localize takes
+///        the idle buffers off the stack, Get() on a limited pool throws
+///        as if all of its buffers were busy.
 struct BufferPool
 {
   using Buffer = std::string;
@@ -32,18 +52,54 @@ struct BufferPool
   using BufferPtr = std::unique_ptr<Buffer, Recycler>;
 
   /// Create a pool with given maximum number of buffers.
+  /// Obtaining and releasing buffers is lock-free and takes constant
+  /// time, so buffers may be released from any thread without contention;
+  /// only allocating an additional buffer takes a lock.
   /// @param  maxCount  Maximum number of buffers to maintain (0 -> unlimited) and pre-allocate.
   /// @param  reserveSize  Size to pre-allocate each buffer with if \p maxCount is given.
   BufferPool(size_t maxCount = 0U,
              size_t reserveSize = 0U);
 
-  /// Obtain an idle buffer.
+  /// Create a pool of buffers in several size classes, e.g. to send
+  /// messages of varying size without growing buffers on the fly.
+  /// Buffers of a class are allocated together in contiguous arrays
+  /// and keep their capacity while idle.
+  /// @param  classSizes  Size to pre-allocate the buffers of each class with, ascending.
+  /// @param  maxCount  Maximum number of buffers per class to maintain (0 -> unlimited)
+  ///                   and pre-allocate.
+  /// @throws  If no classes or classes out of order are given.
+  BufferPool(std::vector<size_t> const &classSizes,
+             size_t maxCount = 0U);
+
+  /// Obtain an idle buffer (of the smallest class).
   /// @return  Pointer to borrowed buffer still owned by
   ///          the pool; the user must not change the pointer.
   /// @throws  If more buffers are obtained than initially agreed upon.
   /// @note  Mind that all buffers must be released before destroying the pool.
   BufferPtr Get();
 
+  /// Obtain an idle buffer of the smallest class that fits a given size.
+  /// @param  size  Size the buffer is to hold; the largest class is used
+  ///               if it does not fit any class.
+  /// @return  Pointer to borrowed buffer still owned by
+  ///          the pool; the user must not change the pointer.
+  /// @throws  If more buffers of the class are obtained than initially agreed upon.
+  /// @note  Mind that all buffers must be released before destroying the pool.
+  BufferPtr Get(size_t size);
+
+  /// Get a snapshot of the buffer usage, summed up over all size classes.
+  /// Counting is cheap enough to be always on; figures obtained
+  /// while the pool is in use may be slightly out of sync.
+  BufferPoolStats Stats() const;
+
+  /// Reallocate and fill all idle buffers by the calling thread.
+  /// The OS places memory on the NUMA node of the thread touching it first,
+  /// so this moves buffers preallocated by another thread next to the
+  /// thread that fills them; busy buffers are left as they are.
+  /// @note  Idle buffers are unavailable meanwhile, so a limited pool
+  ///        may refuse a concurrent Get().
+  void Localize();
+
   BufferPool(BufferPool const &other) = delete;
   BufferPool(BufferPool &&other) = delete;
   ~BufferPool();
@@ -51,34 +107,103 @@ struct BufferPool
   BufferPool &operator=(BufferPool &&other) = delete;
 
 private:
+  struct Node;
+  struct SizeClass;
+
+  friend struct SharedBufferPoolImpl;
+  friend struct SocketBufferedImpl;
+  // obtain an idle receive buffer accounted to a socket sharing the pool
+  BufferPtr Get(BufferShare &share);
+  // obtain an idle buffer (of the smallest class) without clearing it
+  BufferPtr GetForReceipt();
+
+  BufferPtr Get(SizeClass &sizeClass);
   void Recycle(Buffer *buf);
 
 private:
-  size_t m_maxCount;
-  std::mutex m_mtx;
-  std::stack<std::unique_ptr<Buffer>> m_idle;
-  std::deque<std::unique_ptr<Buffer>> m_busy;
+  std::unique_ptr<SizeClass[]> m_classes; // ascending by size
+  size_t m_classCount;
 };
 
 struct SocketBufferedImpl;
 using BufferPtr = BufferPool::BufferPtr;
 
+/// Immutable buffer with several owners, e.g. a message enqueued for send
+/// on many sockets at once; returned to its pool once the last owner
+/// has released it. Create by moving a BufferPtr into it.
+using SharedBufferPtr = std::shared_ptr<BufferPool::Buffer const>;
+
+/// Receive buffer storage shared by many buffered sockets that bounds
+/// the memory held by all of them together, e.g. on a busy gateway.
+/// Each socket may hold an equal share of the budget (but at least one
+/// buffer) at once. A socket out of buffers does not fail but defers
+/// reading until a buffer it may obtain is released; async sockets stop
+/// polling for receipt meanwhile, while blocking receipt waits for a
+/// buffer within its timeout.
+struct SharedBufferPool
+{
+  /// Create a pool to construct buffered sockets with.
+  /// Buffers are allocated as needed and reused afterwards.
+  /// @param  budget  Maximum total size of the receive buffers of all sockets.
+  /// @param  bufferSize  Size of each receive buffer; the maximum receive size.
+  /// @throws  If the budget does not cover a single buffer.
+  SharedBufferPool(size_t budget,
+                   size_t bufferSize);
+
+  /// Get a snapshot of the buffer usage of all sockets together;
+  /// exhaustions count the receipts deferred.
+  BufferPoolStats Stats() const;
+
+  SharedBufferPool(SharedBufferPool const &other) = delete;
+  SharedBufferPool(SharedBufferPool &&other) noexcept;
+  ~SharedBufferPool();
+  SharedBufferPool &operator=(SharedBufferPool const &other) = delete;
+  SharedBufferPool &operator=(SharedBufferPool &&other) noexcept;
+
+  /// Bridge to implementation instance shared with the sockets.
+  /// @note  Mind that all buffers must be released before
+  ///        the pool and all of its sockets are destroyed.
+  std::shared_ptr<SharedBufferPoolImpl> impl;
+};
+
+/// Strategy of buffered sockets to size their receive buffers.
+enum class ReceiveSizing
+{
+  /// Every receipt uses a buffer of the configured receive size.
+  Fixed,
+
+  /// Every receipt uses a buffer sized to the data pending at the socket,
+  /// drawn from pools of power-of-two size classes up to the configured
+  /// receive size. Where the pending size is unknown, the class fitting
+  /// most recent receipts is used. Buffers are not pre-allocated.
+  Adaptive
+};
+
 /// UDP (unreliable communication) socket class that adds an internal
 /// receive buffer pool to the regular UDP socket class.
 struct SocketUdpBuffered
 {
   /// Create a UDP socket with additional internal buffer pool.
   /// @param  sock  UDP socket to augment.
-  /// @param  rxBufCount  Number of receive buffers to maintain (0 -> unlimited) and pre-allocate.
+  /// @param  rxBufCount  Number of receive buffers to maintain (0 -> unlimited) and pre-allocate
+  ///                     (per size class with adaptive \p sizing).
   ///                     Do not keep hold of more than this number of receive buffers!
   /// @param  rxBufSize  Maximum receive size available in buffers returned from ReceiveFrom().
   ///                    Buffers are pre-allocated if \p rxBufCount is given.
   ///                    (0 -> use OS-determined maximum receive size.
   ///                     Careful! This might be outrageously more than what is actually needed.)
+  /// @param  sizing  Whether to use \p rxBufSize for every receipt or only as upper limit.
   /// @throws  If determining the receive buffer size fails.
   SocketUdpBuffered(SocketUdp &&sock,
                     size_t rxBufCount = 0U,
-                    size_t rxBufSize = 0U);
+                    size_t rxBufSize = 0U,
+                    ReceiveSizing sizing = ReceiveSizing::Fixed);
+
+  /// Create a UDP socket receiving into buffers of a shared pool.
+  /// @param  sock  UDP socket to augment.
+  /// @param  pool  Pool to draw receive buffers from, within the share of this socket.
+  SocketUdpBuffered(SocketUdp &&sock,
+                    SharedBufferPool &pool);
 
   /// Unreliably send data to address.
   /// @param  data  Pointer to data to send.
@@ -101,9 +226,14 @@ struct SocketUdpBuffered
   ///          Zero-size receipt is valid in UDP (header-only packet).
   ///          May return nullopt only if limited \p timeout is specified.
   /// @throws  If receipt fails locally or number of receive buffers is exceeded.
+  /// @note  With a shared pool, waits for a buffer within \p timeout as well.
   std::optional<std::pair<BufferPtr, Address>>
   ReceiveFrom(Duration timeout = Duration(-1));
 
+  /// Get a snapshot of the usage of the receive buffers (of all size
+  /// classes, or of all sockets sharing the pool).
+  BufferPoolStats ReceiveBufferStats() const;
+
   /// Get the local (bound-to) address of the socket.
   /// @throws  If the address lookup fails.
   Address LocalAddress() const;
@@ -124,16 +254,25 @@ struct SocketTcpBuffered
 {
   /// Create a TCP socket with additional internal buffer pool.
   /// @param  sock  TCP client socket to augment.
-  /// @param  rxBufCount  Number of receive buffers to maintain (0 -> unlimited) and pre-allocate.
+  /// @param  rxBufCount  Number of receive buffers to maintain (0 -> unlimited) and pre-allocate
+  ///                     (per size class with adaptive \p sizing).
   ///                     Do not keep hold of more than this number of receive buffers!
   /// @param  rxBufSize  Maximum receive size available in buffers returned from Receive().
   ///                    Buffers are pre-allocated if \p rxBufCount is given.
   ///                    (0 -> use OS-determined maximum receive size.
   ///                     Careful! This might be outrageously more than what is actually needed.)
+  /// @param  sizing  Whether to use \p rxBufSize for every receipt or only as upper limit.
   /// @throws  If determining the receive buffer size fails.
   SocketTcpBuffered(SocketTcp &&sock,
                     size_t rxBufCount = 0U,
-                    size_t rxBufSize = 0U);
+                    size_t rxBufSize = 0U,
+                    ReceiveSizing sizing = ReceiveSizing::Fixed);
+
+  /// Create a TCP socket receiving into buffers of a shared pool.
+  /// @param  sock  TCP client socket to augment.
+  /// @param  pool  Pool to draw receive buffers from, within the share of this socket.
+  SocketTcpBuffered(SocketTcp &&sock,
+                    SharedBufferPool &pool);
 
   /// Reliably send data to connected peer.
   /// @param  data  Pointer to data to send.
@@ -153,8 +292,34 @@ struct SocketTcpBuffered
   ///          happen in TCP. May return nullopt only if limited \p timeout is specified.
   /// @throws  If the number of receive buffers is exceeded, receipt fails or
   ///          the peer closes the connection.
+  /// @note  With a shared pool, waits for a buffer within \p timeout as well.
   std::optional<BufferPtr> Receive(Duration timeout = Duration(-1));
 
+  /// Switch to receive into a ring buffer owned by the connection instead
+  /// of pool buffers; received data accumulates until it is consumed, which
+  /// suits protocols whose messages may be split across receipts.
+  /// @param  capacity  Maximum amount of unconsumed data; may be rounded up
+  ///                   to whole memory pages.
+  /// @throws  If the capacity is zero, setting up the ring fails or
+  ///          a previous ring still holds unconsumed data.
+  /// @note  Use ReceiveView() and Consume() instead of Receive() afterwards.
+  void EnableReceiveRing(size_t capacity);
+
+  /// Reliably receive data from connected peer into the receive ring.
+  /// @param  timeout  Timeout to use; non-null causes blocking receipt,
+  ///                  a negative value allows unlimited blocking.
+  /// @return  View of all unconsumed data in the receive ring, valid until the
+  ///          next receipt or consumption. May return nullopt only if limited
+  ///          \p timeout is specified.
+  /// @throws  If the receive ring is not enabled or full, receipt fails or
+  ///          the peer closes the connection.
+  std::optional<std::string_view> ReceiveView(Duration timeout = Duration(-1));
+
+  /// Release processed data from the front of the receive ring.
+  /// @param  size  Number of bytes to release from the front of the last view.
+  /// @throws  If the receive ring is not enabled or holds less data.
+  void Consume(size_t size);
+
   /// Get the local (bound-to) address of the socket.
   /// @throws  If the address lookup fails.
   Address LocalAddress() const;
@@ -163,6 +328,19 @@ struct SocketTcpBuffered
   /// @throws  If the address lookup fails.
   Address PeerAddress() const;
 
+  /// Apply TCP transport options to the connection.
+  /// @param  options  Options to set; unset options are left untouched.
+  /// @throws  If setting an option fails or is not supported by the OS.
+  void SetOptions(TcpOptions const &options);
+
+  /// Get a snapshot of the transport state of the connection.
+  /// @throws  If the lookup fails or is not supported by the OS.
+  TcpInfo Info() const;
+
+  /// Get a snapshot of the usage of the receive buffers (of all size
+  /// classes, or of all sockets sharing the pool).
+  BufferPoolStats ReceiveBufferStats() const;
+
   SocketTcpBuffered(SocketTcpBuffered const &other) = delete;
   SocketTcpBuffered(SocketTcpBuffered &&other) noexcept;
   ~SocketTcpBuffered();
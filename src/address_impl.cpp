@@ -1,6 +1,7 @@
 #include "address_impl.h"
 #include "error_code.h" // for AddressError
 
+#include <algorithm> // for std::find
 #include <cstring> // for std::memcmp
 #include <limits> // for std::numeric_limits
 #include <regex> // for std::regex
@@ -290,6 +291,28 @@ SockAddrView SockAddrInfo::ForAny() const
   };
 }
 
+std::vector<SockAddrView> SockAddrInfo::ForTcpCandidates() const
+{
+  // all distinct TCP-capable addresses in the order given by getaddrinfo
+  std::vector<SockAddrView> ret;
+  for(auto it = info.get(); it != nullptr; it = it->ai_next) {
+    if((it->ai_socktype == 0 || it->ai_socktype == SOCK_STREAM) &&
+       (it->ai_protocol == 0 || it->ai_protocol == IPPROTO_TCP)) {
+      auto view = SockAddrView{
+        it->ai_addr
+      , static_cast<socklen_t>(it->ai_addrlen)
+      };
+      if(std::find(begin(ret), end(ret), view) == end(ret)) {
+        ret.push_back(view);
+      }
+    }
+  }
+  if(ret.empty()) {
+    throw std::logic_error("address is not valid for TCP");
+  }
+  return ret;
+}
+
 int SockAddrInfo::Family() const
 {
   // return the family of the first resolved addrinfo
@@ -344,6 +367,11 @@ SockAddrView SockAddrStorage::ForAny() const
   };
 }
 
+std::vector<SockAddrView> SockAddrStorage::ForTcpCandidates() const
+{
+  return {ForAny()};
+}
+
 int SockAddrStorage::Family() const
 {
   return storage.ss_family;
@@ -38,6 +38,7 @@ struct Address::AddressImpl
   virtual SockAddrView ForTcp() const = 0;
   virtual SockAddrView ForUdp() const = 0;
   virtual SockAddrView ForAny() const = 0;
+  virtual std::vector<SockAddrView> ForTcpCandidates() const = 0;
   virtual int Family() const = 0;
 
   std::string Host() const;
@@ -72,6 +73,7 @@ struct SockAddrInfo : public Address::AddressImpl
   SockAddrView ForTcp() const override;
   SockAddrView ForUdp() const override;
   SockAddrView ForAny() const override;
+  std::vector<SockAddrView> ForTcpCandidates() const override;
   int Family() const override;
 };
 
@@ -90,6 +92,7 @@ struct SockAddrStorage : public Address::AddressImpl
   SockAddrView ForTcp() const override;
   SockAddrView ForUdp() const override;
   SockAddrView ForAny() const override;
+  std::vector<SockAddrView> ForTcpCandidates() const override;
   int Family() const override;
 };
 
@@ -0,0 +1,154 @@
+#include "byte_scan.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+# define SOCKPUPPET_SSE2
+# if defined(__GNUC__)
+#  define SOCKPUPPET_AVX2 // the compiler allows for per-function target ISAs
+# endif // defined(__GNUC__)
+# include <immintrin.h> // for _mm_cmpeq_epi8
+# ifdef _MSC_VER
+#  include <intrin.h> // for _BitScanForward
+# endif // _MSC_VER
+#endif // defined(__x86_64__) || defined(_M_X64)
+
+#include <cstdint> // for uint32_t
+#include <cstring> // for std::memchr
+
+namespace sockpuppet {
+
+namespace {
+
+using FindAllFn = void (*)(char const *, size_t, char, std::vector<size_t> &);
+
+void FindAllScalar(char const *data, size_t size, char byte,
+                   std::vector<size_t> &offsets, size_t base = 0U)
+{
+  auto const end = data + size;
+  for(auto p = data; p < end; ++p) {
+    p = static_cast<char const *>(std::memchr(p, byte, static_cast<size_t>(end - p)));
+    if(!p) {
+      break;
+    }
+    offsets.push_back(base + static_cast<size_t>(p - data));
+  }
+}
+
+void FindAllMemchr(char const *data, size_t size, char byte,
+                   std::vector<size_t> &offsets)
+{
+  FindAllScalar(data, size, byte, offsets);
+}
+
+#ifdef SOCKPUPPET_SSE2
+// bytes compared per iteration; sparse matches are skipped a whole stride at a time
+constexpr size_t strideSize = 64U;
+
+inline unsigned int CountTrailingZeros(uint64_t mask)
+{
+#ifdef _MSC_VER
+  unsigned long index;
+  (void)_BitScanForward64(&index, mask);
+  return index;
+#else
+  return static_cast<unsigned int>(__builtin_ctzll(mask));
+#endif // _MSC_VER
+}
+
+// one offset per set bit of the comparison mask of a stride
+inline void AppendMatches(uint64_t mask, size_t strideOffset,
+                          std::vector<size_t> &offsets)
+{
+  while(mask) {
+    offsets.push_back(strideOffset + CountTrailingZeros(mask));
+    mask &= mask - 1U;
+  }
+}
+
+inline uint64_t MatchMask(__m128i block, __m128i needle)
+{
+  return static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(block, needle)));
+}
+
+void FindAllSse2(char const *data, size_t size, char byte,
+                 std::vector<size_t> &offsets)
+{
+  auto const needle = _mm_set1_epi8(byte);
+
+  size_t i = 0U;
+  for(; i + strideSize <= size; i += strideSize) {
+    auto const block = reinterpret_cast<__m128i const *>(data + i);
+    auto mask = MatchMask(_mm_loadu_si128(block), needle) |
+                MatchMask(_mm_loadu_si128(block + 1), needle) << 16U |
+                MatchMask(_mm_loadu_si128(block + 2), needle) << 32U |
+                MatchMask(_mm_loadu_si128(block + 3), needle) << 48U;
+    AppendMatches(mask, i, offsets);
+  }
+  FindAllScalar(data + i, size - i, byte, offsets, i);
+}
+#endif // SOCKPUPPET_SSE2
+
+#ifdef SOCKPUPPET_AVX2
+__attribute__((target("avx2")))
+void FindAllAvx2(char const *data, size_t size, char byte,
+                 std::vector<size_t> &offsets)
+{
+  auto const needle = _mm256_set1_epi8(byte);
+
+  size_t i = 0U;
+  for(; i + strideSize <= size; i += strideSize) {
+    auto const block = reinterpret_cast<__m256i const *>(data + i);
+    auto const low = _mm256_cmpeq_epi8(_mm256_loadu_si256(block), needle);
+    auto const high = _mm256_cmpeq_epi8(_mm256_loadu_si256(block + 1), needle);
+    auto const any = _mm256_or_si256(low, high);
+    if(_mm256_testz_si256(any, any)) {
+      continue;
+    }
+    auto mask = uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(low))) |
+                uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(high))) << 32U;
+    AppendMatches(mask, i, offsets);
+  }
+  FindAllScalar(data + i, size - i, byte, offsets, i);
+}
+#endif // SOCKPUPPET_AVX2
+
+struct Dispatch
+{
+  FindAllFn findAll;
+  char const *isa;
+};
+
+Dispatch const &Selected()
+{
+  static Dispatch const dispatch = []() -> Dispatch {
+#ifdef SOCKPUPPET_AVX2
+    if(__builtin_cpu_supports("avx2")) {
+      return {FindAllAvx2, "AVX2"};
+    }
+#endif // SOCKPUPPET_AVX2
+#ifdef SOCKPUPPET_SSE2
+    return {FindAllSse2, "SSE2"}; // part of every x86-64 CPU
+#else
+    return {FindAllMemchr, "scalar"};
+#endif // SOCKPUPPET_SSE2
+  }();
+  return dispatch;
+}
+
+} // unnamed namespace
+
+void FindAllBytes(std::string_view data, char byte, std::vector<size_t> &offsets)
+{
+  Selected().findAll(data.data(), data.size(), byte, offsets);
+}
+
+void FindAllBytesMemchr(std::string_view data, char byte, std::vector<size_t> &offsets)
+{
+  FindAllMemchr(data.data(), data.size(), byte, offsets);
+}
+
+char const *FindAllBytesIsa()
+{
+  return Selected().isa;
+}
+
+} // namespace sockpuppet
@@ -0,0 +1,22 @@
+#ifndef SOCKPUPPET_BYTE_SCAN_H
+#define SOCKPUPPET_BYTE_SCAN_H
+
+#include <cstddef> // for size_t
+#include <string_view> // for std::string_view
+#include <vector> // for std::vector
+
+namespace sockpuppet {
+
+// appends the offsets of all occurrences of a byte to offsets in one pass
+// using the widest vector instructions the CPU supports (selected at runtime)
+void FindAllBytes(std::string_view data, char byte, std::vector<size_t> &offsets);
+
+// same as FindAllBytes using repeated memchr, for reference
+void FindAllBytesMemchr(std::string_view data, char byte, std::vector<size_t> &offsets);
+
+// name of the instruction set FindAllBytes uses on this CPU
+char const *FindAllBytesIsa();
+
+} // namespace sockpuppet
+
+#endif // SOCKPUPPET_BYTE_SCAN_H
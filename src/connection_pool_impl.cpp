@@ -0,0 +1,348 @@
+#include "connection_pool_impl.h"
+#include "driver_impl.h" // for DriverImpl
+
+#include <algorithm> // for std::find_if
+#include <stdexcept> // for std::logic_error
+#include <string> // for std::string
+
+namespace sockpuppet {
+
+namespace {
+
+// schedule a task to be run by the driver asap
+void Defer(ConnectionPoolImpl::DriverShared &driver, std::function<void()> task)
+{
+  driver->ToDoInsert(std::make_shared<ToDo::ToDoImpl>(
+      driver, std::move(task), Clock::now()));
+}
+
+} // unnamed namespace
+
+ConnectionPoolImpl::Connection::Connection(Address connectAddr)
+  : connectAddr(std::move(connectAddr))
+{
+}
+
+ConnectionPoolImpl::Connection::~Connection()
+{
+  if(evictTodo) {
+    evictTodo->Cancel();
+  }
+}
+
+ConnectionPoolImpl::ConnectionPoolImpl(
+    DriverShared &driver,
+    SocketFactory makeSocket,
+    size_t maxPerHost,
+    Duration idleTimeout,
+    Duration connectTimeout)
+  : driver(driver)
+  , makeSocket(std::move(makeSocket))
+  , maxPerHost(maxPerHost)
+  , idleTimeout(idleTimeout)
+  , connectTimeout(connectTimeout)
+{
+}
+
+ConnectionPoolImpl::~ConnectionPoolImpl()
+{
+  if(auto ptr = driver.lock()) {
+    // cancel pending connects and close idle connections;
+    // leased connections are closed once their lease is destroyed
+    Driver::DriverImpl::PauseGuard lock(*ptr);
+    hosts.clear();
+  }
+}
+
+void ConnectionPoolImpl::Acquire(Address const &connectAddr, LesseeShared lessee)
+{
+  auto ptr = driver.lock();
+  if(!ptr) {
+    throw std::logic_error("driver was destroyed");
+  }
+  Driver::DriverImpl::PauseGuard lock(*ptr);
+
+  auto &&host = hosts[connectAddr];
+  host.waiting.push_back(std::move(lessee));
+  Serve(connectAddr, host);
+}
+
+void ConnectionPoolImpl::Release(ConnectionShared conn, bool reusable)
+{
+  auto ptr = driver.lock();
+  if(!ptr) {
+    return;
+  }
+  Driver::DriverImpl::PauseGuard lock(*ptr);
+
+  if(reusable && (conn->state == Connection::State::Leased)) {
+    Park(std::move(conn));
+  } else {
+    // ignore any further socket events until the connection is closed
+    conn->state = Connection::State::Dead;
+    Remove(*conn);
+  }
+}
+
+void ConnectionPoolImpl::Serve(Address const &connectAddr, Host &host)
+{
+  // waiting lessees are served in order, preferring the most recently
+  // used idle connection and connecting anew while below the limit
+  while(!host.waiting.empty()) {
+    if(!host.idle.empty()) {
+      auto conn = std::move(host.idle.back());
+      host.idle.pop_back();
+      auto lessee = std::move(host.waiting.front());
+      host.waiting.pop_front();
+      Lend(std::move(conn), std::move(lessee));
+    } else if((maxPerHost == 0U) || (host.count < maxPerHost)) {
+      auto lessee = std::move(host.waiting.front());
+      host.waiting.pop_front();
+      Connect(connectAddr, host, std::move(lessee));
+    } else {
+      break;
+    }
+  }
+}
+
+void ConnectionPoolImpl::Lend(ConnectionShared conn, LesseeShared lessee)
+{
+  conn->state = Connection::State::Lending;
+  conn->evictTodo->Cancel();
+
+  // hand over in driver context; the connection may be lost meanwhile
+  if(auto ptr = driver.lock()) {
+    Defer(ptr,
+      [pool = weak_from_this(), conn = std::move(conn), lessee = std::move(lessee)]() {
+        if(auto ptr = pool.lock()) {
+          ptr->DriverOnLend(conn, lessee);
+        }
+      });
+  }
+}
+
+void ConnectionPoolImpl::Connect(Address const &connectAddr, Host &host,
+    LesseeShared lessee)
+{
+  auto ptr = driver.lock();
+  if(!ptr) {
+    return;
+  }
+
+  ++host.count;
+  auto it = host.connectors.emplace(host.connectors.end());
+  try {
+    // the driver is paused, so the connector can't report before being stored
+    *it = std::make_unique<ConnectorAsyncImpl>(
+        ptr,
+        makeSocket,
+        connectAddr.impl,
+        std::bind(&ConnectionPoolImpl::DriverOnConnect,
+                  this,
+                  connectAddr,
+                  it,
+                  lessee,
+                  std::placeholders::_1),
+        std::bind(&ConnectionPoolImpl::DriverOnConnectError,
+                  this,
+                  connectAddr,
+                  it,
+                  lessee,
+                  std::placeholders::_2),
+        connectTimeout);
+  } catch(std::runtime_error const &e) {
+    host.connectors.erase(it);
+    --host.count;
+
+    // report in driver context like any other connect error
+    Defer(ptr,
+      [lessee = std::move(lessee), connectAddr, reason = std::string(e.what())]() {
+        lessee->onError(connectAddr, reason.c_str());
+      });
+  }
+}
+
+ConnectionPoolImpl::ConnectionShared ConnectionPoolImpl::Remove(Connection &conn)
+{
+  auto it = hosts.find(conn.connectAddr);
+  if(it == hosts.end()) {
+    return {};
+  }
+  auto &&[connectAddr, host] = *it;
+
+  // keep the connection alive until bookkeeping is done
+  ConnectionShared keep;
+  auto idleIt = std::find_if(host.idle.begin(), host.idle.end(),
+    [&conn](ConnectionShared const &idle) -> bool {
+      return (idle.get() == &conn);
+    });
+  if(idleIt != host.idle.end()) {
+    keep = std::move(*idleIt);
+    (void)host.idle.erase(idleIt);
+  }
+  --host.count;
+
+  // the freed slot may be used by a waiting lessee
+  Serve(connectAddr, host);
+  if(host.count == 0U) {
+    (void)hosts.erase(it);
+  }
+  return keep;
+}
+
+void ConnectionPoolImpl::Park(ConnectionShared conn)
+{
+  auto &&host = hosts[conn->connectAddr];
+  if(!host.waiting.empty()) {
+    auto lessee = std::move(host.waiting.front());
+    host.waiting.pop_front();
+    Lend(std::move(conn), std::move(lessee));
+    return;
+  }
+
+  // the previous lessee's handlers are kept until the next lease as the
+  // release may be done from within these; they are not called while idle
+  conn->state = Connection::State::Idle;
+  if(idleTimeout.count() >= 0) {
+    conn->evictTodo->Shift(Clock::now() + idleTimeout);
+  }
+  host.idle.push_back(std::move(conn));
+}
+
+void ConnectionPoolImpl::DriverOnConnect(Address connectAddr,
+    Connectors::iterator it, LesseeShared lessee, SocketTcp sock)
+{
+  auto &&host = hosts[connectAddr];
+  host.connectors.erase(it); // the connector has handed over everything
+
+  auto ptr = driver.lock();
+  auto conn = std::make_shared<Connection>(connectAddr);
+  try {
+    conn->evictTodo = std::make_shared<ToDo::ToDoImpl>(
+        ptr,
+        [pool = weak_from_this(), c = conn.get()]() {
+          if(auto ptr = pool.lock()) {
+            ptr->DriverOnEvict(*c);
+          }
+        });
+
+    // the socket forwards to the pool which knows whether it is leased
+    conn->sock = std::make_unique<SocketAsyncImpl>(
+        std::make_unique<SocketBufferedImpl>(std::move(sock.impl), 0U, 0U),
+        ptr,
+        [pool = weak_from_this(), c = conn.get()](BufferPtr buffer) {
+          if(c->state == Connection::State::Leased) {
+            c->onReceive(std::move(buffer));
+            return;
+          }
+
+          // the buffer belongs to the socket's pool, return it beforehand
+          buffer.reset();
+          if(auto ptr = pool.lock()) {
+            ptr->DriverOnDisconnect(*c, c->connectAddr,
+                "unsolicited receipt on idle connection");
+          }
+        },
+        [pool = weak_from_this(), c = conn.get()](Address peerAddr, char const *reason) {
+          if(auto ptr = pool.lock()) {
+            ptr->DriverOnDisconnect(*c, std::move(peerAddr), reason);
+          } else if(c->state == Connection::State::Leased) {
+            c->state = Connection::State::Dead;
+            c->onDisconnect(std::move(peerAddr), reason);
+          }
+        });
+  } catch(std::runtime_error const &e) {
+    --host.count;
+    Serve(connectAddr, host);
+
+    lessee->onError(std::move(connectAddr), e.what());
+    return;
+  }
+
+  conn->state = Connection::State::Lending;
+  DriverOnLend(std::move(conn), std::move(lessee));
+}
+
+void ConnectionPoolImpl::DriverOnConnectError(Address connectAddr,
+    Connectors::iterator it, LesseeShared lessee, char const *reason)
+{
+  auto &&host = hosts[connectAddr];
+  host.connectors.erase(it); // the connector has handed over everything
+  --host.count;
+
+  // the freed slot may be used by a waiting lessee
+  Serve(connectAddr, host);
+  if(host.count == 0U) {
+    (void)hosts.erase(connectAddr);
+  }
+
+  lessee->onError(std::move(connectAddr), reason);
+}
+
+void ConnectionPoolImpl::DriverOnLend(ConnectionShared conn, LesseeShared lessee)
+{
+  if(conn->state == Connection::State::Dead) {
+    // lost before hand-over; let the lessee queue up again in front
+    auto &&host = hosts[conn->connectAddr];
+    host.waiting.push_front(std::move(lessee));
+    Remove(*conn);
+    return;
+  }
+
+  conn->state = Connection::State::Leased;
+  conn->onReceive = lessee->onReceive;
+  conn->onDisconnect = lessee->onDisconnect;
+
+  lessee->onLease(SocketTcpLease(
+      std::make_unique<LeaseImpl>(weak_from_this(), std::move(conn))));
+}
+
+void ConnectionPoolImpl::DriverOnDisconnect(Connection &conn,
+    Address peerAddr, char const *reason)
+{
+  switch(conn.state) {
+  case Connection::State::Idle:
+    conn.state = Connection::State::Dead;
+    if(auto keep = Remove(conn); keep) {
+      // called from within the socket's handlers; close it afterwards
+      if(auto ptr = driver.lock()) {
+        Defer(ptr, [keep = std::move(keep)]() mutable { keep.reset(); });
+      }
+    }
+    break;
+  case Connection::State::Lending:
+    conn.state = Connection::State::Dead; // removed on hand-over
+    break;
+  case Connection::State::Leased:
+    conn.state = Connection::State::Dead; // removed on release
+    conn.onDisconnect(std::move(peerAddr), reason);
+    break;
+  case Connection::State::Dead:
+    break;
+  }
+}
+
+void ConnectionPoolImpl::DriverOnEvict(Connection &conn)
+{
+  if(conn.state == Connection::State::Idle) {
+    conn.state = Connection::State::Dead;
+    Remove(conn);
+  }
+}
+
+
+LeaseImpl::LeaseImpl(std::weak_ptr<ConnectionPoolImpl> pool,
+    ConnectionPoolImpl::ConnectionShared conn)
+  : pool(std::move(pool))
+  , conn(std::move(conn))
+{
+}
+
+LeaseImpl::~LeaseImpl()
+{
+  if(auto ptr = pool.lock()) {
+    ptr->Release(std::move(conn), reusable);
+  }
+}
+
+} // namespace sockpuppet
@@ -0,0 +1,131 @@
+#ifndef SOCKPUPPET_CONNECTION_POOL_IMPL_H
+#define SOCKPUPPET_CONNECTION_POOL_IMPL_H
+
+#include "connector_async_impl.h" // for ConnectorAsyncImpl
+#include "socket_async_impl.h" // for SocketAsyncImpl
+#include "sockpuppet/address.h" // for Address
+#include "sockpuppet/socket_async.h" // for ConnectionPool
+#include "todo_impl.h" // for ToDoShared
+
+#include <cstddef> // for size_t
+#include <deque> // for std::deque
+#include <list> // for std::list
+#include <memory> // for std::shared_ptr
+#include <unordered_map> // for std::unordered_map
+#include <vector> // for std::vector
+
+namespace sockpuppet {
+
+// keeps established connections per peer address for reuse;
+// all state is guarded by the driver's step mutex (using PauseGuard
+// from outside the driver thread) to be consistent with the sockets
+// and ToDos it is made of
+struct ConnectionPoolImpl : public std::enable_shared_from_this<ConnectionPoolImpl>
+{
+  using DriverShared = std::shared_ptr<Driver::DriverImpl>;
+  using SocketFactory = ConnectorAsyncImpl::SocketFactory;
+
+  struct Lessee
+  {
+    ReceiveHandler onReceive;
+    DisconnectHandler onDisconnect;
+    LeaseHandler onLease;
+    ConnectErrorHandler onError;
+  };
+  using LesseeShared = std::shared_ptr<Lessee>;
+
+  struct Connection
+  {
+    enum class State
+    {
+      Idle,
+      Lending, // lease is scheduled for hand-over
+      Leased,
+      Dead
+    };
+
+    Address connectAddr;
+    State state = State::Idle;
+    ReceiveHandler onReceive; // of the lessee while leased
+    DisconnectHandler onDisconnect; // of the lessee while leased
+    ToDoShared evictTodo;
+    std::unique_ptr<SocketAsyncImpl> sock; // destroyed before the handlers above
+
+    Connection(Address connectAddr);
+    Connection(Connection const &) = delete;
+    Connection(Connection &&) = delete;
+    ~Connection();
+    Connection &operator=(Connection const &) = delete;
+    Connection &operator=(Connection &&) = delete;
+  };
+  using ConnectionShared = std::shared_ptr<Connection>;
+  using Connectors = std::list<std::unique_ptr<ConnectorAsyncImpl>>;
+
+  struct Host
+  {
+    size_t count = 0U; // connecting, idle and leased connections
+    std::vector<ConnectionShared> idle; // most recently used last
+    Connectors connectors;
+    std::deque<LesseeShared> waiting;
+  };
+
+  std::weak_ptr<Driver::DriverImpl> driver;
+  SocketFactory makeSocket; // contains use-case-dependent data as bound arguments
+  size_t maxPerHost;
+  Duration idleTimeout;
+  Duration connectTimeout;
+  std::unordered_map<Address, Host> hosts;
+
+  ConnectionPoolImpl(DriverShared &driver,
+                     SocketFactory makeSocket,
+                     size_t maxPerHost,
+                     Duration idleTimeout,
+                     Duration connectTimeout);
+  ConnectionPoolImpl(ConnectionPoolImpl const &) = delete;
+  ConnectionPoolImpl(ConnectionPoolImpl &&) = delete;
+  ~ConnectionPoolImpl();
+  ConnectionPoolImpl &operator=(ConnectionPoolImpl const &) = delete;
+  ConnectionPoolImpl &operator=(ConnectionPoolImpl &&) = delete;
+
+  void Acquire(Address const &connectAddr, LesseeShared lessee);
+  void Release(ConnectionShared conn, bool reusable);
+
+  // with step mutex held
+  void Serve(Address const &connectAddr, Host &host);
+  void Lend(ConnectionShared conn, LesseeShared lessee);
+  void Connect(Address const &connectAddr, Host &host, LesseeShared lessee);
+  ConnectionShared Remove(Connection &conn); // returns the idle connection removed
+  void Park(ConnectionShared conn);
+
+  // in thread context of DriverImpl
+  void DriverOnConnect(Address connectAddr,
+                       Connectors::iterator it,
+                       LesseeShared lessee,
+                       SocketTcp sock);
+  void DriverOnConnectError(Address connectAddr,
+                            Connectors::iterator it,
+                            LesseeShared lessee,
+                            char const *reason);
+  void DriverOnLend(ConnectionShared conn, LesseeShared lessee);
+  void DriverOnDisconnect(Connection &conn, Address peerAddr, char const *reason);
+  void DriverOnEvict(Connection &conn);
+};
+
+struct LeaseImpl
+{
+  std::weak_ptr<ConnectionPoolImpl> pool;
+  ConnectionPoolImpl::ConnectionShared conn;
+  bool reusable = true;
+
+  LeaseImpl(std::weak_ptr<ConnectionPoolImpl> pool,
+            ConnectionPoolImpl::ConnectionShared conn);
+  LeaseImpl(LeaseImpl const &) = delete;
+  LeaseImpl(LeaseImpl &&) = delete;
+  ~LeaseImpl();
+  LeaseImpl &operator=(LeaseImpl const &) = delete;
+  LeaseImpl &operator=(LeaseImpl &&) = delete;
+};
+
+} // namespace sockpuppet
+
+#endif // SOCKPUPPET_CONNECTION_POOL_IMPL_H
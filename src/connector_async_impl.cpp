@@ -0,0 +1,223 @@
+#include "connector_async_impl.h"
+#include "driver_impl.h" // for DriverImpl
+#include "socket_tls_impl.h" // for SocketTlsImpl
+
+#ifdef _WIN32
+# include <winsock2.h> // for IPPROTO_TCP
+#else
+# include <arpa/inet.h> // for IPPROTO_TCP
+#endif // _WIN32
+
+#include <algorithm> // for std::max
+#include <stdexcept> // for std::runtime_error
+
+namespace sockpuppet {
+
+namespace {
+
+// recommended value of RFC 8305 section 8
+constexpr auto connectionAttemptDelay = std::chrono::milliseconds(250);
+
+// alternate address families starting with the
+// one preferred by getaddrinfo (RFC 8305 section 4)
+std::vector<SockAddrView> Interleave(std::vector<SockAddrView> const &candidates)
+{
+  auto const preferredFamily = candidates.front().addr->sa_family;
+
+  std::vector<SockAddrView> preferred;
+  std::vector<SockAddrView> other;
+  for(auto &&candidate : candidates) {
+    if(candidate.addr->sa_family == preferredFamily) {
+      preferred.push_back(candidate);
+    } else {
+      other.push_back(candidate);
+    }
+  }
+
+  std::vector<SockAddrView> ret;
+  ret.reserve(candidates.size());
+  for(size_t i = 0U; i < std::max(preferred.size(), other.size()); ++i) {
+    if(i < preferred.size()) {
+      ret.push_back(preferred[i]);
+    }
+    if(i < other.size()) {
+      ret.push_back(other[i]);
+    }
+  }
+  return ret;
+}
+
+} // unnamed namespace
+
+ConnectorAsyncImpl::ConnectorAsyncImpl(
+    DriverShared &driver,
+    SocketFactory makeSocket,
+    AddressShared connectAddr,
+    ConnectHandler onConnect,
+    ConnectErrorHandler onError,
+    Duration timeout)
+  : driver(driver)
+  , makeSocket(std::move(makeSocket))
+  , connectAddr(std::move(connectAddr))
+  , candidates(Interleave(this->connectAddr->ForTcpCandidates()))
+  , onConnect(std::move(onConnect))
+  , onError(std::move(onError))
+  , staggerTodo(std::make_shared<ToDo::ToDoImpl>(
+      driver,
+      std::bind(&ConnectorAsyncImpl::DriverOnStagger, this)))
+{
+  // keep the driver from running attempts/ToDos before set up is complete
+  Driver::DriverImpl::PauseGuard lock(*driver);
+
+  if(!StartAttempt(driver)) {
+    throw std::runtime_error(lastError);
+  }
+  if(nextCandidate < candidates.size()) {
+    staggerTodo->Shift(Clock::now() + connectionAttemptDelay);
+  }
+
+  if(timeout.count() >= 0) {
+    timeoutTodo = std::make_shared<ToDo::ToDoImpl>(
+        driver,
+        std::bind(&ConnectorAsyncImpl::DriverOnTimeout, this),
+        Clock::now() + timeout);
+    driver->ToDoInsert(timeoutTodo);
+  }
+}
+
+ConnectorAsyncImpl::~ConnectorAsyncImpl()
+{
+  if(auto ptr = driver.lock()) {
+    Driver::DriverImpl::PauseGuard lock(*ptr);
+    DriverFinish();
+  }
+}
+
+ConnectorAsyncImpl::SocketFactory ConnectorAsyncImpl::TcpSocketFactory()
+{
+  return [](int family) -> std::unique_ptr<SocketImpl> {
+    return std::make_unique<SocketImpl>(
+        family, SOCK_STREAM, IPPROTO_TCP);
+  };
+}
+
+#ifdef SOCKPUPPET_WITH_TLS
+ConnectorAsyncImpl::SocketFactory ConnectorAsyncImpl::TlsSocketFactory(
+    char const *certFilePath, char const *keyFilePath)
+{
+  // certificate/key are loaded once for all connections
+  return [context = std::make_shared<TlsContextImpl>(certFilePath, keyFilePath)](
+      int family) -> std::unique_ptr<SocketImpl> {
+    return std::make_unique<SocketTlsImpl>(
+        family, SOCK_STREAM, IPPROTO_TCP,
+        context);
+  };
+}
+#endif // SOCKPUPPET_WITH_TLS
+
+bool ConnectorAsyncImpl::StartAttempt(DriverShared &driver)
+{
+  // skip candidates that fail immediately, e.g. unsupported address family
+  while(nextCandidate < candidates.size()) {
+    auto const candidate = candidates[nextCandidate++];
+    try {
+      auto sock = makeSocket(candidate.addr->sa_family);
+      sock->SetSockOptNoSigPipe();
+      sock->SetSockOptNonBlocking();
+      sock->ConnectNonBlocking(candidate);
+
+      attempts.emplace_back(std::make_unique<SocketAsyncImpl>(
+          std::move(sock),
+          driver,
+          std::make_shared<SockAddrStorage>(candidate.addr, candidate.addrLen),
+          std::bind(&ConnectorAsyncImpl::DriverOnAttemptConnect,
+                    this,
+                    std::placeholders::_1,
+                    std::placeholders::_2),
+          std::bind(&ConnectorAsyncImpl::DriverOnAttemptError,
+                    this,
+                    std::placeholders::_1,
+                    std::placeholders::_2)));
+      ++attemptsPending;
+      return true;
+    } catch(std::runtime_error const &e) {
+      lastError = e.what();
+    }
+  }
+  return false;
+}
+
+void ConnectorAsyncImpl::DriverOnStagger()
+{
+  DriverStartNext();
+}
+
+void ConnectorAsyncImpl::DriverOnTimeout()
+{
+  lastError = "connect timeout exceeded";
+  DriverFail();
+}
+
+void ConnectorAsyncImpl::DriverOnAttemptConnect(SocketTcp sock, Address)
+{
+  // the winning attempt has handed over its socket already
+  DriverFinish();
+
+  // the handler may destroy the connector -> hand over everything beforehand
+  auto handler = std::move(onConnect);
+  auto addr = Address(connectAddr);
+
+  handler(std::move(sock), std::move(addr));
+}
+
+void ConnectorAsyncImpl::DriverOnAttemptError(Address, char const *reason)
+{
+  lastError = reason;
+  --attemptsPending;
+
+  // don't wait for the stagger delay if the previous attempt failed already
+  DriverStartNext();
+}
+
+void ConnectorAsyncImpl::DriverStartNext()
+{
+  if(auto ptr = driver.lock()) {
+    (void)StartAttempt(ptr);
+  }
+
+  if(nextCandidate < candidates.size()) {
+    staggerTodo->Shift(Clock::now() + connectionAttemptDelay);
+  } else {
+    staggerTodo->Cancel();
+  }
+
+  if(attemptsPending == 0U) {
+    DriverFail();
+  }
+}
+
+void ConnectorAsyncImpl::DriverFail()
+{
+  DriverFinish();
+
+  // the handler may destroy the connector -> hand over everything beforehand
+  auto handler = std::move(onError);
+  auto addr = Address(connectAddr);
+  auto reason = std::move(lastError);
+
+  handler(std::move(addr), reason.c_str());
+}
+
+void ConnectorAsyncImpl::DriverFinish()
+{
+  staggerTodo->Cancel();
+  if(timeoutTodo) {
+    timeoutTodo->Cancel();
+  }
+
+  nextCandidate = candidates.size();
+  attemptsPending = 0U;
+  attempts.clear();
+}
+
+} // namespace sockpuppet
@@ -0,0 +1,74 @@
+#ifndef SOCKPUPPET_CONNECTOR_ASYNC_IMPL_H
+#define SOCKPUPPET_CONNECTOR_ASYNC_IMPL_H
+
+#include "address_impl.h" // for SockAddrView
+#include "socket_async_impl.h" // for SocketAsyncImpl
+#include "sockpuppet/address.h" // for Address
+#include "sockpuppet/socket_async.h" // for ConnectorAsync
+#include "todo_impl.h" // for ToDoShared
+
+#include <cstddef> // for size_t
+#include <functional> // for std::function
+#include <memory> // for std::unique_ptr
+#include <string> // for std::string
+#include <vector> // for std::vector
+
+namespace sockpuppet {
+
+// races connects to all candidate addresses of the peer ("Happy Eyeballs", RFC 8305);
+// attempts alternate between address families and are started staggered by
+// a fixed delay or as soon as the previous attempt fails; the first
+// established connection wins and all other attempts are cancelled
+struct ConnectorAsyncImpl
+{
+  using AddressShared = std::shared_ptr<Address::AddressImpl>;
+  using DriverShared = std::shared_ptr<Driver::DriverImpl>;
+  using SocketFactory = std::function<std::unique_ptr<SocketImpl>(int family)>;
+
+  std::weak_ptr<Driver::DriverImpl> driver;
+  SocketFactory makeSocket; // contains use-case-dependent data as bound arguments
+  AddressShared connectAddr;
+  std::vector<SockAddrView> candidates; // views into connectAddr
+  size_t nextCandidate = 0U;
+  std::vector<std::unique_ptr<SocketAsyncImpl>> attempts;
+  size_t attemptsPending = 0U;
+  ConnectHandler onConnect;
+  ConnectErrorHandler onError;
+  ToDoShared staggerTodo;
+  ToDoShared timeoutTodo;
+  std::string lastError;
+
+  ConnectorAsyncImpl(DriverShared &driver,
+                     SocketFactory makeSocket,
+                     AddressShared connectAddr,
+                     ConnectHandler onConnect,
+                     ConnectErrorHandler onError,
+                     Duration timeout);
+  ConnectorAsyncImpl(ConnectorAsyncImpl const &) = delete;
+  ConnectorAsyncImpl(ConnectorAsyncImpl &&) = delete;
+  ~ConnectorAsyncImpl();
+  ConnectorAsyncImpl &operator=(ConnectorAsyncImpl const &) = delete;
+  ConnectorAsyncImpl &operator=(ConnectorAsyncImpl &&) = delete;
+
+  static SocketFactory TcpSocketFactory();
+#ifdef SOCKPUPPET_WITH_TLS
+  static SocketFactory TlsSocketFactory(char const *certFilePath,
+                                        char const *keyFilePath);
+#endif // SOCKPUPPET_WITH_TLS
+
+  /// @return  true if an attempt was started, false if no candidates are left
+  bool StartAttempt(DriverShared &driver);
+
+  // in thread context of DriverImpl
+  void DriverOnStagger();
+  void DriverOnTimeout();
+  void DriverOnAttemptConnect(SocketTcp sock, Address candidateAddr);
+  void DriverOnAttemptError(Address candidateAddr, char const *reason);
+  void DriverStartNext();
+  void DriverFail();
+  void DriverFinish();
+};
+
+} // namespace sockpuppet
+
+#endif // SOCKPUPPET_CONNECTOR_ASYNC_IMPL_H
@@ -1,10 +1,13 @@
 #include "driver_impl.h"
 #include "address_impl.h" // for Address::AddressImpl
+#include "numa.h" // for BindToNumaNode
 #include "socket_async_impl.h" // for SocketAsyncImpl
 #include "wait.h" // for DeadlineLimited
 
 #include <algorithm> // for std::find_if
 #include <cassert> // for assert
+#include <climits> // for INT_MAX
+#include <stdexcept> // for std::runtime_error
 
 namespace sockpuppet {
 
@@ -75,8 +78,9 @@ Driver::DriverImpl::PauseGuard::PauseGuard(DriverImpl &impl)
 Driver::DriverImpl::PauseGuard::~PauseGuard() = default;
 
 
-Driver::DriverImpl::DriverImpl()
-  : pipeToAddr(std::make_shared<SockAddrInfo>(0U))
+Driver::DriverImpl::DriverImpl(std::pmr::memory_resource *resource)
+  : resource(resource)
+  , pipeToAddr(std::make_shared<SockAddrInfo>(0U))
   , pipeFrom(pipeToAddr->Family(), SOCK_DGRAM, IPPROTO_UDP)
   , pipeTo(pipeToAddr->Family(), SOCK_DGRAM, IPPROTO_UDP)
   , pfds(1U, pollfd{pipeTo.fd, POLLIN, 0})
@@ -101,6 +105,8 @@ void Driver::DriverImpl::Step(Duration timeout)
 {
   StepGuard lock(*this);
 
+  UpdateNumaNode();
+
   if(todos.empty()) {
     StepSockets(timeout);
   } else {
@@ -179,6 +185,37 @@ void Driver::DriverImpl::Stop()
   Bump();
 }
 
+std::optional<unsigned int> Driver::DriverImpl::NumaNode() const
+{
+  auto const node = numaNode.load(std::memory_order_relaxed);
+  if(node < 0) {
+    return {std::nullopt};
+  }
+  return {static_cast<unsigned int>(node)};
+}
+
+void Driver::DriverImpl::SetNumaNode(unsigned int node)
+{
+  if(node > INT_MAX) {
+    throw std::runtime_error("unknown NUMA node");
+  }
+  CheckNumaNode(node);
+
+  // bound by the stepping thread itself
+  pendingNode.store(static_cast<int>(node), std::memory_order_relaxed);
+  Bump();
+}
+
+void Driver::DriverImpl::UpdateNumaNode()
+{
+  // an unbound thread may migrate between nodes at any time; its node is
+  // neither queried nor followed by the receive buffers
+  if(auto node = pendingNode.exchange(-1, std::memory_order_relaxed); node >= 0) {
+    BindToNumaNode(static_cast<unsigned int>(node));
+    numaNode.store(node, std::memory_order_relaxed);
+  }
+}
+
 void Driver::DriverImpl::ToDoInsert(ToDoShared todo)
 {
   PauseGuard lock(*this);
@@ -197,12 +234,12 @@ void Driver::DriverImpl::ToDoMove(ToDoShared todo, TimePoint when)
   todos.Move(std::move(todo), when);
 }
 
-void Driver::DriverImpl::AsyncRegister(SocketAsyncImpl &sock)
+void Driver::DriverImpl::AsyncRegister(SocketAsyncImpl &sock, short events)
 {
   PauseGuard lock(*this);
 
   sockets.emplace_back(sock);
-  pfds.emplace_back(pollfd{sock.DriverGetFd(), POLLIN, 0});
+  pfds.emplace_back(pollfd{sock.DriverGetFd(), events, 0});
 }
 
 void Driver::DriverImpl::AsyncUnregister(SOCKET fd)
@@ -227,6 +264,30 @@ void Driver::DriverImpl::AsyncWantSend(SOCKET fd)
   itPfd->events |= POLLOUT;
 }
 
+void Driver::DriverImpl::AsyncWantReceive(SOCKET fd, bool want)
+{
+  PauseGuard lock(*this);
+
+  auto itPfd = std::find_if(begin(pfds), end(pfds), FdEqual{fd});
+  assert(itPfd != end(pfds));
+  if(want) {
+    itPfd->events |= POLLIN;
+  } else {
+    itPfd->events &= ~POLLIN;
+  }
+}
+
+void Driver::DriverImpl::AsyncResumeReceive(SocketAsyncImpl const *sock)
+{
+  PauseGuard lock(*this);
+
+  auto itSock = std::find_if(begin(sockets), end(sockets),
+      [sock](SocketRef const &ref) { return (&ref.get() == sock); });
+  if(itSock != end(sockets)) {
+    pfds[static_cast<size_t>(itSock - begin(sockets)) + 1U].events |= POLLIN;
+  }
+}
+
 void Driver::DriverImpl::Bump()
 {
   static char const one = '1';
@@ -240,7 +301,7 @@ void Driver::DriverImpl::Bump()
 void Driver::DriverImpl::Unbump()
 {
   char dump[256U];
-  (void)pipeTo.ReceiveFrom(dump, sizeof(dump));
+  (void)pipeTo.ReceiveFrom(dump, sizeof(dump), resource);
 }
 
 void Driver::DriverImpl::QuerySockets()
@@ -268,8 +329,11 @@ void Driver::DriverImpl::DoOneSocketTask()
     auto &&sock = sockets[i].get();
     assert(pfd.fd == sock.DriverGetFd());
 
-    if(pfd.revents & POLLIN) {
-      sock.DriverOnReadable();
+    if((pfd.revents & POLLERR) && sock.DriverOnErrorQueue(pfd.events)) {
+      // zero-copy send completions are reported via the socket error queue
+      return;
+    } else if(pfd.revents & POLLIN) {
+      sock.DriverOnReadable(numaNode.load(std::memory_order_relaxed));
       return;
     } else if(pfd.revents & POLLOUT) {
       if(sock.DriverOnWritable()) {
@@ -15,7 +15,9 @@
 #include <atomic> // for std::atomic
 #include <functional> // for std::reference_wrapper
 #include <memory> // for std::shared_ptr
+#include <memory_resource> // for std::pmr::memory_resource
 #include <mutex> // for std::mutex
+#include <optional> // for std::optional
 #include <vector> // for std::vector
 
 namespace sockpuppet {
@@ -53,6 +55,9 @@ struct Driver::DriverImpl
     PauseGuard &operator=(PauseGuard &&) = delete;
   };
 
+  /// Memory of the attached sockets, see Driver::Driver(std::pmr::memory_resource *)
+  std::pmr::memory_resource *resource;
+
   /// Internal signalling pipe for cancelling Step()
   AddressShared pipeToAddr;
   SocketImpl pipeFrom;
@@ -66,8 +71,10 @@ struct Driver::DriverImpl
   std::vector<pollfd> pfds; // front element belongs to internal signalling pipe; guarded by stepMtx
 
   std::atomic<bool> shouldStop; ///< Flag for cancelling Run()
+  std::atomic<int> numaNode{-1}; ///< Node the stepping thread is bound to; negative if unbound
+  std::atomic<int> pendingNode{-1}; ///< Node to bind the next stepping thread to, if any
 
-  DriverImpl();
+  DriverImpl(std::pmr::memory_resource *resource);
   DriverImpl(DriverImpl const &) = delete;
   DriverImpl(DriverImpl &&) = delete;
   ~DriverImpl();
@@ -82,15 +89,23 @@ struct Driver::DriverImpl
   void Run();
   void Stop();
 
+  std::optional<unsigned int> NumaNode() const;
+  void SetNumaNode(unsigned int node);
+  // applies a pending binding and records the node of the stepping thread
+  void UpdateNumaNode();
+
   // interface for ToDoImpl
   void ToDoInsert(ToDoShared todo);
   void ToDoRemove(ToDo::ToDoImpl *todo);
   void ToDoMove(ToDoShared todo, TimePoint when);
 
   // interface for SocketAsyncImpl
-  void AsyncRegister(SocketAsyncImpl &sock);
+  void AsyncRegister(SocketAsyncImpl &sock, short events = POLLIN);
   void AsyncUnregister(SOCKET fd);
   void AsyncWantSend(SOCKET fd);
+  void AsyncWantReceive(SOCKET fd, bool want);
+  // tolerates a socket unregistered meanwhile, as called from any thread
+  void AsyncResumeReceive(SocketAsyncImpl const *sock);
 
   // interactions with signalling pipe
   void Bump();
@@ -0,0 +1,133 @@
+#include "file_impl.h"
+
+#ifdef _WIN32
+# include <fcntl.h> // for _O_RDONLY
+# include <io.h> // for ::_open
+# include <sys/stat.h> // for ::_fstat64
+#else
+# include <fcntl.h> // for ::open
+# include <sys/stat.h> // for ::fstat
+# include <unistd.h> // for ::pread
+#endif // _WIN32
+
+#include <cerrno> // for errno
+#include <stdexcept> // for std::logic_error
+#include <system_error> // for std::system_error
+#include <utility> // for std::swap
+
+namespace sockpuppet {
+
+namespace {
+
+constexpr int fdInvalid = -1;
+
+int OpenReadOnly(char const *path)
+{
+#ifdef _WIN32
+  return ::_open(path, _O_RDONLY | _O_BINARY);
+#else
+  return ::open(path, O_RDONLY | O_CLOEXEC);
+#endif // _WIN32
+}
+
+std::system_error FileError(char const *errorMessage)
+{
+  return std::system_error(errno, std::generic_category(), errorMessage);
+}
+
+} // unnamed namespace
+
+FileDescriptor::FileDescriptor(char const *path)
+  : fd(OpenReadOnly(path))
+  , owned(true)
+{
+  if(fd == fdInvalid) {
+    throw FileError("failed to open file");
+  }
+}
+
+FileDescriptor::FileDescriptor(int fd)
+  : fd(fd)
+  , owned(false)
+{
+  if(fd < 0) {
+    throw std::logic_error("invalid file descriptor");
+  }
+}
+
+FileDescriptor::FileDescriptor(FileDescriptor &&other) noexcept
+  : fd(other.fd)
+  , owned(other.owned)
+{
+  other.fd = fdInvalid;
+  other.owned = false;
+}
+
+FileDescriptor::~FileDescriptor()
+{
+  if(owned && (fd != fdInvalid)) {
+#ifdef _WIN32
+    (void)::_close(fd);
+#else
+    (void)::close(fd);
+#endif // _WIN32
+  }
+}
+
+FileDescriptor &FileDescriptor::operator=(FileDescriptor &&other) noexcept
+{
+  std::swap(fd, other.fd);
+  std::swap(owned, other.owned);
+  return *this;
+}
+
+size_t FileDescriptor::Size() const
+{
+#ifdef _WIN32
+  struct _stat64 st;
+  if(::_fstat64(fd, &st)) {
+#else
+  struct stat st;
+  if(::fstat(fd, &st)) {
+#endif // _WIN32
+    throw FileError("failed to get file size");
+  }
+  return static_cast<size_t>(st.st_size);
+}
+
+size_t FileDescriptor::ReadAt(char *data, size_t size, size_t offset) const
+{
+#ifdef _WIN32
+  // the CRT has no positional read
+  if(::_lseeki64(fd, static_cast<__int64>(offset), SEEK_SET) < 0) {
+    throw FileError("failed to seek in file");
+  }
+  auto res = ::_read(fd, data, static_cast<unsigned int>(size));
+#else
+  auto res = ::pread(fd, data, size, static_cast<off_t>(offset));
+#endif // _WIN32
+  if(res < 0) {
+    throw FileError("failed to read file");
+  } else if((res == 0) && (size > 0U)) {
+    throw std::runtime_error("unexpected end of file");
+  }
+  return static_cast<size_t>(res);
+}
+
+FileSlice::FileSlice(FileDescriptor &&file,
+    size_t offset, std::optional<size_t> size)
+  : file(std::move(file))
+  , offset(offset)
+  , size(0U)
+{
+  auto const fileSize = this->file.Size();
+  if(offset > fileSize) {
+    throw std::logic_error("file offset exceeds file size");
+  }
+  this->size = size.value_or(fileSize - offset);
+  if(this->size > fileSize - offset) {
+    throw std::logic_error("file region exceeds file size");
+  }
+}
+
+} // namespace sockpuppet
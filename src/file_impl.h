@@ -0,0 +1,44 @@
+#ifndef SOCKPUPPET_FILE_IMPL_H
+#define SOCKPUPPET_FILE_IMPL_H
+
+#include <cstddef> // for size_t
+#include <optional> // for std::optional
+
+namespace sockpuppet {
+
+// file descriptor that is either owned (opened from path and closed
+// on destruction) or borrowed from the user
+struct FileDescriptor
+{
+  int fd;
+  bool owned;
+
+  FileDescriptor(char const *path);
+  FileDescriptor(int fd);
+  FileDescriptor(FileDescriptor const &) = delete;
+  FileDescriptor(FileDescriptor &&other) noexcept;
+  ~FileDescriptor();
+  FileDescriptor &operator=(FileDescriptor const &) = delete;
+  FileDescriptor &operator=(FileDescriptor &&other) noexcept;
+
+  size_t Size() const;
+
+  // reads up to size bytes at offset without moving the file position
+  size_t ReadAt(char *data, size_t size, size_t offset) const;
+};
+
+// remainder of a file region still to be sent
+struct FileSlice
+{
+  FileDescriptor file;
+  size_t offset;
+  size_t size;
+
+  FileSlice(FileDescriptor &&file,
+            size_t offset,
+            std::optional<size_t> size);
+};
+
+} // namespace sockpuppet
+
+#endif // SOCKPUPPET_FILE_IMPL_H
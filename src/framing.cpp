@@ -0,0 +1,192 @@
+#include "sockpuppet/socket_async.h"
+#include "byte_scan.h" // for FindAllBytes
+
+#include <algorithm> // for std::min
+#include <cstdint> // for uint64_t
+#include <memory> // for std::shared_ptr
+#include <optional> // for std::optional
+#include <stdexcept> // for std::logic_error
+#include <utility> // for std::pair
+#include <vector> // for std::vector
+
+namespace sockpuppet {
+
+namespace {
+
+// message view and the number of bytes it occupies including its framing
+using Split = std::optional<std::pair<std::string_view, size_t>>;
+
+struct ReceiverState
+{
+  Framing framing;
+  MessageHandler handleMessage;
+  size_t scanned = 0U; // bytes of the pending message known to hold no delimiter
+  std::vector<size_t> candidates = {}; // scratch space for delimiter scans
+  bool delivering = false;
+  bool stopped = false; // the receiver has been destroyed while delivering
+};
+
+Split SplitPrefixed(Framing const &framing, std::string_view data)
+{
+  auto const width = framing.prefixWidth;
+  if(data.size() < width) {
+    return std::nullopt;
+  }
+
+  uint64_t size = 0U;
+  for(size_t i = 0U; i < width; ++i) {
+    auto const byte = data[framing.bigEndian ? i : width - 1U - i];
+    size = (size << 8U) | static_cast<unsigned char>(byte);
+  }
+  if(size > framing.maxSize) {
+    throw std::runtime_error("message too large");
+  }
+
+  if(data.size() - width < size) {
+    return std::nullopt;
+  }
+  return {{data.substr(width, size), width + size}};
+}
+
+size_t DeliverPrefixed(ReceiverState &state, std::string_view view)
+{
+  size_t consumed = 0U;
+  while(!state.stopped) {
+    auto split = SplitPrefixed(state.framing, view.substr(consumed));
+    if(!split) {
+      break;
+    }
+
+    consumed += split->second;
+    state.handleMessage(split->first);
+  }
+  return consumed;
+}
+
+size_t DeliverDelimited(ReceiverState &state, std::string_view view)
+{
+  auto &&delimiter = state.framing.delimiter;
+  auto const maxSize = state.framing.maxSize;
+
+  // find all candidate message ends in one pass over the data not scanned before
+  auto &&candidates = state.candidates;
+  candidates.clear();
+  FindAllBytes(view.substr(state.scanned), delimiter.back(), candidates);
+
+  size_t consumed = 0U;
+  for(auto candidate : candidates) {
+    auto const end = state.scanned + candidate + 1U;
+    if((end - consumed < delimiter.size()) ||
+       (view.compare(end - delimiter.size(), delimiter.size(), delimiter) != 0)) {
+      continue;
+    }
+
+    auto const size = end - consumed - delimiter.size();
+    if(size > maxSize) {
+      throw std::runtime_error("message too large");
+    }
+
+    auto const message = view.substr(consumed, size);
+    consumed = end;
+    state.handleMessage(message);
+    if(state.stopped) {
+      return consumed;
+    }
+  }
+
+  state.scanned = view.size() - consumed;
+  if(state.scanned >= maxSize + delimiter.size()) {
+    throw std::runtime_error("message too large");
+  }
+  return consumed;
+}
+
+// held by the socket as its receive handler, which is destroyed along with
+// the socket - possibly by a message handler while messages are delivered
+struct FramedReceiver
+{
+  std::shared_ptr<ReceiverState> state;
+
+  FramedReceiver(std::shared_ptr<ReceiverState> state)
+    : state(std::move(state))
+  {
+  }
+  FramedReceiver(FramedReceiver const &) = default;
+  FramedReceiver(FramedReceiver &&) = default;
+
+  ~FramedReceiver()
+  {
+    if(state && state->delivering) {
+      state->stopped = true;
+    }
+  }
+
+  size_t operator()(std::string_view view) const
+  {
+    // outlives this receiver if the socket is destroyed meanwhile
+    auto const keep = state;
+
+    keep->delivering = true;
+    try {
+      auto consumed = (keep->framing.prefixWidth ?
+                         DeliverPrefixed(*keep, view) :
+                         DeliverDelimited(*keep, view));
+      keep->delivering = false;
+      return consumed;
+    } catch(...) {
+      keep->delivering = false;
+      throw;
+    }
+  }
+};
+
+} // unnamed namespace
+
+Framing Framing::LengthPrefixed(size_t width, bool bigEndian, size_t maxSize)
+{
+  if((width == 0U) || (width > sizeof(uint64_t))) {
+    throw std::logic_error("invalid size field width");
+  }
+
+  // the size field can't express more
+  if(width < sizeof(uint64_t)) {
+    maxSize = std::min<uint64_t>(maxSize, (uint64_t(1U) << (8U * width)) - 1U);
+  }
+  return Framing{width, bigEndian, std::string(), maxSize};
+}
+
+Framing Framing::Delimited(std::string delimiter, size_t maxSize)
+{
+  if(delimiter.empty()) {
+    throw std::logic_error("invalid delimiter");
+  }
+  return Framing{0U, false, std::move(delimiter), maxSize};
+}
+
+ReceiveViewHandler Framing::Receiver(MessageHandler handleMessage) const
+{
+  if(!handleMessage) {
+    throw std::logic_error("invalid handler");
+  }
+  return FramedReceiver(std::make_shared<ReceiverState>(
+      ReceiverState{*this, std::move(handleMessage)}));
+}
+
+void Framing::AppendHeader(std::string &buffer, size_t size) const
+{
+  if(size > maxSize) {
+    throw std::logic_error("message too large");
+  }
+
+  for(size_t i = 0U; i < prefixWidth; ++i) {
+    auto const shift = 8U * (bigEndian ? prefixWidth - 1U - i : i);
+    buffer.push_back(static_cast<char>((uint64_t(size) >> shift) & 0xFFU));
+  }
+}
+
+void Framing::AppendTrailer(std::string &buffer) const
+{
+  buffer.append(delimiter);
+}
+
+} // namespace sockpuppet
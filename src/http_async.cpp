@@ -0,0 +1,179 @@
+#include "sockpuppet/http_async.h"
+#include "file_impl.h" // for FileDescriptor
+#include "http_client_impl.h" // for HttpClientImpl
+#include "http_parser.h" // for FindHeader
+#include "http_server_impl.h" // for HttpServerImpl
+
+#include <stdexcept> // for std::logic_error
+#include <string> // for std::string
+
+namespace sockpuppet {
+
+namespace {
+
+char const *ReasonPhrase(unsigned int status)
+{
+  switch(status) {
+  case 200U: return "OK";
+  case 201U: return "Created";
+  case 202U: return "Accepted";
+  case 204U: return "No Content";
+  case 301U: return "Moved Permanently";
+  case 302U: return "Found";
+  case 304U: return "Not Modified";
+  case 400U: return "Bad Request";
+  case 401U: return "Unauthorized";
+  case 403U: return "Forbidden";
+  case 404U: return "Not Found";
+  case 405U: return "Method Not Allowed";
+  case 413U: return "Content Too Large";
+  case 429U: return "Too Many Requests";
+  case 431U: return "Request Header Fields Too Large";
+  case 500U: return "Internal Server Error";
+  case 501U: return "Not Implemented";
+  case 503U: return "Service Unavailable";
+  case 505U: return "HTTP Version Not Supported";
+  default: return ""; // the reason phrase is optional
+  }
+}
+
+// status line and header lines along with the matching Content-Length
+std::string SerializeHead(unsigned int status, std::string_view contentType,
+    size_t bodySize, std::string_view headers)
+{
+  if((status < 100U) || (status > 999U)) {
+    throw std::logic_error("invalid status code");
+  }
+  bool const withoutBody = (status < 200U) || (status == 204U);
+  if(withoutBody && (bodySize > 0U)) {
+    throw std::logic_error("status does not permit a body");
+  }
+
+  std::string head;
+  head.reserve(64U + contentType.size() + headers.size() + bodySize);
+  head.append("HTTP/1.1 ").append(std::to_string(status))
+      .append(" ").append(ReasonPhrase(status)).append("\r\n");
+  if(!contentType.empty()) {
+    head.append("Content-Type: ").append(contentType).append("\r\n");
+  }
+  if(!withoutBody) {
+    head.append("Content-Length: ").append(std::to_string(bodySize)).append("\r\n");
+  }
+  head.append(headers);
+  return head;
+}
+
+} // unnamed namespace
+
+std::optional<std::string_view> HttpRequest::Header(std::string_view name) const
+{
+  return FindHeader(headers, name);
+}
+
+HttpResponse::HttpResponse(unsigned int status, std::string_view contentType,
+    std::string_view body, std::string_view headers)
+  : wire(SerializeHead(status, contentType, body.size(), headers))
+  , headSize(wire.size())
+{
+  wire.append("\r\n").append(body);
+}
+
+HttpResponse HttpResponse::File(unsigned int status, std::string_view contentType,
+    std::string filePath, std::string_view headers)
+{
+  auto const fileSize = FileDescriptor(filePath.c_str()).Size();
+
+  HttpResponse response(status);
+  response.wire = SerializeHead(status, contentType, fileSize, headers);
+  response.headSize = response.wire.size();
+  response.wire.append("\r\n");
+  response.filePath = std::move(filePath);
+  response.fileSize = fileSize;
+  return response;
+}
+
+HttpServerAsync::HttpServerAsync(Acceptor &&sock, Driver &driver,
+    HttpRequestHandler handleRequest, Duration idleTimeout, size_t maxRequestSize)
+  : impl(std::make_unique<HttpServerImpl>(
+      std::move(sock.impl),
+      driver.impl,
+      std::move(handleRequest),
+      idleTimeout,
+      maxRequestSize))
+{
+}
+
+Address HttpServerAsync::LocalAddress() const
+{
+  return Address(impl->acceptor->buff->sock->GetSockName());
+}
+
+size_t HttpServerAsync::ConnectionCount() const
+{
+  return impl->ConnectionCount();
+}
+
+HttpServerAsync::HttpServerAsync(HttpServerAsync &&other) noexcept = default;
+
+HttpServerAsync::~HttpServerAsync() = default;
+
+HttpServerAsync &HttpServerAsync::operator=(HttpServerAsync &&other) noexcept = default;
+
+
+std::optional<std::string_view> HttpResponseView::Header(std::string_view name) const
+{
+  return FindHeader(headers, name);
+}
+
+HttpClientAsync::HttpClientAsync(Driver &driver, size_t maxPerHost,
+    size_t pipelineDepth, Duration idleTimeout, Duration connectTimeout,
+    size_t maxResponseSize)
+  : impl(std::make_unique<HttpClientImpl>(
+      driver.impl,
+      ConnectorAsyncImpl::TcpSocketFactory(),
+      maxPerHost,
+      pipelineDepth,
+      idleTimeout,
+      connectTimeout,
+      maxResponseSize))
+{
+}
+
+#ifdef SOCKPUPPET_WITH_TLS
+HttpClientAsync::HttpClientAsync(Driver &driver, size_t maxPerHost,
+    size_t pipelineDepth, Duration idleTimeout, Duration connectTimeout,
+    size_t maxResponseSize, char const *certFilePath, char const *keyFilePath)
+  : impl(std::make_unique<HttpClientImpl>(
+      driver.impl,
+      ConnectorAsyncImpl::TlsSocketFactory(certFilePath, keyFilePath),
+      maxPerHost,
+      pipelineDepth,
+      idleTimeout,
+      connectTimeout,
+      maxResponseSize))
+{
+}
+#endif // SOCKPUPPET_WITH_TLS
+
+void HttpClientAsync::Request(Address const &serverAddress,
+    std::string_view method, std::string_view target,
+    std::string_view headers, std::string_view body,
+    HttpResponseHandler handleResponse, HttpErrorHandler handleError,
+    Duration timeout)
+{
+  impl->Request(serverAddress, method, target, headers, body,
+                std::move(handleResponse), std::move(handleError), timeout);
+}
+
+size_t HttpClientAsync::ConnectionCount() const
+{
+  return impl->ConnectionCount();
+}
+
+HttpClientAsync::HttpClientAsync(HttpClientAsync &&other) noexcept = default;
+
+HttpClientAsync::~HttpClientAsync() = default;
+
+HttpClientAsync &HttpClientAsync::operator=(HttpClientAsync &&other) noexcept = default;
+
+} // namespace sockpuppet
@@ -0,0 +1,698 @@
+#include "http_client_impl.h"
+#include "driver_impl.h" // for DriverImpl
+#include "http_parser.h" // for FindHeadEnd
+
+#include <algorithm> // for std::find_if
+#include <stdexcept> // for std::logic_error
+#include <utility> // for std::pair
+
+namespace sockpuppet {
+
+namespace {
+
+// schedule a task to be run by the driver asap
+void Defer(HttpClientImpl::DriverShared &driver, std::function<void()> task)
+{
+  driver->ToDoInsert(std::make_shared<ToDo::ToDoImpl>(
+      driver, std::move(task), Clock::now()));
+}
+
+// numeric host as the address doesn't keep the name it was resolved from
+std::string HostHeader(Address const &serverAddr)
+{
+  auto const host = serverAddr.Host();
+  auto const port = std::to_string(serverAddr.Port());
+  return (serverAddr.IsV6() ?
+            "Host: [" + host + "]:" + port + "\r\n" :
+            "Host: " + host + ":" + port + "\r\n");
+}
+
+bool IsIdempotent(std::string_view method)
+{
+  return (method == "GET") || (method == "HEAD") || (method == "PUT") ||
+         (method == "DELETE") || (method == "OPTIONS") || (method == "TRACE");
+}
+
+std::string SerializeRequest(std::string const &hostHeader,
+    std::string_view method, std::string_view target,
+    std::string_view headers, std::string_view body)
+{
+  bool const withHost = !FindHeader(headers, "Host");
+  bool const withLength =
+      (!body.empty() || (method == "POST") || (method == "PUT") || (method == "PATCH")) &&
+      !FindHeader(headers, "Content-Length") && !FindHeader(headers, "Transfer-Encoding");
+
+  std::string request;
+  request.reserve(64U + method.size() + target.size() + hostHeader.size() +
+                  headers.size() + body.size());
+  request.append(method).append(" ").append(target).append(" HTTP/1.1\r\n");
+  if(withHost) {
+    request.append(hostHeader);
+  }
+  if(withLength) {
+    request.append("Content-Length: ").append(std::to_string(body.size())).append("\r\n");
+  }
+  request.append(headers).append("\r\n").append(body);
+  return request;
+}
+
+// HTTP/1.x SP 3DIGIT [SP reason]
+std::optional<std::pair<int, unsigned int>> ParseStatusLine(std::string_view statusLine)
+{
+  auto const versionEnd = statusLine.find(' ');
+  if(versionEnd == std::string_view::npos) {
+    return std::nullopt;
+  }
+  auto const minorVersion = ParseVersion(statusLine.substr(0U, versionEnd));
+  auto const code = statusLine.substr(versionEnd + 1U);
+  if(!minorVersion || (code.size() < 3U) || ((code.size() > 3U) && (code[3] != ' '))) {
+    return std::nullopt;
+  }
+  auto const status = ParseDecimal(code.substr(0U, 3U));
+  if(!status || (*status < 100U)) {
+    return std::nullopt;
+  }
+  return std::make_pair(*minorVersion, static_cast<unsigned int>(*status));
+}
+
+void ResetParse(HttpClientImpl::Connection &conn)
+{
+  conn.headStart = 0U;
+  conn.scanned = 0U;
+  conn.headEnd = 0U;
+  conn.bodyPos = 0U;
+  conn.framing = HttpClientImpl::Connection::Framing::Length;
+  conn.keepAlive = true;
+  conn.chunkedBody.clear();
+}
+
+} // unnamed namespace
+
+HttpClientImpl::Exchange::~Exchange()
+{
+  if(timeoutTodo) {
+    timeoutTodo->Cancel();
+  }
+}
+
+HttpClientImpl::Connection::~Connection()
+{
+  if(evictTodo) {
+    evictTodo->Cancel();
+  }
+}
+
+HttpClientImpl::Host::Host(Address serverAddr)
+  : serverAddr(std::move(serverAddr))
+  , hostHeader(HostHeader(this->serverAddr))
+{
+}
+
+HttpClientImpl::HttpClientImpl(
+    DriverShared &driver,
+    SocketFactory makeSocket,
+    size_t maxPerHost,
+    size_t pipelineDepth,
+    Duration idleTimeout,
+    Duration connectTimeout,
+    size_t maxResponseSize)
+  : driver(driver)
+  , makeSocket(std::move(makeSocket))
+  , maxPerHost(maxPerHost)
+  , pipelineDepth(pipelineDepth)
+  , idleTimeout(idleTimeout)
+  , connectTimeout(connectTimeout)
+  , maxResponseSize(maxResponseSize)
+{
+  if(pipelineDepth == 0U) {
+    throw std::logic_error("invalid pipeline depth");
+  }
+  if(maxResponseSize == 0U) {
+    throw std::logic_error("invalid maximum response size");
+  }
+}
+
+HttpClientImpl::~HttpClientImpl()
+{
+  if(auto ptr = driver.lock()) {
+    // pending requests are dropped without being reported
+    Driver::DriverImpl::PauseGuard lock(*ptr);
+    hosts.clear();
+  }
+}
+
+void HttpClientImpl::Request(Address const &serverAddr,
+    std::string_view method, std::string_view target,
+    std::string_view headers, std::string_view body,
+    HttpResponseHandler onResponse, HttpErrorHandler onError,
+    Duration timeout)
+{
+  if(!onResponse || !onError) {
+    throw std::logic_error("invalid handler");
+  }
+  auto ptr = driver.lock();
+  if(!ptr) {
+    throw std::logic_error("driver was destroyed");
+  }
+  Driver::DriverImpl::PauseGuard lock(*ptr);
+
+  auto &&host = hosts.try_emplace(serverAddr, serverAddr).first->second;
+
+  auto exchange = std::make_shared<Exchange>();
+  exchange->request = SerializeRequest(host.hostHeader, method, target, headers, body);
+  exchange->idempotent = IsIdempotent(method);
+  exchange->headOnly = (method == "HEAD");
+  exchange->onResponse = std::move(onResponse);
+  exchange->onError = std::move(onError);
+  exchange->host = &host;
+  if(timeout.count() >= 0) {
+    exchange->timeoutTodo = std::make_shared<ToDo::ToDoImpl>(
+        ptr,
+        std::bind(&HttpClientImpl::DriverOnTimeout, this, exchange.get()),
+        Clock::now() + timeout);
+    ptr->ToDoInsert(exchange->timeoutTodo);
+  }
+
+  host.waiting.push_back(std::move(exchange));
+  Serve(host);
+}
+
+size_t HttpClientImpl::ConnectionCount() const
+{
+  auto ptr = driver.lock();
+  if(!ptr) {
+    return 0U;
+  }
+  Driver::DriverImpl::PauseGuard lock(*ptr);
+
+  size_t count = 0U;
+  for(auto &&[serverAddr, host] : hosts) {
+    count += host.connections.size();
+  }
+  return count;
+}
+
+void HttpClientImpl::Serve(Host &host)
+{
+  // waiting requests are served in order, preferring the least busy
+  // connection with room in its pipeline and connecting anew otherwise
+  while(!host.waiting.empty()) {
+    auto const depth = (host.waiting.front()->idempotent ? pipelineDepth : 1U);
+    Connection *conn = nullptr;
+    for(auto &&candidate : host.connections) {
+      if((candidate.inFlight.size() < depth) &&
+         (!conn || (candidate.inFlight.size() < conn->inFlight.size()))) {
+        conn = &candidate;
+      }
+    }
+
+    if(!conn) {
+      if((maxPerHost != 0U) && (host.connections.size() >= maxPerHost)) {
+        break;
+      }
+      try {
+        conn = Connect(host);
+      } catch(std::runtime_error const &e) {
+        auto exchange = std::move(host.waiting.front());
+        host.waiting.pop_front();
+        if(exchange->timeoutTodo) {
+          exchange->timeoutTodo->Cancel();
+        }
+
+        // report in driver context like any other connect error
+        if(auto ptr = driver.lock()) {
+          Defer(ptr,
+            [exchange = std::move(exchange), reason = std::string(e.what())]() {
+              exchange->onError(reason.c_str());
+            });
+        }
+        continue;
+      }
+    }
+
+    auto exchange = std::move(host.waiting.front());
+    host.waiting.pop_front();
+    Assign(*conn, std::move(exchange));
+  }
+}
+
+HttpClientImpl::Connection *HttpClientImpl::Connect(Host &host)
+{
+  auto ptr = driver.lock();
+  if(!ptr) {
+    throw std::logic_error("driver was destroyed");
+  }
+
+  auto it = host.connections.emplace(host.connections.end());
+  try {
+    it->evictTodo = std::make_shared<ToDo::ToDoImpl>(
+        ptr,
+        std::bind(&HttpClientImpl::DriverOnEvict, this, &host, it));
+
+    // the driver is paused, so the connector can't report before being stored
+    it->connector = std::make_unique<ConnectorAsyncImpl>(
+        ptr,
+        makeSocket,
+        host.serverAddr.impl,
+        std::bind(&HttpClientImpl::DriverOnConnect,
+                  this,
+                  &host,
+                  it,
+                  std::placeholders::_1),
+        std::bind(&HttpClientImpl::DriverOnConnectError,
+                  this,
+                  &host,
+                  it,
+                  std::placeholders::_2),
+        connectTimeout);
+  } catch(std::runtime_error const &) {
+    host.connections.erase(it);
+    throw;
+  }
+  return &*it;
+}
+
+void HttpClientImpl::Assign(Connection &conn, ExchangeShared exchange)
+{
+  if(conn.inFlight.empty()) {
+    conn.evictTodo->Cancel();
+  }
+  exchange->conn = &conn;
+  conn.inFlight.push_back(std::move(exchange));
+
+  // requests assigned while connecting are sent once connected
+  if(conn.state == Connection::State::Open) {
+    Send(conn, conn.inFlight.back()->request);
+  }
+}
+
+void HttpClientImpl::Send(Connection &conn, std::string_view data)
+{
+  if(conn.sock->SendQueueSize() == 0U) {
+    // send right away to save a poll round trip
+    try {
+      auto sent = conn.sock->buff->sock->Send(
+            data.data(), data.size(),
+            Duration(0));
+      data.remove_prefix(sent);
+    } catch(std::runtime_error const &) {
+      // the connection loss is reported to the disconnect handler
+    }
+  }
+
+  if(!data.empty()) {
+    auto buffer = pool.Get();
+    buffer->assign(data);
+    (void)conn.sock->Send(std::move(buffer));
+  }
+}
+
+void HttpClientImpl::Park(Connection &conn)
+{
+  if(conn.inFlight.empty() && (idleTimeout.count() >= 0)) {
+    conn.evictTodo->Shift(Clock::now() + idleTimeout);
+  }
+}
+
+std::vector<HttpClientImpl::ExchangeShared> HttpClientImpl::Remove(
+    Host &host, Connections::iterator it, bool started)
+{
+  // requests may have been sent when the server closed an idle connection
+  // concurrently; those not changing state on the server can be sent again
+  std::vector<ExchangeShared> retries;
+  std::vector<ExchangeShared> failed;
+  for(auto &&exchange : it->inFlight) {
+    exchange->conn = nullptr;
+    bool const isStarted = started && (&exchange == &it->inFlight.front());
+    if(exchange->idempotent && !exchange->retried && !isStarted) {
+      exchange->retried = true;
+      retries.push_back(std::move(exchange));
+    } else {
+      failed.push_back(std::move(exchange));
+    }
+  }
+  host.waiting.insert(host.waiting.begin(), retries.begin(), retries.end());
+  host.connections.erase(it);
+
+  // the freed slot may be used by a waiting request
+  Serve(host);
+  return failed;
+}
+
+void HttpClientImpl::Tidy(Host &host)
+{
+  if(host.connections.empty() && host.waiting.empty()) {
+    auto serverAddr = host.serverAddr; // the key must outlive the erase
+    (void)hosts.erase(serverAddr);
+  }
+}
+
+void HttpClientImpl::DriverOnConnect(Host *host, Connections::iterator it,
+    SocketTcp sock)
+{
+  auto &&conn = *it;
+  conn.connector.reset(); // the connector has handed over everything
+
+  auto ptr = driver.lock();
+  try {
+    // pipelined requests are sent without waiting for acknowledgements
+    TcpOptions options;
+    options.noDelay = true;
+    sock.impl->SetSockOptTcp(options);
+
+    auto buff = std::make_unique<SocketBufferedImpl>(std::move(sock.impl), 0U, 0U);
+    buff->EnableRing(maxResponseSize);
+    conn.sock = std::make_unique<SocketAsyncImpl>(
+        std::move(buff),
+        ptr,
+        ReceiveViewHandler(std::bind(&HttpClientImpl::DriverOnReceive,
+                                     this,
+                                     host,
+                                     it,
+                                     std::placeholders::_1)),
+        DisconnectHandler(std::bind(&HttpClientImpl::DriverOnDisconnect,
+                                    this,
+                                    host,
+                                    it,
+                                    std::placeholders::_2)));
+  } catch(std::runtime_error const &e) {
+    DriverOnConnectError(host, it, e.what());
+    return;
+  }
+  conn.state = Connection::State::Open;
+
+  // requests assigned while connecting are sent at once
+  requests.clear();
+  for(auto &&exchange : conn.inFlight) {
+    requests.append(exchange->request);
+  }
+  if(!requests.empty()) {
+    Send(conn, requests);
+  }
+  Park(conn);
+}
+
+void HttpClientImpl::DriverOnConnectError(Host *host, Connections::iterator it,
+    char const *reason)
+{
+  std::string const reasonCopy = reason; // owned by the connector
+
+  // the requests have not been sent, but another attempt would fail likewise
+  std::vector<ExchangeShared> failed(
+      std::make_move_iterator(it->inFlight.begin()),
+      std::make_move_iterator(it->inFlight.end()));
+  host->connections.erase(it);
+
+  // the freed slot may be used by a waiting request
+  Serve(*host);
+  Tidy(*host);
+
+  // the handlers may destroy the client -> done with bookkeeping beforehand
+  for(auto &&exchange : failed) {
+    exchange->onError(reasonCopy.c_str());
+  }
+}
+
+size_t HttpClientImpl::DriverOnReceive(Host *host, Connections::iterator it,
+    std::string_view view)
+{
+  auto &&conn = *it;
+
+  // complete responses are collected first as the handlers
+  // may destroy the client (but not the ring of the view)
+  std::vector<Delivery> deliveries;
+  std::string error;
+  size_t consumed = 0U;
+  bool keepAlive = true;
+  while(keepAlive && (consumed < view.size())) {
+    if(conn.inFlight.empty()) {
+      error = "unsolicited response data";
+      break;
+    }
+
+    HttpResponseView response{};
+    size_t size;
+    try {
+      size = DriverParse(conn, view.substr(consumed), response);
+    } catch(std::runtime_error const &e) {
+      error = e.what();
+      break;
+    }
+    if(size == 0U) {
+      if(view.size() - consumed >= maxResponseSize) {
+        error = "response exceeds the maximum size";
+      }
+      break;
+    }
+    consumed += size;
+    keepAlive = conn.keepAlive;
+
+    bool const chunked = (conn.framing == Connection::Framing::Chunked);
+    auto exchange = std::move(conn.inFlight.front());
+    conn.inFlight.pop_front();
+    exchange->conn = nullptr;
+    deliveries.push_back(Delivery{
+        std::move(exchange),
+        response,
+        (chunked ? std::move(conn.chunkedBody) : std::string()),
+        chunked});
+    ResetParse(conn);
+  }
+
+  std::vector<ExchangeShared> failed;
+  if(!keepAlive || !error.empty()) {
+    // the socket is destroyed, but the ring is updated by it nevertheless
+    bool const started = !error.empty() && (consumed < view.size());
+    failed = Remove(*host, it, started);
+    Tidy(*host);
+    consumed = view.size();
+  } else if(!deliveries.empty()) {
+    // the freed pipeline slots may be used by waiting requests
+    Serve(*host);
+    Park(conn);
+  }
+
+  // the handlers may destroy the client -> done with bookkeeping beforehand
+  for(auto &&delivery : deliveries) {
+    if(delivery.chunked) {
+      delivery.response.body = delivery.chunkedBody;
+    }
+    delivery.exchange->onResponse(delivery.response);
+  }
+  for(auto &&exchange : failed) {
+    exchange->onError(error.empty() ? "connection closed by server" : error.c_str());
+  }
+  return consumed;
+}
+
+size_t HttpClientImpl::DriverParse(Connection &conn, std::string_view data,
+    HttpResponseView &response)
+{
+  if(conn.headEnd == 0U) {
+    for(;;) {
+      auto const head = data.substr(conn.headStart);
+      auto const headSize = FindHeadEnd(head, conn.scanned);
+      if(headSize == std::string_view::npos) {
+        return 0U;
+      }
+      auto [statusLine, headers] = SplitHead(head.substr(0U, headSize));
+      auto const parsed = ParseStatusLine(statusLine);
+      if(!parsed) {
+        throw std::runtime_error("malformed response status line");
+      }
+      if(parsed->second < 200U) {
+        // interim responses (e.g. 100 Continue) precede the final one
+        conn.headStart += headSize;
+        conn.scanned = 0U;
+        continue;
+      }
+
+      conn.headEnd = conn.headStart + headSize;
+      conn.minorVersion = parsed->first;
+      conn.status = parsed->second;
+      auto const connection = FindHeader(headers, "Connection");
+      conn.keepAlive = (conn.minorVersion > 0 ?
+                          !(connection && HasToken(*connection, "close")) :
+                          (connection && HasToken(*connection, "keep-alive")));
+
+      auto const transferEncoding = FindHeader(headers, "Transfer-Encoding");
+      auto const contentLength = FindHeader(headers, "Content-Length");
+      if(conn.inFlight.front()->headOnly || (conn.status == 204U) || (conn.status == 304U)) {
+        conn.framing = Connection::Framing::Length;
+        conn.bodyPos = conn.headEnd;
+      } else if(transferEncoding) {
+        // any other transfer coding is delimited by the connection close
+        conn.framing = (HasToken(*transferEncoding, "chunked") ?
+                          Connection::Framing::Chunked :
+                          Connection::Framing::UntilClose);
+        conn.bodyPos = conn.headEnd;
+      } else if(contentLength) {
+        auto const size = ParseDecimal(*contentLength);
+        if(!size) {
+          throw std::runtime_error("malformed response content length");
+        } else if(*size > maxResponseSize) {
+          throw std::runtime_error("response exceeds the maximum size");
+        }
+        conn.framing = Connection::Framing::Length;
+        conn.bodyPos = conn.headEnd + *size;
+      } else {
+        conn.framing = Connection::Framing::UntilClose;
+      }
+      if(conn.framing == Connection::Framing::UntilClose) {
+        conn.keepAlive = false;
+      }
+      break;
+    }
+  }
+
+  size_t size = 0U;
+  switch(conn.framing) {
+  case Connection::Framing::Length:
+    if(data.size() < conn.bodyPos) {
+      return 0U;
+    }
+    response.body = data.substr(conn.headEnd, conn.bodyPos - conn.headEnd);
+    size = conn.bodyPos;
+    break;
+  case Connection::Framing::Chunked:
+    // chunks are decoded as they arrive; bodyPos is the next chunk size line
+    for(;;) {
+      auto const lineEnd = data.find("\r\n", conn.bodyPos);
+      if(lineEnd == std::string_view::npos) {
+        return 0U;
+      }
+      auto sizeField = data.substr(conn.bodyPos, lineEnd - conn.bodyPos);
+      sizeField = sizeField.substr(0U, sizeField.find(';')); // ignore extensions
+      while(!sizeField.empty() && ((sizeField.back() == ' ') || (sizeField.back() == '\t'))) {
+        sizeField.remove_suffix(1U);
+      }
+      auto const chunkSize = ParseHexadecimal(sizeField);
+      if(!chunkSize) {
+        throw std::runtime_error("malformed response chunk size");
+      } else if(*chunkSize > maxResponseSize) {
+        throw std::runtime_error("response exceeds the maximum size");
+      }
+
+      auto const chunkStart = lineEnd + 2U;
+      if(*chunkSize == 0U) {
+        // the last chunk is followed by optional trailer lines and an empty line
+        if(data.size() < chunkStart + 2U) {
+          return 0U;
+        } else if(data.substr(chunkStart, 2U) == "\r\n") {
+          size = chunkStart + 2U;
+        } else {
+          auto const trailerEnd = data.find("\r\n\r\n", chunkStart);
+          if(trailerEnd == std::string_view::npos) {
+            return 0U;
+          }
+          size = trailerEnd + 4U;
+        }
+        response.body = conn.chunkedBody;
+        break;
+      }
+
+      auto const chunkEnd = chunkStart + *chunkSize;
+      if(data.size() < chunkEnd + 2U) {
+        return 0U;
+      } else if(data.substr(chunkEnd, 2U) != "\r\n") {
+        throw std::runtime_error("malformed response chunk");
+      }
+      conn.chunkedBody.append(data.substr(chunkStart, *chunkSize));
+      conn.bodyPos = chunkEnd + 2U;
+    }
+    break;
+  case Connection::Framing::UntilClose:
+    return 0U; // delivered on disconnect
+  }
+
+  response.status = conn.status;
+  response.minorVersion = conn.minorVersion;
+  response.headers = SplitHead(data.substr(conn.headStart, conn.headEnd - conn.headStart)).second;
+  return size;
+}
+
+void HttpClientImpl::DriverOnDisconnect(Host *host, Connections::iterator it,
+    char const *reason)
+{
+  auto &&conn = *it;
+  std::string const reasonCopy = reason; // owned by the socket
+
+  // a response delimited by the connection close is complete now;
+  // the ring is kept as the socket is destroyed before the handler call
+  auto ring = conn.sock->buff->ring;
+  auto const data = ring->Readable();
+  std::vector<Delivery> deliveries;
+  if(!conn.inFlight.empty() && (conn.headEnd > 0U) &&
+     (conn.framing == Connection::Framing::UntilClose)) {
+    HttpResponseView response{
+      conn.status,
+      conn.minorVersion,
+      SplitHead(data.substr(conn.headStart, conn.headEnd - conn.headStart)).second,
+      data.substr(conn.headEnd)};
+    auto exchange = std::move(conn.inFlight.front());
+    conn.inFlight.pop_front();
+    exchange->conn = nullptr;
+    deliveries.push_back(Delivery{std::move(exchange), response, std::string(), false});
+  }
+
+  bool const started = deliveries.empty() && !data.empty();
+  auto failed = Remove(*host, it, started);
+  Tidy(*host);
+
+  // the handlers may destroy the client -> done with bookkeeping beforehand
+  for(auto &&delivery : deliveries) {
+    delivery.exchange->onResponse(delivery.response);
+  }
+  for(auto &&exchange : failed) {
+    exchange->onError(reasonCopy.c_str());
+  }
+}
+
+void HttpClientImpl::DriverOnEvict(Host *host, Connections::iterator it)
+{
+  if(it->inFlight.empty()) {
+    host->connections.erase(it);
+    Tidy(*host);
+  }
+}
+
+void HttpClientImpl::DriverOnTimeout(Exchange *exchange)
+{
+  auto &&host = *exchange->host;
+  auto isSame = [exchange](ExchangeShared const &other) -> bool {
+    return (other.get() == exchange);
+  };
+
+  ExchangeShared timedOut;
+  std::vector<ExchangeShared> failed;
+  if(auto conn = exchange->conn) {
+    auto pos = std::find_if(conn->inFlight.begin(), conn->inFlight.end(), isSame);
+    bool const isFirst = (pos == conn->inFlight.begin());
+    timedOut = std::move(*pos);
+    (void)conn->inFlight.erase(pos);
+
+    if(conn->state == Connection::State::Open) {
+      // a late response would be taken for the one to the next request
+      auto it = std::find_if(host.connections.begin(), host.connections.end(),
+        [conn](Connection const &other) -> bool {
+          return (&other == conn);
+        });
+      bool const started = !isFirst && !conn->sock->buff->ring->Readable().empty();
+      failed = Remove(host, it, started);
+    }
+  } else {
+    auto pos = std::find_if(host.waiting.begin(), host.waiting.end(), isSame);
+    timedOut = std::move(*pos);
+    (void)host.waiting.erase(pos);
+  }
+  timedOut->conn = nullptr;
+  Tidy(host);
+
+  // the handlers may destroy the client -> done with bookkeeping beforehand
+  timedOut->onError("request timed out");
+  for(auto &&other : failed) {
+    other->onError("connection closed after another request timed out");
+  }
+}
+
+} // namespace sockpuppet
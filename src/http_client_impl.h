@@ -0,0 +1,179 @@
+#ifndef SOCKPUPPET_HTTP_CLIENT_IMPL_H
+#define SOCKPUPPET_HTTP_CLIENT_IMPL_H
+
+#include "connector_async_impl.h" // for ConnectorAsyncImpl
+#include "socket_async_impl.h" // for SocketAsyncImpl
+#include "sockpuppet/address.h" // for Address
+#include "sockpuppet/http_async.h" // for HttpClientAsync
+#include "todo_impl.h" // for ToDoShared
+
+#include <cstddef> // for size_t
+#include <deque> // for std::deque
+#include <list> // for std::list
+#include <memory> // for std::shared_ptr
+#include <string> // for std::string
+#include <string_view> // for std::string_view
+#include <unordered_map> // for std::unordered_map
+#include <vector> // for std::vector
+
+namespace sockpuppet {
+
+// keeps connections per server address open for subsequent requests and
+// pipelines requests on them; responses are parsed from the receive ring
+// of their connection; all state is guarded by the driver's step mutex
+// (using PauseGuard from outside the driver thread) like the sockets
+// and ToDos it is made of
+struct HttpClientImpl
+{
+  using DriverShared = std::shared_ptr<Driver::DriverImpl>;
+  using SocketFactory = ConnectorAsyncImpl::SocketFactory;
+
+  struct Host;
+  struct Connection;
+
+  struct Exchange
+  {
+    std::string request; // serialized; kept for a retry
+    bool idempotent;
+    bool headOnly; // response to HEAD carries no body
+    bool retried = false;
+    HttpResponseHandler onResponse;
+    HttpErrorHandler onError;
+    ToDoShared timeoutTodo;
+    Host *host = nullptr;
+    Connection *conn = nullptr; // nullptr while waiting for a connection
+
+    Exchange() = default;
+    Exchange(Exchange const &) = delete;
+    Exchange(Exchange &&) = delete;
+    ~Exchange();
+    Exchange &operator=(Exchange const &) = delete;
+    Exchange &operator=(Exchange &&) = delete;
+  };
+  using ExchangeShared = std::shared_ptr<Exchange>;
+
+  struct Connection
+  {
+    enum class State
+    {
+      Connecting, // assigned requests are sent once connected
+      Open
+    };
+    enum class Framing
+    {
+      Length,
+      Chunked,
+      UntilClose
+    };
+
+    State state = State::Connecting;
+    std::deque<ExchangeShared> inFlight; // oldest first; responses arrive in order
+
+    // parse state of the oldest response; offsets are relative to
+    // the unconsumed data of the receive ring which starts with it
+    size_t headStart = 0U; // past interim (1xx) responses
+    size_t scanned = 0U; // bytes known to hold no head end
+    size_t headEnd = 0U; // 0 while the head is incomplete
+    size_t bodyPos = 0U; // end of the body or start of the next chunk
+    Framing framing = Framing::Length;
+    unsigned int status = 0U;
+    int minorVersion = 1;
+    bool keepAlive = true;
+    std::string chunkedBody; // decoded body of a chunked response
+
+    ToDoShared evictTodo;
+    std::unique_ptr<ConnectorAsyncImpl> connector;
+    std::unique_ptr<SocketAsyncImpl> sock; // destroyed before the above
+
+    Connection() = default;
+    Connection(Connection const &) = delete;
+    Connection(Connection &&) = delete;
+    ~Connection();
+    Connection &operator=(Connection const &) = delete;
+    Connection &operator=(Connection &&) = delete;
+  };
+  using Connections = std::list<Connection>;
+
+  struct Host
+  {
+    Address serverAddr;
+    std::string hostHeader; // derived from the address unless given per request
+    Connections connections;
+    std::deque<ExchangeShared> waiting; // for a connection to send on
+
+    Host(Address serverAddr);
+  };
+
+  // a complete response collected for its handler to be called after bookkeeping
+  struct Delivery
+  {
+    ExchangeShared exchange;
+    HttpResponseView response;
+    std::string chunkedBody; // the response body refers to this if chunked
+    bool chunked;
+  };
+
+  std::weak_ptr<Driver::DriverImpl> driver;
+  SocketFactory makeSocket; // contains use-case-dependent data as bound arguments
+  size_t maxPerHost;
+  size_t pipelineDepth;
+  Duration idleTimeout;
+  Duration connectTimeout;
+  size_t maxResponseSize;
+  BufferPool pool; // for requests that could not be sent right away
+  std::string requests; // of a connection established just now
+  std::unordered_map<Address, Host> hosts;
+
+  HttpClientImpl(DriverShared &driver,
+                 SocketFactory makeSocket,
+                 size_t maxPerHost,
+                 size_t pipelineDepth,
+                 Duration idleTimeout,
+                 Duration connectTimeout,
+                 size_t maxResponseSize);
+  HttpClientImpl(HttpClientImpl const &) = delete;
+  HttpClientImpl(HttpClientImpl &&) = delete;
+  ~HttpClientImpl();
+  HttpClientImpl &operator=(HttpClientImpl const &) = delete;
+  HttpClientImpl &operator=(HttpClientImpl &&) = delete;
+
+  void Request(Address const &serverAddr,
+               std::string_view method,
+               std::string_view target,
+               std::string_view headers,
+               std::string_view body,
+               HttpResponseHandler onResponse,
+               HttpErrorHandler onError,
+               Duration timeout);
+  size_t ConnectionCount() const;
+
+  // with step mutex held
+  void Serve(Host &host);
+  Connection *Connect(Host &host);
+  void Assign(Connection &conn, ExchangeShared exchange);
+  void Send(Connection &conn, std::string_view data);
+  void Park(Connection &conn);
+  // removes a connection, queuing its requests in flight for a retry
+  // where possible; returns the requests that failed
+  std::vector<ExchangeShared> Remove(Host &host,
+                                     Connections::iterator it,
+                                     bool started);
+  void Tidy(Host &host);
+
+  // in thread context of DriverImpl
+  void DriverOnConnect(Host *host, Connections::iterator it, SocketTcp sock);
+  void DriverOnConnectError(Host *host, Connections::iterator it, char const *reason);
+  size_t DriverOnReceive(Host *host, Connections::iterator it, std::string_view view);
+  // returns the size of the response to the oldest request in flight
+  // (including interim responses) or zero if it is incomplete
+  size_t DriverParse(Connection &conn,
+                     std::string_view data,
+                     HttpResponseView &response);
+  void DriverOnDisconnect(Host *host, Connections::iterator it, char const *reason);
+  void DriverOnEvict(Host *host, Connections::iterator it);
+  void DriverOnTimeout(Exchange *exchange);
+};
+
+} // namespace sockpuppet
+
+#endif // SOCKPUPPET_HTTP_CLIENT_IMPL_H
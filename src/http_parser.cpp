@@ -0,0 +1,138 @@
+#include "http_parser.h"
+
+#include <charconv> // for std::from_chars
+#include <string_view> // for std::string_view
+
+namespace sockpuppet {
+
+namespace {
+
+constexpr std::string_view lineEnd = "\r\n";
+constexpr std::string_view headEnd = "\r\n\r\n";
+
+char ToLower(char c)
+{
+  return ((c >= 'A') && (c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c);
+}
+
+bool EqualsIgnoreCase(std::string_view lhs, std::string_view rhs)
+{
+  if(lhs.size() != rhs.size()) {
+    return false;
+  }
+  for(size_t i = 0U; i < lhs.size(); ++i) {
+    if(ToLower(lhs[i]) != ToLower(rhs[i])) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string_view Trim(std::string_view str)
+{
+  while(!str.empty() && ((str.front() == ' ') || (str.front() == '\t'))) {
+    str.remove_prefix(1U);
+  }
+  while(!str.empty() && ((str.back() == ' ') || (str.back() == '\t'))) {
+    str.remove_suffix(1U);
+  }
+  return str;
+}
+
+// from_chars accepts a leading minus, so the first digit is checked by the caller
+std::optional<size_t> ParseNumber(std::string_view digits, int base)
+{
+  size_t value = 0U;
+  auto const end = digits.data() + digits.size();
+  auto [ptr, error] = std::from_chars(digits.data(), end, value, base);
+  if((error != std::errc()) || (ptr != end)) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+} // unnamed namespace
+
+size_t FindHeadEnd(std::string_view data, size_t &scanned)
+{
+  // the end may have been received partially before
+  auto const from = (scanned < headEnd.size() ? 0U : scanned - headEnd.size() + 1U);
+  auto const pos = data.find(headEnd, from);
+  if(pos == std::string_view::npos) {
+    scanned = data.size();
+    return std::string_view::npos;
+  }
+  return pos + headEnd.size();
+}
+
+std::pair<std::string_view, std::string_view> SplitHead(std::string_view head)
+{
+  auto const pos = head.find(lineEnd);
+  auto const firstLine = head.substr(0U, pos);
+  head.remove_prefix(pos + lineEnd.size());
+  head.remove_suffix(lineEnd.size()); // the empty line
+  return {firstLine, head};
+}
+
+std::optional<std::string_view> FindHeader(std::string_view headers,
+    std::string_view name)
+{
+  while(!headers.empty()) {
+    auto const pos = headers.find(lineEnd);
+    auto const line = headers.substr(0U, pos);
+    headers.remove_prefix(pos == std::string_view::npos ?
+                          headers.size() :
+                          pos + lineEnd.size());
+
+    auto const colon = line.find(':');
+    if((colon != std::string_view::npos) &&
+       EqualsIgnoreCase(line.substr(0U, colon), name)) {
+      return Trim(line.substr(colon + 1U));
+    }
+  }
+  return std::nullopt;
+}
+
+bool HasToken(std::string_view value, std::string_view token)
+{
+  while(!value.empty()) {
+    auto const pos = value.find(',');
+    if(EqualsIgnoreCase(Trim(value.substr(0U, pos)), token)) {
+      return true;
+    }
+    value.remove_prefix(pos == std::string_view::npos ? value.size() : pos + 1U);
+  }
+  return false;
+}
+
+std::optional<size_t> ParseDecimal(std::string_view digits)
+{
+  if(digits.empty() || (digits.front() < '0') || (digits.front() > '9')) {
+    return std::nullopt;
+  }
+  return ParseNumber(digits, 10);
+}
+
+std::optional<size_t> ParseHexadecimal(std::string_view digits)
+{
+  if(digits.empty()) {
+    return std::nullopt;
+  }
+  auto const first = ToLower(digits.front());
+  if(((first < '0') || (first > '9')) && ((first < 'a') || (first > 'f'))) {
+    return std::nullopt;
+  }
+  return ParseNumber(digits, 16);
+}
+
+std::optional<int> ParseVersion(std::string_view version)
+{
+  if(version == "HTTP/1.1") {
+    return 1;
+  } else if(version == "HTTP/1.0") {
+    return 0;
+  }
+  return std::nullopt;
+}
+
+} // namespace sockpuppet
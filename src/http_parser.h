@@ -0,0 +1,42 @@
+#ifndef SOCKPUPPET_HTTP_PARSER_H
+#define SOCKPUPPET_HTTP_PARSER_H
+
+#include <cstddef> // for size_t
+#include <optional> // for std::optional
+#include <string_view> // for std::string_view
+#include <utility> // for std::pair
+
+namespace sockpuppet {
+
+// HTTP/1.x message head parsing on received data without copying;
+// all returned views refer to the data passed in
+
+// offset right after the empty line ending the message head or npos if
+// incomplete; scanned holds the amount of data known to hold no head end
+// before and is advanced for the next attempt on the same growing data
+size_t FindHeadEnd(std::string_view data, size_t &scanned);
+
+// first line of a message head and the header lines following it
+// (each terminated by CRLF, not including the empty line)
+std::pair<std::string_view, std::string_view> SplitHead(std::string_view head);
+
+// value of the header field with given (case-insensitive) name
+// without surrounding whitespace or nullopt if not present
+std::optional<std::string_view> FindHeader(std::string_view headers,
+                                           std::string_view name);
+
+// whether a comma-separated header field value lists a (case-insensitive) token
+bool HasToken(std::string_view value, std::string_view token);
+
+// decimal number without sign or whitespace; nullopt if malformed or too large
+std::optional<size_t> ParseDecimal(std::string_view digits);
+
+// hexadecimal number as used for chunk sizes; nullopt if malformed or too large
+std::optional<size_t> ParseHexadecimal(std::string_view digits);
+
+// minor version of "HTTP/1.x"; nullopt for any other protocol version
+std::optional<int> ParseVersion(std::string_view version);
+
+} // namespace sockpuppet
+
+#endif // SOCKPUPPET_HTTP_PARSER_H
@@ -0,0 +1,333 @@
+#include "http_server_impl.h"
+#include "driver_impl.h" // for DriverImpl
+#include "file_impl.h" // for FileSlice
+#include "http_parser.h" // for FindHeadEnd
+#include "socket_tls_impl.h" // for SocketTlsImpl
+
+#include <algorithm> // for std::min
+#include <stdexcept> // for std::logic_error
+
+namespace sockpuppet {
+
+namespace {
+
+// polling period while waiting for the last response of a closing connection
+constexpr auto lingerInterval = std::chrono::milliseconds(10);
+
+// file bodies that can't be sent from the file are read in pieces of a TLS record
+constexpr size_t fileChunkSize = 16384U;
+
+constexpr std::string_view closeHeader = "Connection: close\r\n";
+constexpr std::string_view keepAliveHeader = "Connection: keep-alive\r\n";
+
+HttpResponse const &ErrorResponse(unsigned int status)
+{
+  static HttpResponse const badRequest(400U);
+  static HttpResponse const payloadTooLarge(413U);
+  static HttpResponse const headerTooLarge(431U);
+  static HttpResponse const notImplemented(501U);
+  static HttpResponse const versionNotSupported(505U);
+
+  switch(status) {
+  case 413U: return payloadTooLarge;
+  case 431U: return headerTooLarge;
+  case 501U: return notImplemented;
+  case 505U: return versionNotSupported;
+  default: return badRequest;
+  }
+}
+
+// the connection header is inserted in front of the empty line
+void AppendResponse(std::string &responses, HttpResponse const &response,
+    std::string_view connectionHeader, bool withBody)
+{
+  auto const &wire = response.wire;
+  responses.append(wire, 0U, response.headSize);
+  responses.append(connectionHeader);
+  responses.append(wire, response.headSize,
+                   withBody ? std::string::npos : 2U);
+}
+
+} // unnamed namespace
+
+HttpServerImpl::Connection::~Connection()
+{
+  if(evictTodo) {
+    evictTodo->Cancel();
+  }
+}
+
+HttpServerImpl::HttpServerImpl(
+    std::unique_ptr<SocketImpl> &&sock,
+    DriverShared &driver,
+    HttpRequestHandler onRequest,
+    Duration idleTimeout,
+    size_t maxRequestSize)
+  : driver(driver)
+  , onRequest(std::move(onRequest))
+  , idleTimeout(idleTimeout)
+  , maxRequestSize(maxRequestSize)
+{
+  if(!this->onRequest) {
+    throw std::logic_error("invalid handler");
+  }
+  if(maxRequestSize == 0U) {
+    throw std::logic_error("invalid maximum request size");
+  }
+
+  acceptor = std::make_unique<SocketAsyncImpl>(
+      std::move(sock),
+      driver,
+      std::bind(&HttpServerImpl::DriverOnConnect,
+                this,
+                std::placeholders::_1));
+  acceptor->buff->sock->Listen();
+}
+
+HttpServerImpl::~HttpServerImpl()
+{
+  if(auto ptr = driver.lock()) {
+    Driver::DriverImpl::PauseGuard lock(*ptr);
+    acceptor.reset();
+    connections.clear();
+  }
+}
+
+size_t HttpServerImpl::ConnectionCount() const
+{
+  auto ptr = driver.lock();
+  if(!ptr) {
+    return 0U;
+  }
+  Driver::DriverImpl::PauseGuard lock(*ptr);
+
+  return connections.size();
+}
+
+void HttpServerImpl::DriverOnConnect(SocketTcp sock)
+{
+  auto ptr = driver.lock();
+  auto it = connections.emplace(connections.end());
+  try {
+    it->evictTodo = std::make_shared<ToDo::ToDoImpl>(
+        ptr,
+        std::bind(&HttpServerImpl::DriverOnEvict, this, it));
+
+#ifdef SOCKPUPPET_WITH_TLS
+    it->sendsFiles = !dynamic_cast<SocketTlsImpl *>(sock.impl.get());
+#endif // SOCKPUPPET_WITH_TLS
+
+    auto buff = std::make_unique<SocketBufferedImpl>(std::move(sock.impl), 0U, 0U);
+    buff->EnableRing(maxRequestSize);
+    it->sock = std::make_unique<SocketAsyncImpl>(
+        std::move(buff),
+        ptr,
+        ReceiveViewHandler(std::bind(&HttpServerImpl::DriverOnReceive,
+                                     this,
+                                     it,
+                                     std::placeholders::_1)),
+        DisconnectHandler(std::bind(&HttpServerImpl::DriverOnDisconnect,
+                                    this,
+                                    it)));
+  } catch(std::runtime_error const &) {
+    // drop the client like a failed accept
+    connections.erase(it);
+    return;
+  }
+
+  if(idleTimeout.count() >= 0) {
+    it->evictTodo->Shift(Clock::now() + idleTimeout);
+  }
+}
+
+size_t HttpServerImpl::DriverOnReceive(Connections::iterator it,
+    std::string_view view)
+{
+  auto &&conn = *it;
+  if(conn.closing) {
+    return view.size(); // anything following the last request is discarded
+  }
+  if(idleTimeout.count() >= 0) {
+    conn.evictTodo->Shift(Clock::now() + idleTimeout);
+  }
+
+  // answer all complete requests at once
+  responses.clear();
+  size_t consumed = 0U;
+  while(!conn.closing && (consumed < view.size())) {
+    auto answered = DriverAnswer(conn, view.substr(consumed));
+    if(answered == 0U) {
+      break;
+    }
+    consumed += answered;
+  }
+  if(!responses.empty()) {
+    DriverSend(conn);
+  }
+
+  if(conn.closing) {
+    if(conn.sock->SendQueueSize() == 0U) {
+      // the ring is updated by the socket even if destroyed meanwhile
+      connections.erase(it);
+    } else {
+      auto const now = Clock::now();
+      conn.lingerEnd = (idleTimeout.count() >= 0 ? now + idleTimeout : TimePoint::max());
+      conn.evictTodo->Shift(now + lingerInterval);
+    }
+    return view.size();
+  }
+  return consumed;
+}
+
+size_t HttpServerImpl::DriverAnswer(Connection &conn, std::string_view data)
+{
+  auto const headEnd = FindHeadEnd(data, conn.scanned);
+  if(headEnd == std::string_view::npos) {
+    if(data.size() >= maxRequestSize) {
+      DriverReject(conn, 431U);
+    }
+    return 0U;
+  }
+  if(headEnd > maxRequestSize) {
+    DriverReject(conn, 431U);
+    return 0U;
+  }
+
+  HttpRequest request{};
+  auto [requestLine, headers] = SplitHead(data.substr(0U, headEnd));
+  request.headers = headers;
+
+  // method SP target SP version
+  auto const methodEnd = requestLine.find(' ');
+  auto const targetEnd = requestLine.find(' ', methodEnd + 1U);
+  if((methodEnd == 0U) || (methodEnd == std::string_view::npos) ||
+     (targetEnd == methodEnd + 1U) || (targetEnd == std::string_view::npos)) {
+    DriverReject(conn, 400U);
+    return 0U;
+  }
+  request.method = requestLine.substr(0U, methodEnd);
+  request.target = requestLine.substr(methodEnd + 1U, targetEnd - methodEnd - 1U);
+  if(auto minorVersion = ParseVersion(requestLine.substr(targetEnd + 1U))) {
+    request.minorVersion = *minorVersion;
+  } else {
+    DriverReject(conn, 505U);
+    return 0U;
+  }
+
+  if(FindHeader(headers, "Transfer-Encoding")) {
+    // chunked request bodies are not supported
+    DriverReject(conn, 501U);
+    return 0U;
+  }
+  size_t bodySize = 0U;
+  if(auto contentLength = FindHeader(headers, "Content-Length")) {
+    auto size = ParseDecimal(*contentLength);
+    if(!size) {
+      DriverReject(conn, 400U);
+      return 0U;
+    } else if(*size > maxRequestSize - headEnd) {
+      DriverReject(conn, 413U);
+      return 0U;
+    }
+    bodySize = *size;
+  }
+  if(data.size() - headEnd < bodySize) {
+    return 0U;
+  }
+  request.body = data.substr(headEnd, bodySize);
+
+  auto const connection = FindHeader(headers, "Connection");
+  bool keepAlive = (request.minorVersion > 0 ?
+                      !(connection && HasToken(*connection, "close")) :
+                      (connection && HasToken(*connection, "keep-alive")));
+
+  auto &&response = onRequest(request);
+
+  std::string_view connectionHeader;
+  if(!keepAlive) {
+    connectionHeader = closeHeader;
+    conn.closing = true;
+  } else if(request.minorVersion == 0) {
+    connectionHeader = keepAliveHeader;
+  }
+  bool const withBody = (request.method != "HEAD");
+  AppendResponse(responses, response, connectionHeader, withBody);
+  if(withBody && (response.fileSize > 0U)) {
+    DriverSendFile(conn, response);
+  }
+
+  conn.scanned = 0U;
+  return headEnd + bodySize;
+}
+
+void HttpServerImpl::DriverReject(Connection &conn, unsigned int status)
+{
+  AppendResponse(responses, ErrorResponse(status), closeHeader, true);
+  conn.closing = true;
+}
+
+void HttpServerImpl::DriverSend(Connection &conn)
+{
+  std::string_view remaining = responses;
+  if(conn.sock->SendQueueSize() == 0U) {
+    // send right away to save a poll round trip
+    auto sent = conn.sock->buff->sock->Send(
+          remaining.data(), remaining.size(),
+          Duration(0));
+    remaining.remove_prefix(sent);
+  }
+
+  if(!remaining.empty()) {
+    auto buffer = pool.Get();
+    buffer->assign(remaining);
+    (void)conn.sock->Send(std::move(buffer));
+  }
+}
+
+void HttpServerImpl::DriverSendFile(Connection &conn, HttpResponse const &response)
+{
+  // the responses so far including the head go first
+  DriverSend(conn);
+  responses.clear();
+
+  try {
+    FileSlice slice(FileDescriptor(response.filePath.c_str()), 0U, response.fileSize);
+    if(conn.sendsFiles) {
+      (void)conn.sock->SendFile(std::move(slice));
+      return;
+    }
+
+    for(size_t offset = 0U; offset < slice.size;) {
+      auto buffer = pool.Get();
+      buffer->resize(std::min(slice.size - offset, fileChunkSize));
+      for(size_t read = 0U; read < buffer->size();) {
+        read += slice.file.ReadAt(buffer->data() + read, buffer->size() - read, offset + read);
+      }
+      offset += buffer->size();
+      (void)conn.sock->Send(std::move(buffer));
+    }
+  } catch(std::exception const &) {
+    // the head announced the body already; closing tells it is incomplete
+    conn.closing = true;
+  }
+}
+
+void HttpServerImpl::DriverOnDisconnect(Connections::iterator it)
+{
+  connections.erase(it);
+}
+
+void HttpServerImpl::DriverOnEvict(Connections::iterator it)
+{
+  auto &&conn = *it;
+  if(conn.closing && (conn.sock->SendQueueSize() > 0U)) {
+    auto const now = Clock::now();
+    if(now < conn.lingerEnd) {
+      conn.evictTodo->Shift(now + lingerInterval);
+      return;
+    }
+  }
+  connections.erase(it);
+}
+
+} // namespace sockpuppet
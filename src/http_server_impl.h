@@ -0,0 +1,77 @@
+#ifndef SOCKPUPPET_HTTP_SERVER_IMPL_H
+#define SOCKPUPPET_HTTP_SERVER_IMPL_H
+
+#include "socket_async_impl.h" // for SocketAsyncImpl
+#include "sockpuppet/http_async.h" // for HttpServerAsync
+#include "todo_impl.h" // for ToDoShared
+
+#include <cstddef> // for size_t
+#include <list> // for std::list
+#include <memory> // for std::unique_ptr
+#include <string> // for std::string
+#include <string_view> // for std::string_view
+
+namespace sockpuppet {
+
+// accepts client connections and answers their requests; all state
+// is guarded by the driver's step mutex (using PauseGuard from
+// outside the driver thread) like the sockets it is made of
+struct HttpServerImpl
+{
+  using DriverShared = std::shared_ptr<Driver::DriverImpl>;
+
+  struct Connection
+  {
+    size_t scanned = 0U; // bytes of the pending request known to hold no head end
+    bool closing = false; // answered the last request; closed once sent
+    bool sendsFiles = true; // unless TLS, which encrypts in user space
+    TimePoint lingerEnd; // latest time to close while the last response is being sent
+    ToDoShared evictTodo;
+    std::unique_ptr<SocketAsyncImpl> sock; // destroyed before the ToDo above
+
+    Connection() = default;
+    Connection(Connection const &) = delete;
+    Connection(Connection &&) = delete;
+    ~Connection();
+    Connection &operator=(Connection const &) = delete;
+    Connection &operator=(Connection &&) = delete;
+  };
+  using Connections = std::list<Connection>;
+
+  std::weak_ptr<Driver::DriverImpl> driver;
+  HttpRequestHandler onRequest;
+  Duration idleTimeout;
+  size_t maxRequestSize;
+  BufferPool pool; // for responses that could not be sent right away
+  std::string responses; // of the requests of one receipt
+  Connections connections;
+  std::unique_ptr<SocketAsyncImpl> acceptor; // destroyed first to stop adding connections
+
+  HttpServerImpl(std::unique_ptr<SocketImpl> &&sock,
+                 DriverShared &driver,
+                 HttpRequestHandler onRequest,
+                 Duration idleTimeout,
+                 size_t maxRequestSize);
+  HttpServerImpl(HttpServerImpl const &) = delete;
+  HttpServerImpl(HttpServerImpl &&) = delete;
+  ~HttpServerImpl();
+  HttpServerImpl &operator=(HttpServerImpl const &) = delete;
+  HttpServerImpl &operator=(HttpServerImpl &&) = delete;
+
+  size_t ConnectionCount() const;
+
+  // in thread context of DriverImpl
+  void DriverOnConnect(SocketTcp sock);
+  size_t DriverOnReceive(Connections::iterator it, std::string_view view);
+  // returns the size of the request answered or zero if it is incomplete
+  size_t DriverAnswer(Connection &conn, std::string_view data);
+  void DriverReject(Connection &conn, unsigned int status);
+  void DriverSend(Connection &conn);
+  void DriverSendFile(Connection &conn, HttpResponse const &response);
+  void DriverOnDisconnect(Connections::iterator it);
+  void DriverOnEvict(Connections::iterator it);
+};
+
+} // namespace sockpuppet
+
+#endif // SOCKPUPPET_HTTP_SERVER_IMPL_H
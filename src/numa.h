@@ -0,0 +1,20 @@
+#ifndef SOCKPUPPET_NUMA_H
+#define SOCKPUPPET_NUMA_H
+
+#include <optional> // for std::optional
+
+namespace sockpuppet {
+
+// NUMA node of the CPU running the calling thread, if the OS tells
+std::optional<unsigned int> CurrentNumaNode();
+
+// throws if the node is unknown or binding to it is not supported
+void CheckNumaNode(unsigned int node);
+
+// restricts the calling thread to the CPUs of a NUMA node; memory it
+// touches first is then allocated on that node by the OS
+void BindToNumaNode(unsigned int node);
+
+} // namespace sockpuppet
+
+#endif // SOCKPUPPET_NUMA_H
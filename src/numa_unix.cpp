@@ -0,0 +1,112 @@
+#ifndef _WIN32
+
+#include "numa.h"
+#include "error_code.h" // for SocketError
+
+#include <stdexcept> // for std::runtime_error
+#include <system_error> // for std::system_error
+
+#ifdef __linux__
+# include <pthread.h> // for ::pthread_setaffinity_np
+# include <sched.h> // for cpu_set_t
+# include <sys/syscall.h> // for SYS_getcpu
+# include <unistd.h> // for ::syscall
+
+# include <fstream> // for std::ifstream
+# include <sstream> // for std::istringstream
+# include <string> // for std::string
+#endif // __linux__
+
+namespace sockpuppet {
+
+#ifdef __linux__
+
+namespace {
+
+// parses the list of CPUs of a node, e.g. "0-3,8-11"
+cpu_set_t NodeCpus(unsigned int node)
+{
+  std::ifstream file("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+  std::string list;
+  if(!std::getline(file, list)) {
+    throw std::runtime_error("unknown NUMA node");
+  }
+
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  std::istringstream ranges(list);
+  for(unsigned int first; ranges >> first;) {
+    auto last = first;
+    if(ranges.peek() == '-') {
+      ranges.ignore();
+      ranges >> last;
+    }
+    for(auto cpu = first; (cpu <= last) && (cpu < CPU_SETSIZE); ++cpu) {
+      CPU_SET(cpu, &cpus);
+    }
+    if(ranges.peek() == ',') {
+      ranges.ignore();
+    }
+  }
+  if(CPU_COUNT(&cpus) == 0) {
+    throw std::runtime_error("NUMA node without CPUs");
+  }
+  return cpus;
+}
+
+} // unnamed namespace
+
+std::optional<unsigned int> CurrentNumaNode()
+{
+  unsigned int cpu;
+  unsigned int node;
+#if defined(__GLIBC__) && __GLIBC_PREREQ(2, 29)
+  // served by the vDSO without entering the kernel
+  if(::getcpu(&cpu, &node) != 0) {
+#else
+  if(::syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) {
+#endif
+    return {std::nullopt};
+  }
+  return {node};
+}
+
+void CheckNumaNode(unsigned int node)
+{
+  (void)NodeCpus(node);
+}
+
+void BindToNumaNode(unsigned int node)
+{
+  auto const cpus = NodeCpus(node);
+  if(auto error = ::pthread_setaffinity_np(::pthread_self(), sizeof(cpus), &cpus)) {
+    throw std::system_error(SocketError(error),
+          "failed to bind thread to NUMA node");
+  }
+}
+
+#else
+
+// a single node, if any
+
+std::optional<unsigned int> CurrentNumaNode()
+{
+  return {std::nullopt};
+}
+
+void CheckNumaNode(unsigned int node)
+{
+  if(node != 0U) {
+    throw std::runtime_error("unknown NUMA node");
+  }
+}
+
+void BindToNumaNode(unsigned int)
+{
+}
+
+#endif // __linux__
+
+} // namespace sockpuppet
+
+#endif // _WIN32
@@ -0,0 +1,56 @@
+#ifdef _WIN32
+
+#include "numa.h"
+#include "error_code.h" // for SocketError
+
+#include <stdexcept> // for std::runtime_error
+#include <system_error> // for std::system_error
+
+#include <windows.h> // for ::GetNumaNodeProcessorMask
+
+namespace sockpuppet {
+
+namespace {
+
+// limited to the first processor group, i.e. 64 CPUs,
+// as the group-aware API is not available before Windows 7
+ULONGLONG NodeCpus(unsigned int node)
+{
+  ULONGLONG mask = 0U;
+  if((node > MAXUCHAR) ||
+     !::GetNumaNodeProcessorMask(static_cast<UCHAR>(node), &mask) ||
+     (mask == 0U)) {
+    throw std::runtime_error("unknown NUMA node");
+  }
+  return mask;
+}
+
+} // unnamed namespace
+
+std::optional<unsigned int> CurrentNumaNode()
+{
+  UCHAR node;
+  if(!::GetNumaProcessorNode(static_cast<UCHAR>(::GetCurrentProcessorNumber()), &node) ||
+     (node == MAXUCHAR)) {
+    return {std::nullopt};
+  }
+  return {node};
+}
+
+void CheckNumaNode(unsigned int node)
+{
+  (void)NodeCpus(node);
+}
+
+void BindToNumaNode(unsigned int node)
+{
+  auto const mask = NodeCpus(node);
+  if(!::SetThreadAffinityMask(::GetCurrentThread(), static_cast<DWORD_PTR>(mask))) {
+    throw std::system_error(SocketError(static_cast<int>(::GetLastError())),
+          "failed to bind thread to NUMA node");
+  }
+}
+
+} // namespace sockpuppet
+
+#endif // _WIN32
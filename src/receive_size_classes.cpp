@@ -0,0 +1,61 @@
+#include "receive_size_classes.h"
+
+#include <stdexcept> // for std::logic_error
+
+namespace sockpuppet {
+
+ReceiveSizeClasses::ReceiveSizeClasses(size_t maxSize, size_t maxCount)
+{
+  if(maxSize == 0U) {
+    throw std::logic_error("invalid receive buffer size");
+  }
+
+  for(size_t size = minSize; size < maxSize; size *= 2U) {
+    sizes.push_back(size);
+  }
+  sizes.push_back(maxSize);
+
+  // buffers are allocated on first use only to keep idle sockets lean
+  for(size_t i = 0U; i < sizes.size(); ++i) {
+    pools.emplace_back(std::make_unique<BufferPool>(maxCount, 0U));
+  }
+  counts.resize(sizes.size(), 0U);
+}
+
+ReceiveSizeClasses::~ReceiveSizeClasses() = default;
+
+size_t ReceiveSizeClasses::Select(std::optional<size_t> expected) const
+{
+  if(!expected) {
+    return defaultClass;
+  }
+
+  size_t i = 0U;
+  while((i + 1U < sizes.size()) && (sizes[i] < *expected)) {
+    ++i;
+  }
+  return i;
+}
+
+void ReceiveSizeClasses::Record(size_t received)
+{
+  ++counts[Select(received)];
+  if(++samples == decayInterval) {
+    // favour recent receipts so the default follows changing traffic
+    samples = 0U;
+    for(auto &&count : counts) {
+      samples += (count /= 2U);
+    }
+  }
+
+  // the default class fits nine out of ten recent receipts
+  size_t covered = 0U;
+  for(defaultClass = 0U; defaultClass + 1U < counts.size(); ++defaultClass) {
+    covered += counts[defaultClass];
+    if(covered * 10U >= samples * 9U) {
+      break;
+    }
+  }
+}
+
+} // namespace sockpuppet
@@ -0,0 +1,42 @@
+#ifndef SOCKPUPPET_RECEIVE_SIZE_CLASSES_H
+#define SOCKPUPPET_RECEIVE_SIZE_CLASSES_H
+
+#include "sockpuppet/socket_buffered.h" // for BufferPool
+
+#include <cstddef> // for size_t
+#include <memory> // for std::unique_ptr
+#include <optional> // for std::optional
+#include <vector> // for std::vector
+
+namespace sockpuppet {
+
+// receive buffer pools of power-of-two size classes up to a maximum size,
+// along with a decaying histogram of receipt sizes that determines
+// the class to use whenever the size of a receipt is not known in advance
+struct ReceiveSizeClasses
+{
+  static constexpr size_t minSize = 256U;
+  static constexpr size_t decayInterval = 1024U; // receipts until the histogram is halved
+
+  std::vector<size_t> sizes; // buffer size per class, the last one being the maximum
+  std::vector<std::unique_ptr<BufferPool>> pools;
+  std::vector<size_t> counts; // recent receipts per class
+  size_t samples = 0U;
+  size_t defaultClass = 0U;
+
+  ReceiveSizeClasses(size_t maxSize, size_t maxCount);
+  ReceiveSizeClasses(ReceiveSizeClasses const &) = delete;
+  ReceiveSizeClasses(ReceiveSizeClasses &&) = delete;
+  ~ReceiveSizeClasses();
+  ReceiveSizeClasses &operator=(ReceiveSizeClasses const &) = delete;
+  ReceiveSizeClasses &operator=(ReceiveSizeClasses &&) = delete;
+
+  // smallest class fitting the expected size (capped to the largest one),
+  // the default class if the size is unknown
+  size_t Select(std::optional<size_t> expected) const;
+  void Record(size_t received);
+};
+
+} // namespace sockpuppet
+
+#endif // SOCKPUPPET_RECEIVE_SIZE_CLASSES_H
@@ -0,0 +1,303 @@
+#include "relay_impl.h"
+#include "driver_impl.h" // for DriverImpl
+#include "error_code.h" // for SocketError
+#include "sigpipe.h" // for WithoutSigPipe
+#include "socket_tls_impl.h" // for SocketTlsImpl
+
+#ifdef _WIN32
+# include <winsock2.h> // for ::recv
+#else
+# include <sys/socket.h> // for ::recv
+# ifdef __linux__
+#  include <fcntl.h> // for ::splice
+#  include <unistd.h> // for ::pipe2
+# endif // __linux__
+#endif // _WIN32
+
+#include <cassert> // for assert
+#include <stdexcept> // for std::logic_error
+#include <system_error> // for std::system_error
+
+namespace sockpuppet {
+
+namespace {
+
+bool IsWouldBlock(std::error_code const &error)
+{
+  return (error == std::errc::operation_would_block) ||
+         (error == std::errc::resource_unavailable_try_again);
+}
+
+void ShutdownSend(SOCKET fd)
+{
+#ifdef _WIN32
+  if(::shutdown(fd, SD_SEND)) {
+#else
+  if(::shutdown(fd, SHUT_WR)) {
+#endif // _WIN32
+    throw std::system_error(SocketError(), "failed to shut down");
+  }
+}
+
+#ifdef __linux__
+ssize_t SpliceToSocket(int pipeFd, SOCKET fd, size_t size)
+{
+  return WithoutSigPipe([=]() {
+    return ::splice(pipeFd, nullptr,
+                    fd, nullptr,
+                    size,
+                    SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+  });
+}
+#else
+constexpr int sendFlags =
+# ifdef MSG_NOSIGNAL
+    MSG_NOSIGNAL | // avoid SIGPIPE on connection closed (in Linux)
+# endif // MSG_NOSIGNAL
+    0;
+#endif // __linux__
+
+} // unnamed namespace
+
+RelayChannel::RelayChannel(size_t capacity)
+  : capacity(capacity)
+  , forwarded(0U)
+{
+  if(capacity == 0U) {
+    throw std::logic_error("invalid relay buffer size");
+  }
+
+#ifdef __linux__
+  if(::pipe2(pipeFds, O_NONBLOCK | O_CLOEXEC)) {
+    throw std::system_error(SocketError(), "failed to create relay pipe");
+  }
+
+  // the OS limits the pipe size for unprivileged users; use what we got
+  (void)::fcntl(pipeFds[1], F_SETPIPE_SZ, static_cast<int>(capacity));
+  if(auto size = ::fcntl(pipeFds[1], F_GETPIPE_SZ); size > 0) {
+    this->capacity = static_cast<size_t>(size);
+  }
+#else
+  // not zero-initialized as it is overwritten by receipt anyway
+  buffer.reset(new char[capacity]);
+#endif // __linux__
+}
+
+RelayChannel::~RelayChannel()
+{
+#ifdef __linux__
+  (void)::close(pipeFds[0]);
+  (void)::close(pipeFds[1]);
+#endif // __linux__
+}
+
+void RelayChannel::Fill(SOCKET fd)
+{
+#ifdef __linux__
+  auto received = ::splice(fd, nullptr,
+                           pipeFds[1], nullptr,
+                           capacity - pending,
+                           SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+#else
+  assert(pending == 0U);
+  auto received = ::recv(fd,
+                         buffer.get(),
+                         static_cast<int>(capacity),
+                         0);
+#endif // __linux__
+  if(received < 0) {
+    auto error = SocketError(); // cache before risking another
+    if(!IsWouldBlock(error)) {
+      throw std::system_error(error, "failed to receive");
+    }
+    // a pipe may run out of slots before reaching its byte capacity
+    full = (pending > 0U);
+    return;
+  } else if(received == 0) {
+    eof = true;
+    return;
+  }
+
+  pending += static_cast<size_t>(received);
+#ifdef __linux__
+  full = (pending == capacity);
+#else
+  offset = 0U;
+  full = true; // the buffer is reused only once it has been forwarded completely
+#endif // __linux__
+}
+
+void RelayChannel::Drain(SOCKET fd)
+{
+#ifdef __linux__
+  auto sent = SpliceToSocket(pipeFds[0], fd, pending);
+#else
+  auto sent = ::send(fd,
+                     buffer.get() + offset,
+                     static_cast<int>(pending),
+                     sendFlags);
+#endif // __linux__
+  if(sent < 0) {
+    auto error = SocketError(); // cache before risking another
+    if(!IsWouldBlock(error)) {
+      throw std::system_error(error, "failed to send");
+    }
+    return;
+  }
+
+  assert(static_cast<size_t>(sent) <= pending);
+  pending -= static_cast<size_t>(sent);
+  forwarded += static_cast<size_t>(sent);
+#ifdef __linux__
+  full = false; // the pipe has room again
+#else
+  offset += static_cast<size_t>(sent);
+  full = (pending > 0U);
+#endif // __linux__
+}
+
+
+RelayImpl::RelayImpl(
+    std::unique_ptr<SocketImpl> &&first,
+    std::unique_ptr<SocketImpl> &&second,
+    DriverShared &driver,
+    DisconnectHandler onDisconnect,
+    size_t bufferSize)
+  : driver(driver)
+  , onDisconnect(std::move(onDisconnect))
+  , peerAddrs{first->GetPeerName(), second->GetPeerName()}
+  , channels{{bufferSize}, {bufferSize}}
+{
+#ifdef SOCKPUPPET_WITH_TLS
+  // encrypted data would have to pass through user space anyway
+  if(dynamic_cast<SocketTlsImpl *>(first.get()) ||
+     dynamic_cast<SocketTlsImpl *>(second.get())) {
+    throw std::logic_error("relay is not supported with TLS");
+  }
+#endif // SOCKPUPPET_WITH_TLS
+
+  // each end forwards to the other one, so both must be in place before polling
+  Driver::DriverImpl::PauseGuard lock(*driver);
+
+  for(size_t i = 0U; i < 2U; ++i) {
+    ends[i] = std::make_unique<SocketAsyncImpl>(
+        std::move(i == 0U ? first : second),
+        driver,
+        std::bind(&RelayImpl::DriverOnReadable, this, i),
+        std::bind(&RelayImpl::DriverOnWritable, this, i),
+        std::bind(&RelayImpl::DriverOnError, this, i, std::placeholders::_1));
+  }
+}
+
+RelayImpl::~RelayImpl()
+{
+  if(auto ptr = driver.lock()) {
+    // stop both ends at once as each one forwards to the other
+    Driver::DriverImpl::PauseGuard lock(*ptr);
+    ends[0].reset();
+    ends[1].reset();
+  }
+}
+
+size_t RelayImpl::BytesForwarded(size_t from) const
+{
+  return channels[from].forwarded;
+}
+
+void RelayImpl::DriverOnReadable(size_t i)
+{
+  auto ptr = driver.lock();
+  auto &&channel = channels[i];
+  auto const fd = ends[i]->DriverGetFd();
+
+  try {
+    channel.Fill(fd);
+  } catch(std::runtime_error const &e) {
+    DriverFinish(i, e.what());
+    return;
+  }
+  if(channel.eof && (firstEof > 1U)) {
+    firstEof = i;
+  }
+  if(channel.eof || channel.full) {
+    // apply backpressure until the opposite end has taken some data
+    ptr->AsyncWantReceive(fd, false);
+  }
+
+  // forward right away to save a poll round trip
+  try {
+    if(!DriverForward(ptr, i)) {
+      ptr->AsyncWantSend(ends[1U - i]->DriverGetFd());
+    }
+  } catch(std::runtime_error const &e) {
+    DriverFinish(1U - i, e.what());
+    return;
+  }
+  if(channels[0].done && channels[1].done) {
+    DriverFinish(firstEof, "connection closed");
+  }
+}
+
+bool RelayImpl::DriverOnWritable(size_t i)
+{
+  auto ptr = driver.lock();
+
+  bool forwarded = false;
+  try {
+    forwarded = DriverForward(ptr, 1U - i);
+  } catch(std::runtime_error const &e) {
+    DriverFinish(i, e.what());
+    return false; // the sockets have been unregistered
+  }
+  if(channels[0].done && channels[1].done) {
+    DriverFinish(firstEof, "connection closed");
+    return false; // the sockets have been unregistered
+  }
+  return forwarded;
+}
+
+void RelayImpl::DriverOnError(size_t i, char const *message)
+{
+  DriverFinish(i, message);
+}
+
+bool RelayImpl::DriverForward(DriverShared const &ptr, size_t from)
+{
+  auto &&channel = channels[from];
+  auto const to = ends[1U - from]->DriverGetFd();
+
+  if(channel.pending > 0U) {
+    auto const wasFull = channel.full;
+    channel.Drain(to);
+    if(wasFull && !channel.full && !channel.eof) {
+      ptr->AsyncWantReceive(ends[from]->DriverGetFd(), true);
+    }
+    if(channel.pending > 0U) {
+      return false;
+    }
+  }
+
+  if(channel.eof && !channel.done) {
+    // pass on the end of stream once everything before has been forwarded
+    ShutdownSend(to);
+    channel.done = true;
+  }
+  return true;
+}
+
+void RelayImpl::DriverFinish(size_t i, char const *reason)
+{
+  // a relay reports only once
+  if(auto ptr = driver.lock()) {
+    ptr->AsyncUnregister(ends[0]->DriverGetFd());
+    ptr->AsyncUnregister(ends[1]->DriverGetFd());
+  }
+
+  // the handler may destroy the relay -> hand over everything beforehand
+  auto handler = std::move(onDisconnect);
+  auto peerAddr = peerAddrs[i];
+
+  handler(Address(std::move(peerAddr)), reason);
+}
+
+} // namespace sockpuppet
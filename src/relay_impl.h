@@ -0,0 +1,80 @@
+#ifndef SOCKPUPPET_RELAY_IMPL_H
+#define SOCKPUPPET_RELAY_IMPL_H
+
+#include "socket_async_impl.h" // for SocketAsyncImpl
+#include "sockpuppet/socket_async.h" // for RelayAsync
+
+#include <atomic> // for std::atomic
+#include <cstddef> // for size_t
+#include <memory> // for std::unique_ptr
+
+namespace sockpuppet {
+
+// intermediate storage of one relay direction; a kernel pipe
+// where splice() is available, a single user-space buffer otherwise
+struct RelayChannel
+{
+  size_t capacity;
+  size_t pending = 0U; // received but not yet forwarded
+  bool full = false; // receipt paused until some data is forwarded
+  bool eof = false; // peer finished sending, to be forwarded after pending data
+  bool done = false; // end of stream has been forwarded
+  std::atomic<size_t> forwarded;
+#ifdef __linux__
+  int pipeFds[2];
+#else
+  std::unique_ptr<char[]> buffer;
+  size_t offset = 0U; // of pending data in buffer
+#endif // __linux__
+
+  RelayChannel(size_t capacity);
+  RelayChannel(RelayChannel const &) = delete;
+  RelayChannel(RelayChannel &&) = delete;
+  ~RelayChannel();
+  RelayChannel &operator=(RelayChannel const &) = delete;
+  RelayChannel &operator=(RelayChannel &&) = delete;
+
+  // assumes a readable socket
+  void Fill(SOCKET fd);
+  // does not block if the socket is not writable
+  void Drain(SOCKET fd);
+};
+
+struct RelayImpl
+{
+  using AddressShared = std::shared_ptr<Address::AddressImpl>;
+  using DriverShared = std::shared_ptr<Driver::DriverImpl>;
+
+  std::weak_ptr<Driver::DriverImpl> driver;
+  DisconnectHandler onDisconnect;
+  AddressShared peerAddrs[2]; // cached for reporting after disconnect
+  RelayChannel channels[2]; // channels[i] carries data received by ends[i]
+  std::unique_ptr<SocketAsyncImpl> ends[2]; // destroyed before the channels
+  size_t firstEof = 2U; // index of the end that finished sending first, if any
+
+  RelayImpl(std::unique_ptr<SocketImpl> &&first,
+            std::unique_ptr<SocketImpl> &&second,
+            DriverShared &driver,
+            DisconnectHandler onDisconnect,
+            size_t bufferSize);
+  RelayImpl(RelayImpl const &) = delete;
+  RelayImpl(RelayImpl &&) = delete;
+  ~RelayImpl();
+  RelayImpl &operator=(RelayImpl const &) = delete;
+  RelayImpl &operator=(RelayImpl &&) = delete;
+
+  size_t BytesForwarded(size_t from) const;
+
+  // in thread context of DriverImpl
+  void DriverOnReadable(size_t i);
+  bool DriverOnWritable(size_t i);
+  void DriverOnError(size_t i, char const *message);
+
+  /// @return  true if there is no more data to forward, false otherwise
+  bool DriverForward(DriverShared const &ptr, size_t from);
+  void DriverFinish(size_t i, char const *reason);
+};
+
+} // namespace sockpuppet
+
+#endif // SOCKPUPPET_RELAY_IMPL_H
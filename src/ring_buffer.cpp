@@ -0,0 +1,127 @@
+#include "ring_buffer.h"
+
+#ifdef __linux__
+# include <sys/mman.h> // for ::memfd_create
+# include <unistd.h> // for ::sysconf
+#endif // __linux__
+
+#include <cassert> // for assert
+#include <cstring> // for std::memmove
+#include <stdexcept> // for std::logic_error
+
+namespace sockpuppet {
+
+namespace {
+
+#ifdef __linux__
+size_t PageAligned(size_t size)
+{
+  auto const pageSize = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+  return (size + pageSize - 1U) / pageSize * pageSize;
+}
+
+// maps a memory file twice back-to-back; nullptr on failure
+char *MapTwice(size_t size)
+{
+  int fd = ::memfd_create("sockpuppet_ring", MFD_CLOEXEC);
+  if(fd < 0) {
+    return nullptr;
+  }
+
+  char *base = nullptr;
+  if(::ftruncate(fd, static_cast<off_t>(size)) == 0) {
+    // reserve the whole address range first to place both views into
+    auto reserved = ::mmap(nullptr, 2U * size,
+                           PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS,
+                           -1, 0);
+    if(reserved != MAP_FAILED) {
+      base = static_cast<char *>(reserved);
+      for(auto view : {base, base + size}) {
+        if(::mmap(view, size,
+                  PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+                  fd, 0) == MAP_FAILED) {
+          (void)::munmap(base, 2U * size);
+          base = nullptr;
+          break;
+        }
+      }
+    }
+  }
+
+  // the mappings keep the memory file alive
+  (void)::close(fd);
+  return base;
+}
+#endif // __linux__
+
+} // unnamed namespace
+
+RingBuffer::RingBuffer(size_t capacity)
+  : data(nullptr)
+  , capacity(capacity)
+  , doubleMapped(false)
+{
+  if(capacity == 0U) {
+    throw std::logic_error("invalid ring buffer size");
+  }
+
+#ifdef __linux__
+  auto const aligned = PageAligned(capacity);
+  if((data = MapTwice(aligned))) {
+    this->capacity = aligned;
+    doubleMapped = true;
+    return;
+  }
+#endif // __linux__
+
+  // not zero-initialized as it is overwritten by receipt anyway
+  data = new char[capacity];
+}
+
+RingBuffer::~RingBuffer()
+{
+#ifdef __linux__
+  if(doubleMapped) {
+    (void)::munmap(data, 2U * capacity);
+    return;
+  }
+#endif // __linux__
+  delete[] data;
+}
+
+std::string_view RingBuffer::Readable() const
+{
+  return std::string_view(data + head, size);
+}
+
+std::pair<char *, size_t> RingBuffer::Writable()
+{
+  if(doubleMapped) {
+    // the free space behind the end continues at the front
+    auto const tail = (head + size) % capacity;
+    return {data + tail, capacity - size};
+  }
+
+  if((head > 0U) && (head + size == capacity)) {
+    std::memmove(data, data + head, size);
+    head = 0U;
+  }
+  return {data + head + size, capacity - head - size};
+}
+
+void RingBuffer::Commit(size_t received)
+{
+  assert(size + received <= capacity);
+  size += received;
+}
+
+void RingBuffer::Consume(size_t consumed)
+{
+  if(consumed > size) {
+    throw std::logic_error("consumed more than received");
+  }
+  size -= consumed;
+  head = (size == 0U ? 0U : (head + consumed) % capacity);
+}
+
+} // namespace sockpuppet
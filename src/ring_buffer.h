@@ -0,0 +1,38 @@
+#ifndef SOCKPUPPET_RING_BUFFER_H
+#define SOCKPUPPET_RING_BUFFER_H
+
+#include <cstddef> // for size_t
+#include <string_view> // for std::string_view
+#include <utility> // for std::pair
+
+namespace sockpuppet {
+
+// contiguous receive storage where data is appended at the back and
+// consumed from the front; where supported, the memory is mapped twice
+// back-to-back so data wrapping around the end stays contiguous,
+// otherwise unconsumed data is moved to the front once the end is reached
+struct RingBuffer
+{
+  char *data;
+  size_t capacity;
+  size_t head = 0U; // offset of the first unconsumed byte
+  size_t size = 0U; // number of unconsumed bytes
+  bool doubleMapped;
+
+  RingBuffer(size_t capacity);
+  RingBuffer(RingBuffer const &) = delete;
+  RingBuffer(RingBuffer &&) = delete;
+  ~RingBuffer();
+  RingBuffer &operator=(RingBuffer const &) = delete;
+  RingBuffer &operator=(RingBuffer &&) = delete;
+
+  std::string_view Readable() const;
+  // contiguous free space to receive into; empty if the ring is full
+  std::pair<char *, size_t> Writable();
+  void Commit(size_t received);
+  void Consume(size_t consumed);
+};
+
+} // namespace sockpuppet
+
+#endif // SOCKPUPPET_RING_BUFFER_H
@@ -0,0 +1,172 @@
+#include "shared_buffer_pool_impl.h"
+
+#include <algorithm> // for std::find
+#include <cassert> // for assert
+#include <stdexcept> // for std::logic_error
+#include <utility> // for std::exchange
+
+namespace sockpuppet {
+
+BufferShare::BufferShare(SharedBufferPoolImpl &pool)
+  : pool(pool)
+{
+}
+
+void ShareDetacher::operator()(BufferShare *share) const
+{
+  assert(share);
+  share->pool.Detach(*share);
+}
+
+
+SharedBufferPoolImpl::SharedBufferPoolImpl(size_t budget, size_t bufferSize)
+  : bufferSize(bufferSize)
+  , capacity(bufferSize ? budget / bufferSize : 0U)
+{
+  if(capacity == 0U) {
+    throw std::logic_error("buffer budget does not cover a single buffer");
+  }
+}
+
+SharedBufferPoolImpl::~SharedBufferPoolImpl()
+{
+  // buffers still pending -> will segfault later
+  // make sure pool is released after all of its users
+  assert(shares.empty());
+}
+
+ShareUnique SharedBufferPoolImpl::Attach()
+{
+  std::lock_guard<std::mutex> lock(mtx);
+
+  auto it = shares.emplace(shares.end(), *this);
+  it->self = it;
+  ++attachedCount;
+  return ShareUnique(&*it);
+}
+
+void SharedBufferPoolImpl::Detach(BufferShare &share)
+{
+  std::vector<std::function<void()>> resumable;
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+
+    if(share.onAvailable) {
+      deferred.erase(std::find(deferred.begin(), deferred.end(), &share));
+    }
+    share.attached = false;
+    --attachedCount;
+    if(share.held == 0U) {
+      shares.erase(share.self);
+    } // else erased once its last buffer is released
+
+    // the remaining sockets get a larger share
+    resumable = TakeResumable();
+  }
+  for(auto &&onAvailable : resumable) {
+    onAvailable();
+  }
+}
+
+std::optional<BufferPtr> SharedBufferPoolImpl::Get(BufferShare &share, Duration timeout)
+{
+  std::unique_lock<std::mutex> lock(mtx);
+
+  auto mayObtain = [this, &share]() { return MayObtain(share); };
+  if(!mayObtain()) {
+    ++deferrals;
+  }
+  if(timeout.count() < 0) {
+    releasedCv.wait(lock, mayObtain);
+  } else if(!releasedCv.wait_for(lock, timeout, mayObtain)) {
+    return {std::nullopt};
+  }
+  return Obtain(share);
+}
+
+std::optional<BufferPtr> SharedBufferPoolImpl::GetOrDefer(BufferShare &share,
+    std::function<void()> onAvailable)
+{
+  std::lock_guard<std::mutex> lock(mtx);
+
+  if(MayObtain(share)) {
+    return Obtain(share);
+  }
+  if(!share.onAvailable) {
+    deferred.push_back(&share);
+    ++deferrals;
+  }
+  share.onAvailable = std::move(onAvailable);
+  return {std::nullopt};
+}
+
+void SharedBufferPoolImpl::Released(BufferShare &share)
+{
+  std::vector<std::function<void()>> resumable;
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+
+    --busy;
+    --share.held;
+    if(!share.attached && (share.held == 0U)) {
+      shares.erase(share.self);
+    }
+    resumable = TakeResumable();
+  }
+  releasedCv.notify_all();
+
+  // resuming takes the lock of the driver, which may be
+  // waiting for the lock of the pool to obtain a buffer
+  for(auto &&onAvailable : resumable) {
+    onAvailable();
+  }
+}
+
+BufferPoolStats SharedBufferPoolImpl::Stats()
+{
+  auto stats = pool.Stats();
+  std::lock_guard<std::mutex> lock(mtx);
+  stats.exhaustions += deferrals;
+  return stats;
+}
+
+size_t SharedBufferPoolImpl::FairShare() const
+{
+  auto const share = capacity / std::max<size_t>(attachedCount, 1U);
+  return std::max<size_t>(share, 1U);
+}
+
+bool SharedBufferPoolImpl::MayObtain(BufferShare const &share) const
+{
+  return (busy < capacity) && (share.held < FairShare());
+}
+
+BufferPtr SharedBufferPoolImpl::Obtain(BufferShare &share)
+{
+  auto buffer = pool.Get(share);
+  ++busy;
+  ++share.held;
+  return buffer;
+}
+
+std::vector<std::function<void()>> SharedBufferPoolImpl::TakeResumable()
+{
+  std::vector<std::function<void()>> resumable;
+
+  // don't wake more sockets than there are buffers to obtain
+  auto available = capacity - busy;
+  auto const fairShare = FairShare();
+  for(auto it = deferred.begin(); (it != deferred.end()) && (available > 0U);) {
+    auto &&share = **it;
+    if(share.held < fairShare) {
+      resumable.push_back(std::exchange(share.onAvailable, nullptr));
+      it = deferred.erase(it);
+      --available;
+    } else {
+      ++it;
+    }
+  }
+  return resumable;
+}
+
+} // namespace sockpuppet
@@ -0,0 +1,85 @@
+#ifndef SOCKPUPPET_SHARED_BUFFER_POOL_IMPL_H
+#define SOCKPUPPET_SHARED_BUFFER_POOL_IMPL_H
+
+#include "sockpuppet/socket_buffered.h" // for BufferPool
+
+#include <condition_variable> // for std::condition_variable
+#include <cstddef> // for size_t
+#include <deque> // for std::deque
+#include <functional> // for std::function
+#include <list> // for std::list
+#include <memory> // for std::unique_ptr
+#include <mutex> // for std::mutex
+#include <optional> // for std::optional
+#include <vector> // for std::vector
+
+namespace sockpuppet {
+
+// the part of a socket in a shared pool; kept by the pool until
+// the socket is gone and all of its buffers have been released
+struct BufferShare
+{
+  SharedBufferPoolImpl &pool;
+  std::list<BufferShare>::iterator self;
+  size_t held = 0U; // buffers obtained and not yet released
+  bool attached = true; // false once the socket is gone
+  std::function<void()> onAvailable; // resumes a deferred socket; empty unless deferred
+
+  BufferShare(SharedBufferPoolImpl &pool);
+};
+
+// detaches the share of a socket from its pool on destruction
+struct ShareDetacher
+{
+  void operator()(BufferShare *share) const;
+};
+using ShareUnique = std::unique_ptr<BufferShare, ShareDetacher>;
+
+// buffers within a byte budget, split evenly between the sockets;
+// all state is guarded by the mutex, except for the buffers themselves
+struct SharedBufferPoolImpl
+{
+  size_t bufferSize;
+  size_t capacity; // number of buffers within the budget
+  BufferPool pool; // grows up to capacity as needed
+  std::mutex mtx;
+  std::condition_variable releasedCv; // for blocking receipt
+  size_t busy = 0U; // buffers obtained and not yet released
+  size_t attachedCount = 0U;
+  std::list<BufferShare> shares;
+  std::deque<BufferShare *> deferred; // oldest first
+  size_t deferrals = 0U; // receipts that had to wait for a buffer
+
+  SharedBufferPoolImpl(size_t budget, size_t bufferSize);
+  SharedBufferPoolImpl(SharedBufferPoolImpl const &) = delete;
+  SharedBufferPoolImpl(SharedBufferPoolImpl &&) = delete;
+  ~SharedBufferPoolImpl();
+  SharedBufferPoolImpl &operator=(SharedBufferPoolImpl const &) = delete;
+  SharedBufferPoolImpl &operator=(SharedBufferPoolImpl &&) = delete;
+
+  ShareUnique Attach();
+  void Detach(BufferShare &share);
+
+  // waits for a buffer to become available within timeout
+  std::optional<BufferPtr> Get(BufferShare &share, Duration timeout);
+  // if no buffer is available, onAvailable is called (from the thread releasing
+  // a buffer, without lock held) once the share may obtain one again
+  std::optional<BufferPtr> GetOrDefer(BufferShare &share,
+                                      std::function<void()> onAvailable);
+  // called for every buffer returned to the pool
+  void Released(BufferShare &share);
+
+  // counts deferred receipts as exhaustions of the pool
+  BufferPoolStats Stats();
+
+  // with mtx held
+  size_t FairShare() const;
+  bool MayObtain(BufferShare const &share) const;
+  BufferPtr Obtain(BufferShare &share);
+  // removes deferred sockets that may obtain a buffer now, oldest first
+  std::vector<std::function<void()>> TakeResumable();
+};
+
+} // namespace sockpuppet
+
+#endif // SOCKPUPPET_SHARED_BUFFER_POOL_IMPL_H
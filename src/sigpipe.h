@@ -0,0 +1,50 @@
+#ifndef SOCKPUPPET_SIGPIPE_H
+#define SOCKPUPPET_SIGPIPE_H
+
+#ifdef __linux__
+
+#include <pthread.h> // for ::pthread_sigmask
+#include <signal.h> // for ::sigtimedwait
+
+#include <cerrno> // for errno
+
+namespace sockpuppet {
+
+inline bool IsSigPipePending()
+{
+  sigset_t pending;
+  return (::sigpending(&pending) == 0) && (::sigismember(&pending, SIGPIPE) == 1);
+}
+
+// system calls like splice() or sendfile() have no MSG_NOSIGNAL equivalent;
+// keep a connection closed by the peer from raising SIGPIPE by blocking it
+// during the call and discarding it if raised, so only EPIPE remains
+// (a partial send may raise it as well, while still reporting success)
+template<typename Fn>
+auto WithoutSigPipe(Fn &&fn) -> decltype(fn())
+{
+  sigset_t pipeSet;
+  (void)::sigemptyset(&pipeSet);
+  (void)::sigaddset(&pipeSet, SIGPIPE);
+  sigset_t oldSet;
+  (void)::pthread_sigmask(SIG_BLOCK, &pipeSet, &oldSet);
+
+  // one already pending while blocked by the caller is not ours to discard
+  bool const wasPending = IsSigPipePending();
+  auto res = fn();
+  auto const error = errno;
+  if(!wasPending && IsSigPipePending()) {
+    timespec const zeroTimeout{};
+    (void)::sigtimedwait(&pipeSet, nullptr, &zeroTimeout);
+  }
+
+  (void)::pthread_sigmask(SIG_SETMASK, &oldSet, nullptr);
+  errno = error;
+  return res;
+}
+
+} // namespace sockpuppet
+
+#endif // __linux__
+
+#endif // SOCKPUPPET_SIGPIPE_H
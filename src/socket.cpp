@@ -7,10 +7,27 @@
 # include <winsock2.h> // for IPPROTO_UDP
 #else
 # include <arpa/inet.h> // for IPPROTO_UDP
+# include <netinet/tcp.h> // for TCP_QUICKACK
 #endif // _WIN32
 
 namespace sockpuppet {
 
+TcpOptions TcpOptions::LowLatency()
+{
+  using namespace std::chrono;
+
+  TcpOptions options;
+  options.noDelay = true;
+#ifdef TCP_QUICKACK
+  options.quickAck = true;
+#endif // TCP_QUICKACK
+  options.keepAlive = true;
+  options.keepAliveIdle = seconds(10);
+  options.keepAliveInterval = seconds(2);
+  options.keepAliveCount = 3;
+  return options;
+}
+
 SocketUdp::SocketUdp(Address const &bindAddress)
   : impl(std::make_unique<SocketImpl>(
       bindAddress.impl->Family(), SOCK_DGRAM, IPPROTO_UDP))
@@ -49,6 +66,31 @@ SocketUdp::~SocketUdp() = default;
 SocketUdp &SocketUdp::operator=(SocketUdp &&other) noexcept = default;
 
 
+#ifdef SOCKPUPPET_WITH_TLS
+TlsContext::TlsContext(char const *certFilePath, char const *keyFilePath,
+    TlsSessionOptions const &options)
+  : impl(std::make_shared<TlsContextImpl>(certFilePath, keyFilePath, options))
+{
+}
+
+TlsContext TlsContext::FromMemory(std::string_view certPem, std::string_view keyPem,
+    TlsSessionOptions const &options)
+{
+  return TlsContext(std::make_shared<TlsContextImpl>(certPem, keyPem, options));
+}
+
+TlsSessionStats TlsContext::SessionStats() const
+{
+  return impl->Stats();
+}
+
+TlsContext::TlsContext(std::shared_ptr<TlsContextImpl> other)
+  : impl(std::move(other))
+{
+}
+#endif // SOCKPUPPET_WITH_TLS
+
+
 SocketTcp::SocketTcp(Address const &connectAddress)
   : impl(std::make_unique<SocketImpl>(
       connectAddress.impl->Family(), SOCK_STREAM, IPPROTO_TCP))
@@ -69,6 +111,16 @@ SocketTcp::SocketTcp(Address const &connectAddress,
   impl->Connect(connectAddress.impl->ForTcp());
   impl->SetSockOptNonBlocking();
 }
+
+SocketTcp::SocketTcp(Address const &connectAddress, TlsContext const &context)
+  : impl(std::make_unique<SocketTlsImpl>(
+      connectAddress.impl->Family(), SOCK_STREAM, IPPROTO_TCP,
+      context.impl))
+{
+  impl->SetSockOptNoSigPipe();
+  impl->Connect(connectAddress.impl->ForTcp());
+  impl->SetSockOptNonBlocking();
+}
 #endif // SOCKPUPPET_WITH_TLS
 
 size_t SocketTcp::Send(char const *data, size_t size, Duration timeout)
@@ -76,6 +128,20 @@ size_t SocketTcp::Send(char const *data, size_t size, Duration timeout)
   return impl->Send(data, size, timeout);
 }
 
+size_t SocketTcp::SendFile(char const *filePath, size_t offset,
+    std::optional<size_t> size, Duration timeout)
+{
+  FileSlice slice(FileDescriptor(filePath), offset, size);
+  return impl->SendFile(slice, timeout);
+}
+
+size_t SocketTcp::SendFile(int fileDescriptor, size_t offset,
+    std::optional<size_t> size, Duration timeout)
+{
+  FileSlice slice(FileDescriptor(fileDescriptor), offset, size);
+  return impl->SendFile(slice, timeout);
+}
+
 std::optional<size_t> SocketTcp::Receive(char *data, size_t size, Duration timeout)
 {
   return impl->Receive(data, size, timeout);
@@ -96,6 +162,16 @@ size_t SocketTcp::ReceiveBufferSize() const
   return impl->GetSockOptRcvBuf();
 }
 
+void SocketTcp::SetOptions(TcpOptions const &options)
+{
+  impl->SetSockOptTcp(options);
+}
+
+TcpInfo SocketTcp::Info() const
+{
+  return impl->GetSockOptTcpInfo();
+}
+
 SocketTcp::SocketTcp(std::unique_ptr<SocketImpl> &&other)
   : impl(std::move(other))
 {
@@ -130,6 +206,16 @@ Acceptor::Acceptor(Address const &bindAddress,
   impl->Bind(bindAddress.impl->ForTcp());
   impl->SetSockOptNonBlocking();
 }
+
+Acceptor::Acceptor(Address const &bindAddress, TlsContext const &context)
+  : impl(std::make_unique<AcceptorTlsImpl>(
+      bindAddress.impl->Family(), SOCK_STREAM, IPPROTO_TCP,
+      context.impl))
+{
+  impl->SetSockOptReuseAddr();
+  impl->Bind(bindAddress.impl->ForTcp());
+  impl->SetSockOptNonBlocking();
+}
 #endif // SOCKPUPPET_WITH_TLS
 
 std::optional<std::pair<SocketTcp, Address>>
@@ -144,6 +230,11 @@ Address Acceptor::LocalAddress() const
   return Address(impl->GetSockName());
 }
 
+void Acceptor::SetOptions(TcpOptions const &options)
+{
+  impl->SetSockOptTcp(options);
+}
+
 Acceptor::Acceptor(Acceptor &&other) noexcept = default;
 
 Acceptor::~Acceptor() = default;
@@ -1,5 +1,9 @@
 #include "sockpuppet/socket_async.h"
+#include "address_impl.h" // for Address::AddressImpl
+#include "connection_pool_impl.h" // for ConnectionPoolImpl
+#include "connector_async_impl.h" // for ConnectorAsyncImpl
 #include "driver_impl.h" // for DriverImpl
+#include "relay_impl.h" // for RelayImpl
 #include "socket_async_impl.h" // for SocketAsyncImpl
 #include "todo_impl.h" // for ToDoImpl
 
@@ -8,6 +12,14 @@
 namespace sockpuppet {
 
 namespace {
+  std::unique_ptr<SocketBufferedImpl> &checked(std::unique_ptr<SocketBufferedImpl> &buff)
+  {
+    if(!buff->ring) {
+      throw std::logic_error("receive ring is not enabled");
+    }
+    return buff;
+  }
+
   template<typename Fn>
   std::function<Fn> &checked(std::function<Fn> &handler)
   {
@@ -19,10 +31,18 @@ namespace {
 } // unnamed namespace
 
 Driver::Driver()
-  : impl(std::make_shared<DriverImpl>())
+  : impl(std::make_shared<DriverImpl>(std::pmr::get_default_resource()))
 {
 }
 
+Driver::Driver(std::pmr::memory_resource *resource)
+  : impl(std::make_shared<DriverImpl>(resource))
+{
+  if(!resource) {
+    throw std::logic_error("invalid memory resource");
+  }
+}
+
 void Driver::Step(Duration timeout)
 {
   impl->Step(timeout);
@@ -38,6 +58,16 @@ void Driver::Stop()
   impl->Stop();
 }
 
+std::optional<unsigned int> Driver::NumaNode() const
+{
+  return impl->NumaNode();
+}
+
+void Driver::SetNumaNode(unsigned int node)
+{
+  impl->SetNumaNode(node);
+}
+
 Driver::Driver(Driver &&other) noexcept = default;
 
 Driver::~Driver() = default;
@@ -93,6 +123,16 @@ SocketUdpAsync::SocketUdpAsync(SocketUdpBuffered &&buff,
 {
 }
 
+SocketUdpAsync::SocketUdpAsync(SocketUdpBuffered &&buff, Driver &driver,
+    ReceiveIntoProvider provideReceive, ReceiveFromIntoHandler handleReceiveFrom)
+  : impl(std::make_unique<SocketAsyncImpl>(
+      std::move(buff.impl),
+      driver.impl,
+      std::move(checked(provideReceive)),
+      std::move(checked(handleReceiveFrom))))
+{
+}
+
 std::future<void> SocketUdpAsync::SendTo(BufferPtr &&buffer,
     Address const &dstAddress)
 {
@@ -104,6 +144,11 @@ Address SocketUdpAsync::LocalAddress() const
   return Address(impl->buff->sock->GetSockName());
 }
 
+BufferPoolStats SocketUdpAsync::ReceiveBufferStats() const
+{
+  return impl->buff->Stats();
+}
+
 SocketUdpAsync::SocketUdpAsync(SocketUdpAsync &&other) noexcept = default;
 
 SocketUdpAsync::~SocketUdpAsync() = default;
@@ -121,11 +166,56 @@ SocketTcpAsync::SocketTcpAsync(SocketTcpBuffered &&buff, Driver &driver,
 {
 }
 
+SocketTcpAsync::SocketTcpAsync(SocketTcpBuffered &&buff, Driver &driver,
+    ReceiveViewHandler handleReceive, DisconnectHandler handleDisconnect)
+  : impl(std::make_unique<SocketAsyncImpl>(
+      std::move(checked(buff.impl)),
+      driver.impl,
+      std::move(checked(handleReceive)),
+      std::move(checked(handleDisconnect))))
+{
+}
+
+SocketTcpAsync::SocketTcpAsync(SocketTcpBuffered &&buff, Driver &driver,
+    ReceiveIntoProvider provideReceive, ReceiveIntoHandler handleReceive,
+    DisconnectHandler handleDisconnect)
+  : impl(std::make_unique<SocketAsyncImpl>(
+      std::move(buff.impl),
+      driver.impl,
+      std::move(checked(provideReceive)),
+      std::move(checked(handleReceive)),
+      std::move(checked(handleDisconnect))))
+{
+}
+
 std::future<void> SocketTcpAsync::Send(BufferPtr &&buffer)
 {
   return impl->Send(std::move(buffer));
 }
 
+std::future<void> SocketTcpAsync::Send(SharedBufferPtr buffer)
+{
+  return impl->Send(std::move(buffer));
+}
+
+std::future<void> SocketTcpAsync::Send(BufferPtr &&header,
+    BufferPtr &&payload)
+{
+  return impl->Send(std::move(header), std::move(payload));
+}
+
+std::future<void> SocketTcpAsync::SendFile(char const *filePath,
+    size_t offset, std::optional<size_t> size)
+{
+  return impl->SendFile(FileSlice(FileDescriptor(filePath), offset, size));
+}
+
+std::future<void> SocketTcpAsync::SendFile(int fileDescriptor,
+    size_t offset, std::optional<size_t> size)
+{
+  return impl->SendFile(FileSlice(FileDescriptor(fileDescriptor), offset, size));
+}
+
 Address SocketTcpAsync::LocalAddress() const
 {
   return Address(impl->buff->sock->GetSockName());
@@ -136,6 +226,31 @@ Address SocketTcpAsync::PeerAddress() const
   return Address(impl->buff->sock->GetPeerName());
 }
 
+void SocketTcpAsync::SetOptions(TcpOptions const &options)
+{
+  impl->buff->sock->SetSockOptTcp(options);
+}
+
+TcpInfo SocketTcpAsync::Info() const
+{
+  return impl->buff->sock->GetSockOptTcpInfo();
+}
+
+size_t SocketTcpAsync::SendQueueSize() const
+{
+  return impl->SendQueueSize();
+}
+
+BufferPoolStats SocketTcpAsync::ReceiveBufferStats() const
+{
+  return impl->buff->Stats();
+}
+
+void SocketTcpAsync::EnableZeroCopy()
+{
+  impl->EnableZeroCopy();
+}
+
 SocketTcpAsync::SocketTcpAsync(SocketTcpAsync &&other) noexcept = default;
 
 SocketTcpAsync::~SocketTcpAsync() = default;
@@ -157,10 +272,153 @@ Address AcceptorAsync::LocalAddress() const
   return Address(impl->buff->sock->GetSockName());
 }
 
+void AcceptorAsync::SetOptions(TcpOptions const &options)
+{
+  impl->buff->sock->SetSockOptTcp(options);
+}
+
 AcceptorAsync::AcceptorAsync(AcceptorAsync &&other) noexcept = default;
 
 AcceptorAsync::~AcceptorAsync() = default;
 
 AcceptorAsync &AcceptorAsync::operator=(AcceptorAsync &&other) noexcept = default;
 
+
+ConnectorAsync::ConnectorAsync(Address const &connectAddress, Driver &driver,
+    ConnectHandler handleConnect, ConnectErrorHandler handleError,
+    Duration timeout)
+  : impl(std::make_unique<ConnectorAsyncImpl>(
+      driver.impl,
+      ConnectorAsyncImpl::TcpSocketFactory(),
+      connectAddress.impl,
+      std::move(checked(handleConnect)),
+      std::move(checked(handleError)),
+      timeout))
+{
+}
+
+#ifdef SOCKPUPPET_WITH_TLS
+ConnectorAsync::ConnectorAsync(Address const &connectAddress, Driver &driver,
+    ConnectHandler handleConnect, ConnectErrorHandler handleError,
+    Duration timeout, char const *certFilePath, char const *keyFilePath)
+  : impl(std::make_unique<ConnectorAsyncImpl>(
+      driver.impl,
+      ConnectorAsyncImpl::TlsSocketFactory(certFilePath, keyFilePath),
+      connectAddress.impl,
+      std::move(checked(handleConnect)),
+      std::move(checked(handleError)),
+      timeout))
+{
+}
+#endif // SOCKPUPPET_WITH_TLS
+
+ConnectorAsync::ConnectorAsync(ConnectorAsync &&other) noexcept = default;
+
+ConnectorAsync::~ConnectorAsync() = default;
+
+ConnectorAsync &ConnectorAsync::operator=(ConnectorAsync &&other) noexcept = default;
+
+
+std::future<void> SocketTcpLease::Send(BufferPtr &&buffer)
+{
+  return impl->conn->sock->Send(std::move(buffer));
+}
+
+Address SocketTcpLease::LocalAddress() const
+{
+  return Address(impl->conn->sock->buff->sock->GetSockName());
+}
+
+Address SocketTcpLease::PeerAddress() const
+{
+  return Address(impl->conn->sock->buff->sock->GetPeerName());
+}
+
+void SocketTcpLease::Discard()
+{
+  impl->reusable = false;
+}
+
+SocketTcpLease::SocketTcpLease(std::unique_ptr<LeaseImpl> &&other)
+  : impl(std::move(other))
+{
+}
+
+SocketTcpLease::SocketTcpLease(SocketTcpLease &&other) noexcept = default;
+
+SocketTcpLease::~SocketTcpLease() = default;
+
+SocketTcpLease &SocketTcpLease::operator=(SocketTcpLease &&other) noexcept = default;
+
+
+ConnectionPool::ConnectionPool(Driver &driver, size_t maxPerHost,
+    Duration idleTimeout, Duration connectTimeout)
+  : impl(std::make_shared<ConnectionPoolImpl>(
+      driver.impl,
+      ConnectorAsyncImpl::TcpSocketFactory(),
+      maxPerHost,
+      idleTimeout,
+      connectTimeout))
+{
+}
+
+#ifdef SOCKPUPPET_WITH_TLS
+ConnectionPool::ConnectionPool(Driver &driver, size_t maxPerHost,
+    Duration idleTimeout, Duration connectTimeout,
+    char const *certFilePath, char const *keyFilePath)
+  : impl(std::make_shared<ConnectionPoolImpl>(
+      driver.impl,
+      ConnectorAsyncImpl::TlsSocketFactory(certFilePath, keyFilePath),
+      maxPerHost,
+      idleTimeout,
+      connectTimeout))
+{
+}
+#endif // SOCKPUPPET_WITH_TLS
+
+void ConnectionPool::Acquire(Address const &connectAddress,
+    ReceiveHandler handleReceive, DisconnectHandler handleDisconnect,
+    LeaseHandler handleLease, ConnectErrorHandler handleError)
+{
+  impl->Acquire(connectAddress,
+      std::make_shared<ConnectionPoolImpl::Lessee>(ConnectionPoolImpl::Lessee{
+        std::move(checked(handleReceive)),
+        std::move(checked(handleDisconnect)),
+        std::move(checked(handleLease)),
+        std::move(checked(handleError))}));
+}
+
+ConnectionPool::ConnectionPool(ConnectionPool &&other) noexcept = default;
+
+ConnectionPool::~ConnectionPool() = default;
+
+ConnectionPool &ConnectionPool::operator=(ConnectionPool &&other) noexcept = default;
+
+RelayAsync::RelayAsync(SocketTcp &&first, SocketTcp &&second,
+    Driver &driver, DisconnectHandler handleDisconnect, size_t bufferSize)
+  : impl(std::make_unique<RelayImpl>(
+      std::move(first.impl),
+      std::move(second.impl),
+      driver.impl,
+      std::move(checked(handleDisconnect)),
+      bufferSize))
+{
+}
+
+size_t RelayAsync::ForwardedToSecond() const
+{
+  return impl->BytesForwarded(0U);
+}
+
+size_t RelayAsync::ForwardedToFirst() const
+{
+  return impl->BytesForwarded(1U);
+}
+
+RelayAsync::RelayAsync(RelayAsync &&other) noexcept = default;
+
+RelayAsync::~RelayAsync() = default;
+
+RelayAsync &RelayAsync::operator=(RelayAsync &&other) noexcept = default;
+
 } // namespace sockpuppet
@@ -1,12 +1,72 @@
 #include "socket_async_impl.h"
 #include "driver_impl.h" // for DriverImpl
 
+#include <algorithm> // for std::min
 #include <cassert> // for assert
+#include <cstddef> // for std::byte
+#include <exception> // for std::current_exception
+#include <memory_resource> // for std::pmr::polymorphic_allocator
 #include <stdexcept> // for std::runtime_error
+#include <string> // for std::string
+#include <system_error> // for std::system_error
 #include <type_traits> // for std::is_same_v
 
 namespace sockpuppet {
 
+namespace {
+
+size_t PayloadSize(BufferPtr const &buffer)
+{
+  return buffer->size();
+}
+
+size_t PayloadSize(SocketAsyncImpl::BufferPair const &pair)
+{
+  return pair.first->size() + pair.second->size();
+}
+
+size_t PayloadSize(FileSlice const &slice)
+{
+  return slice.size;
+}
+
+size_t PayloadSize(SocketAsyncImpl::SharedSlice const &slice)
+{
+  return slice.buffer->size() - slice.offset;
+}
+
+} // unnamed namespace
+
+SocketAsyncImpl::ZeroCopy::ZeroCopy(std::pmr::memory_resource *resource)
+  : inFlight(resource)
+  , completedAhead(resource)
+{
+}
+
+bool SocketAsyncImpl::ZeroCopy::Complete(uint32_t first, uint32_t last)
+{
+  // sequence numbers wrap around; compare by distance
+  auto isBefore = [](uint32_t lhs, uint32_t rhs) {
+    return static_cast<int32_t>(lhs - rhs) < 0;
+  };
+
+  bool advanced = false;
+  completedAhead.emplace_back(first, last);
+  for(auto it = completedAhead.begin(); it != completedAhead.end();) {
+    if(isBefore(completedSeq, it->first)) {
+      ++it; // still a gap of sends not reported yet
+      continue;
+    }
+    if(!isBefore(it->second, completedSeq)) {
+      completedSeq = it->second + 1U;
+      advanced = true;
+    }
+    completedAhead.erase(it);
+    it = completedAhead.begin(); // earlier ranges may have become adjacent
+  }
+  return advanced;
+}
+
 // UDP socket with ReceiveFrom and SendTo
 SocketAsyncImpl::SocketAsyncImpl(
     std::unique_ptr<SocketBufferedImpl> &&buff,
@@ -14,13 +74,15 @@ SocketAsyncImpl::SocketAsyncImpl(
     ReceiveFromHandler onReceiveFrom)
   : buff(std::move(buff))
   , driver(driver)
+  , resource(driver->resource)
   , onReadable(std::bind(
       &SocketAsyncImpl::DriverReceiveFrom,
       this,
       std::move(onReceiveFrom)))
   , onError([](char const *) {}) // silently discard UDP receive errors
-  , sendQ(std::in_place_type<SendToQ>)
+  , sendQ(std::in_place_type<SendToQ>, SendToQ::container_type::allocator_type(resource))
 {
+  this->buff->onAvailable = std::bind(&SocketAsyncImpl::ResumeReceive, this->driver, this);
   driver->AsyncRegister(*this);
 }
 
@@ -32,6 +94,7 @@ SocketAsyncImpl::SocketAsyncImpl(
     DisconnectHandler onDisconnect)
   : buff(std::move(buff))
   , driver(driver)
+  , resource(driver->resource)
   , onReadable(std::bind(
       &SocketAsyncImpl::DriverReceive,
       this,
@@ -42,7 +105,78 @@ SocketAsyncImpl::SocketAsyncImpl(
       std::move(onDisconnect),
       this->buff->sock->GetPeerName(), // cache remote address now before disconnect
       std::placeholders::_1))
-  , sendQ(std::in_place_type<SendQ>)
+  , sendQ(std::in_place_type<SendQ>, SendQ::container_type::allocator_type(resource))
+{
+  this->buff->onAvailable = std::bind(&SocketAsyncImpl::ResumeReceive, this->driver, this);
+  driver->AsyncRegister(*this);
+}
+
+// TCP socket with Receive into ring and Send
+SocketAsyncImpl::SocketAsyncImpl(
+    std::unique_ptr<SocketBufferedImpl> &&buff,
+    DriverShared &driver,
+    ReceiveViewHandler onReceiveView,
+    DisconnectHandler onDisconnect)
+  : buff(std::move(buff))
+  , driver(driver)
+  , resource(driver->resource)
+  , onReadable(std::bind(
+      &SocketAsyncImpl::DriverReceiveView,
+      this,
+      std::move(onReceiveView)))
+  , onError(std::bind(
+      &SocketAsyncImpl::DriverDisconnect,
+      this,
+      std::move(onDisconnect),
+      this->buff->sock->GetPeerName(), // cache remote address now before disconnect
+      std::placeholders::_1))
+  , sendQ(std::in_place_type<SendQ>, SendQ::container_type::allocator_type(resource))
+{
+  driver->AsyncRegister(*this);
+}
+
+// UDP socket with ReceiveFrom into user memory and SendTo
+SocketAsyncImpl::SocketAsyncImpl(
+    std::unique_ptr<SocketBufferedImpl> &&buff,
+    DriverShared &driver,
+    ReceiveIntoProvider provideReceive,
+    ReceiveFromIntoHandler onReceiveFrom)
+  : buff(std::move(buff))
+  , driver(driver)
+  , resource(driver->resource)
+  , onReadable(std::bind(
+      &SocketAsyncImpl::DriverReceiveFromInto,
+      this,
+      std::move(provideReceive),
+      std::move(onReceiveFrom)))
+  , onError([](char const *) {}) // silently discard UDP receive errors
+  , sendQ(std::in_place_type<SendToQ>, SendToQ::container_type::allocator_type(resource))
+{
+  driver->AsyncRegister(*this);
+}
+
+// TCP socket with Receive into user memory and Send
+SocketAsyncImpl::SocketAsyncImpl(
+    std::unique_ptr<SocketBufferedImpl> &&buff,
+    DriverShared &driver,
+    ReceiveIntoProvider provideReceive,
+    ReceiveIntoHandler onReceive,
+    DisconnectHandler onDisconnect)
+  : buff(std::move(buff))
+  , driver(driver)
+  , resource(driver->resource)
+  , onReadable(std::bind(
+      &SocketAsyncImpl::DriverReceiveInto,
+      this,
+      std::move(provideReceive),
+      std::move(onReceive)))
+  , onError(std::bind(
+      &SocketAsyncImpl::DriverDisconnect,
+      this,
+      std::move(onDisconnect),
+      this->buff->sock->GetPeerName(), // cache remote address now before disconnect
+      std::placeholders::_1))
+  , sendQ(std::in_place_type<SendQ>, SendQ::container_type::allocator_type(resource))
 {
   driver->AsyncRegister(*this);
 }
@@ -57,6 +191,7 @@ SocketAsyncImpl::SocketAsyncImpl(
       0U, // no receive buffers needed
       1U)) // don't query SockOptRcvBuf
   , driver(driver)
+  , resource(driver->resource)
   , onReadable(std::bind(
       &SocketAsyncImpl::DriverConnect,
       this,
@@ -66,8 +201,59 @@ SocketAsyncImpl::SocketAsyncImpl(
   driver->AsyncRegister(*this);
 }
 
+// TCP connector with non-blocking Connect
+SocketAsyncImpl::SocketAsyncImpl(
+    std::unique_ptr<SocketImpl> &&sock,
+    DriverShared &driver,
+    AddressShared connectAddr,
+    ConnectHandler onConnect,
+    ConnectErrorHandler onConnectError)
+  : buff(std::make_unique<SocketBufferedImpl>(
+      std::move(sock),
+      0U, // no receive buffers needed
+      1U)) // don't query SockOptRcvBuf
+  , driver(driver)
+  , resource(driver->resource)
+  , onReadable([]() {}) // not polled for readable while connecting
+  , onError(std::bind(
+      &SocketAsyncImpl::DriverConnectError,
+      this,
+      std::move(onConnectError),
+      std::placeholders::_1))
+  , sendQ(std::in_place_type<ConnectPending>,
+          ConnectPending{std::move(onConnect), std::move(connectAddr)})
+{
+  // a non-blocking connect signals completion by becoming writable
+  driver->AsyncRegister(*this, POLLOUT);
+}
+
+// TCP socket whose IO is done by a relay
+SocketAsyncImpl::SocketAsyncImpl(
+    std::unique_ptr<SocketImpl> &&sock,
+    DriverShared &driver,
+    std::function<void()> onReadable,
+    std::function<bool()> onWritable,
+    std::function<void(char const *)> onError)
+  : buff(std::make_unique<SocketBufferedImpl>(
+      std::move(sock),
+      0U, // no receive buffers needed
+      1U)) // don't query SockOptRcvBuf
+  , driver(driver)
+  , resource(driver->resource)
+  , onReadable(std::move(onReadable))
+  , onError(std::move(onError))
+  , sendQ(std::in_place_type<Relayed>, Relayed{std::move(onWritable)})
+{
+  driver->AsyncRegister(*this);
+}
+
 SocketAsyncImpl::~SocketAsyncImpl()
 {
+  // a connector has handed over its socket after successful connect
+  if(!buff->sock) {
+    return;
+  }
+
   if(auto ptr = driver.lock()) {
     ptr->AsyncUnregister(buff->sock->fd);
   }
@@ -78,18 +264,35 @@ std::future<void> SocketAsyncImpl::Send(BufferPtr &&buffer)
   return DoSend<SendQ>(std::move(buffer));
 }
 
+std::future<void> SocketAsyncImpl::Send(BufferPtr &&header, BufferPtr &&payload)
+{
+  return DoSend<SendQ>(BufferPair(std::move(header), std::move(payload)));
+}
+
+std::future<void> SocketAsyncImpl::Send(SharedBufferPtr &&buffer)
+{
+  return DoSend<SendQ>(SharedSlice{std::move(buffer)});
+}
+
+std::future<void> SocketAsyncImpl::SendFile(FileSlice &&slice)
+{
+  return DoSend<SendQ>(std::move(slice));
+}
+
 std::future<void> SocketAsyncImpl::SendTo(BufferPtr &&buffer, AddressShared dstAddr)
 {
   return DoSend<SendToQ>(std::move(buffer), std::move(dstAddr));
 }
 
-template<typename Queue, typename... Args>
-std::future<void> SocketAsyncImpl::DoSend(Args&&... args)
+template<typename Queue, typename Payload, typename... Args>
+std::future<void> SocketAsyncImpl::DoSend(Payload &&payload, Args&&... args)
 {
-  std::promise<void> promise;
+  std::promise<void> promise(std::allocator_arg,
+                             std::pmr::polymorphic_allocator<std::byte>(resource));
   auto ret = promise.get_future();
 
-  bool wasEmpty = DoSendEnqueue<Queue>(std::move(promise), std::forward<Args>(args)...);
+  bool wasEmpty = DoSendEnqueue<Queue>(std::move(promise), std::move(payload),
+                                       std::forward<Args>(args)...);
   if(wasEmpty) {
     if(auto ptr = driver.lock()) {
       ptr->AsyncWantSend(buff->sock->fd);
@@ -99,17 +302,44 @@ std::future<void> SocketAsyncImpl::DoSend(Args&&... args)
   return ret;
 }
 
-template<typename Queue, typename... Args>
-bool SocketAsyncImpl::DoSendEnqueue(std::promise<void> promise, Args&&... args)
+template<typename Queue, typename Payload, typename... Args>
+bool SocketAsyncImpl::DoSendEnqueue(std::promise<void> promise,
+    Payload &&payload, Args&&... args)
 {
   std::lock_guard<std::mutex> lock(sendQMtx);
 
   auto &q = std::get<Queue>(sendQ);
   bool wasEmpty = q.empty();
-  q.emplace(std::move(promise), std::forward<Args>(args)...);
+  sendQBytes += PayloadSize(payload);
+  q.emplace(std::move(promise), std::move(payload), std::forward<Args>(args)...);
   return wasEmpty;
 }
 
+size_t SocketAsyncImpl::SendQueueSize() const
+{
+  std::lock_guard<std::mutex> lock(sendQMtx);
+  return sendQBytes;
+}
+
+void SocketAsyncImpl::ResumeReceive(std::weak_ptr<Driver::DriverImpl> const &driver,
+    SocketAsyncImpl const *sock)
+{
+  // the socket may be destroyed meanwhile, which the driver detects
+  if(auto ptr = driver.lock()) {
+    ptr->AsyncResumeReceive(sock);
+  }
+}
+
+void SocketAsyncImpl::EnableZeroCopy()
+{
+  buff->sock->SetSockOptZeroCopy();
+
+  std::lock_guard<std::mutex> lock(sendQMtx);
+  if(!zeroCopy) {
+    zeroCopy.emplace(resource);
+  }
+}
+
 SOCKET SocketAsyncImpl::DriverGetFd() const
 {
   return buff->sock->fd;
@@ -120,8 +350,9 @@ void SocketAsyncImpl::DriverQuery(short &events)
   buff->sock->DriverQuery(events);
 }
 
-void SocketAsyncImpl::DriverOnReadable()
+void SocketAsyncImpl::DriverOnReadable(int numaNode)
 {
+  buff->Localize(numaNode);
   onReadable();
 }
 
@@ -141,10 +372,28 @@ void SocketAsyncImpl::DriverReceive(ReceiveHandler const &onReceive)
 {
   try {
     auto buffer = buff->Receive();
-    if(buffer->empty()) {
+    if(!buffer) {
+      DriverDeferReceive();
+    } else if((*buffer)->empty()) {
+      // TLS socket received handshake data only
+    } else {
+      onReceive(std::move(*buffer));
+    }
+  } catch(std::runtime_error const &e) {
+    onError(e.what());
+  }
+}
+
+void SocketAsyncImpl::DriverReceiveView(ReceiveViewHandler const &onReceiveView)
+{
+  try {
+    // the handler may destroy the socket, but the ring is to be updated afterwards
+    auto ring = buff->ring;
+    if(buff->ReceiveRing() == 0U) {
       // TLS socket received handshake data only
     } else {
-      onReceive(std::move(buffer));
+      auto consumed = onReceiveView(ring->Readable());
+      ring->Consume(consumed);
     }
   } catch(std::runtime_error const &e) {
     onError(e.what());
@@ -154,15 +403,78 @@ void SocketAsyncImpl::DriverReceive(ReceiveHandler const &onReceive)
 void SocketAsyncImpl::DriverReceiveFrom(ReceiveFromHandler const &onReceiveFrom)
 {
   try {
-    auto [buffer, addr] = buff->ReceiveFrom();
+    auto receipt = buff->ReceiveFrom(resource);
+    if(!receipt) {
+      DriverDeferReceive();
+      return;
+    }
+    auto &&[buffer, addr] = *receipt;
     onReceiveFrom(std::move(buffer), std::move(addr));
   } catch(std::runtime_error const &e) {
     onError(e.what());
   }
 }
 
+void SocketAsyncImpl::DriverReceiveInto(ReceiveIntoProvider const &provideReceive,
+    ReceiveIntoHandler const &onReceive)
+{
+  try {
+    auto [data, size] = provideReceive();
+    if((data == nullptr) || (size == 0U)) {
+      // the handler waits for more data than it has room for
+      throw std::runtime_error("no receive memory provided");
+    }
+    if(auto received = buff->sock->Receive(data, size); received == 0U) {
+      // TLS socket received handshake data only
+    } else {
+      onReceive(received);
+    }
+  } catch(std::runtime_error const &e) {
+    onError(e.what());
+  }
+}
+
+void SocketAsyncImpl::DriverReceiveFromInto(ReceiveIntoProvider const &provideReceive,
+    ReceiveFromIntoHandler const &onReceiveFrom)
+{
+  try {
+    auto [data, size] = provideReceive();
+    if((data == nullptr) || (size == 0U)) {
+      // drop the datagram rather than to poll for it over and over
+      char dropped;
+      (void)buff->sock->ReceiveFrom(&dropped, 0U, resource);
+      return;
+    }
+    auto [received, addr] = buff->sock->ReceiveFrom(data, size, resource);
+    onReceiveFrom(received, std::move(addr));
+  } catch(std::runtime_error const &e) {
+    onError(e.what());
+  }
+}
+
+void SocketAsyncImpl::DriverDeferReceive()
+{
+  // out of shared buffers; polling for receipt is resumed from
+  // the thread releasing a buffer, which has to wait for this step
+  if(auto ptr = driver.lock()) {
+    ptr->AsyncWantReceive(buff->sock->fd, false);
+  }
+}
+
 bool SocketAsyncImpl::DriverOnWritable()
 {
+  if(auto pending = std::get_if<ConnectPending>(&sendQ)) {
+    DriverConnected(*pending);
+
+    // the socket has been unregistered from the driver already;
+    // its poll state must not be touched anymore
+    return false;
+  }
+  if(auto relayed = std::get_if<Relayed>(&sendQ)) {
+    // the relay may end and unregister both of its sockets
+    return relayed->onWritable();
+  }
+
   // hold the lock during send/sendto
   // as we already checked that the socket will not block and
   // otherwise we would need to re-lock afterwards to verify that
@@ -175,19 +487,40 @@ bool SocketAsyncImpl::DriverOnWritable()
       return DriverSend(q);
     } else if constexpr(std::is_same_v<Q, SendToQ>) {
       return DriverSendTo(q);
+    } else {
+      return false; // pending connect and relay are handled without lock
     }
   }, sendQ);
 }
 
 bool SocketAsyncImpl::DriverSend(SendQ &q)
 {
+  if(!q.empty()) {
+    auto &&payload = std::get<1>(q.front());
+    if(auto slice = std::get_if<FileSlice>(&payload)) {
+      return DriverSendFile(q, *slice);
+    }
+    if(auto pair = std::get_if<BufferPair>(&payload)) {
+      // copied to the OS even with zero-copy, as headers are small anyway
+      return DriverSendGather(q, *pair);
+    }
+    if(auto shared = std::get_if<SharedSlice>(&payload)) {
+      // copied to the OS even with zero-copy, which keeps uniquely owned buffers only
+      return DriverSendShared(q, *shared);
+    }
+  }
+  if(zeroCopy) {
+    return DriverSendZeroCopy(q, *zeroCopy);
+  }
+
   auto const sendQSize = q.size();
   if(!sendQSize) {
     // TLS socket has requested write for TLS handshake
     buff->sock->DriverPending();
     return true;
   }
-  auto &&[promise, buffer] = q.front();
+  auto &&promise = std::get<0>(q.front());
+  auto &&buffer = std::get<BufferPtr>(std::get<1>(q.front()));
 
   try {
     auto sent = buff->sock->SendSome(buffer->data(), buffer->size());
@@ -197,10 +530,144 @@ bool SocketAsyncImpl::DriverSend(SendQ &q)
       // allow partial send to avoid starving other driver's sockets if this one is rate limited
       // (may also be zero sent despite socket being writable when TLS handshake is pending)
       buffer->erase(0, sent);
+      sendQBytes -= sent;
+      return false;
+    }
+  } catch(std::runtime_error const &e) {
+    promise.set_exception(std::make_exception_ptr(e));
+  }
+  sendQBytes -= buffer->size();
+  q.pop();
+  return (sendQSize == 1U);
+}
+
+bool SocketAsyncImpl::DriverSendZeroCopy(SendQ &q, ZeroCopy &zc)
+{
+  auto const sendQSize = q.size();
+  if(!sendQSize) {
+    return true;
+  }
+  auto &&promise = std::get<0>(q.front());
+  auto &&buffer = std::get<BufferPtr>(std::get<1>(q.front()));
+
+  try {
+    if(!buffer->empty()) {
+      auto sent = buff->sock->SendZeroCopy(
+            buffer->data() + zc.offset,
+            buffer->size() - zc.offset);
+      bool const copied = (sent == 0U);
+      if(!copied) {
+        ++zc.nextSeq;
+      } else if(zc.nextSeq != zc.completedSeq) {
+        // out of notification memory; rather than spinning on the writable
+        // socket, wait until completions have been reaped from the error queue
+        zc.sendBlocked = true;
+        return true;
+      } else {
+        // no completion to wait for; send a copy like a regular socket
+        sent = buff->sock->SendSome(
+              buffer->data() + zc.offset,
+              buffer->size() - zc.offset);
+      }
+      zc.offset += sent;
+      sendQBytes -= sent;
+      if(zc.offset < buffer->size()) {
+        return false;
+      }
+
+      zc.offset = 0U;
+      if(copied) {
+        // any zero-copy send calls of it have been completed already
+        promise.set_value();
+      } else {
+        // keep the buffer out of its pool until the OS has released it
+        zc.inFlight.emplace_back(std::move(promise), std::move(buffer), zc.nextSeq - 1U);
+      }
+    } else {
+      promise.set_value();
+    }
+  } catch(std::runtime_error const &e) {
+    // the OS keeps its own references on pages it still needs
+    promise.set_exception(std::make_exception_ptr(e));
+    sendQBytes -= buffer->size() - zc.offset;
+    zc.offset = 0U;
+  }
+  q.pop();
+  return (sendQSize == 1U);
+}
+
+bool SocketAsyncImpl::DriverSendGather(SendQ &q, BufferPair &pair)
+{
+  auto const sendQSize = q.size();
+  auto &&promise = std::get<0>(q.front());
+  auto &&[header, payload] = pair;
+
+  try {
+    auto sent = buff->sock->SendSomeGather(
+          header->data(), header->size(),
+          payload->data(), payload->size());
+    sendQBytes -= sent;
+    auto const headerSent = std::min(sent, header->size());
+    header->erase(0, headerSent);
+    payload->erase(0, sent - headerSent);
+    if(!header->empty() || !payload->empty()) {
+      // partial send just like single buffers to not starve other sockets
       return false;
     }
+    promise.set_value();
   } catch(std::runtime_error const &e) {
     promise.set_exception(std::make_exception_ptr(e));
+    sendQBytes -= header->size() + payload->size();
+  }
+  q.pop();
+  return (sendQSize == 1U);
+}
+
+bool SocketAsyncImpl::DriverSendShared(SendQ &q, SharedSlice &slice)
+{
+  auto const sendQSize = q.size();
+  auto &&promise = std::get<0>(q.front());
+  auto &&buffer = *slice.buffer;
+
+  try {
+    auto sent = buff->sock->SendSome(
+          buffer.data() + slice.offset,
+          buffer.size() - slice.offset);
+    slice.offset += sent;
+    sendQBytes -= sent;
+    if(slice.offset < buffer.size()) {
+      // partial send just like single buffers to not starve other sockets
+      return false;
+    }
+
+    // release before reporting, so the last owner finds the buffer unshared
+    slice.buffer.reset();
+    promise.set_value();
+  } catch(std::runtime_error const &e) {
+    promise.set_exception(std::make_exception_ptr(e));
+    sendQBytes -= buffer.size() - slice.offset;
+  }
+  q.pop();
+  return (sendQSize == 1U);
+}
+
+bool SocketAsyncImpl::DriverSendFile(SendQ &q, FileSlice &slice)
+{
+  auto const sendQSize = q.size();
+  auto &&promise = std::get<0>(q.front());
+
+  try {
+    auto sent = buff->sock->SendFileSome(slice);
+    sendQBytes -= sent;
+    if(slice.size > 0U) {
+      // partial send just like buffers to not starve other sockets
+      return false;
+    }
+    promise.set_value();
+  } catch(std::exception const &) {
+    // includes the logic error of sockets that can't send files (TLS)
+    promise.set_exception(std::current_exception());
+    sendQBytes -= slice.size;
   }
   q.pop();
   return (sendQSize == 1U);
@@ -223,10 +690,72 @@ bool SocketAsyncImpl::DriverSendTo(SendToQ &q)
   } catch(std::runtime_error const &e) {
     promise.set_exception(std::make_exception_ptr(e));
   }
+  sendQBytes -= buffer->size();
   q.pop();
   return (sendToQSize == 1U);
 }
 
+void SocketAsyncImpl::DriverConnected(ConnectPending &pending)
+{
+  std::string errorMessage;
+  try {
+    if(auto error = buff->sock->GetSockOptError()) {
+      errorMessage = std::system_error(error,
+          "failed to connect to " + to_string(*pending.connectAddr)).what();
+    }
+  } catch(std::runtime_error const &e) {
+    errorMessage = e.what();
+  }
+  if(!errorMessage.empty()) {
+    onError(errorMessage.c_str());
+    return;
+  }
+
+  if(auto ptr = driver.lock()) {
+    ptr->AsyncUnregister(buff->sock->fd);
+  }
+
+  // the handler may destroy the connector -> hand over everything beforehand
+  auto onConnect = std::move(pending.onConnect);
+  auto connectAddr = std::move(pending.connectAddr);
+  SocketTcp sock(std::move(buff->sock));
+
+  onConnect(std::move(sock), Address(std::move(connectAddr)));
+}
+
+bool SocketAsyncImpl::DriverOnErrorQueue(short &events)
+{
+  std::lock_guard<std::mutex> lock(sendQMtx);
+  if(!zeroCopy) {
+    return false;
+  }
+  auto &&zc = *zeroCopy;
+
+  bool reaped = false;
+  try {
+    while(auto completed = buff->sock->ReceiveZeroCopyCompletion()) {
+      reaped = true;
+
+      // a buffer is released once all of its send calls have been completed
+      if(zc.Complete(completed->first, completed->second)) {
+        while(!zc.inFlight.empty() &&
+              static_cast<int32_t>(std::get<2>(zc.inFlight.front()) - zc.completedSeq) < 0) {
+          std::get<0>(zc.inFlight.front()).set_value();
+          zc.inFlight.pop_front();
+        }
+      }
+    }
+  } catch(std::runtime_error const &) {
+    // a regular socket error; reported via DriverOnError unless completions were reaped
+  }
+
+  if(reaped && zc.sendBlocked) {
+    zc.sendBlocked = false;
+    events |= POLLOUT;
+  }
+  return reaped;
+}
+
 void SocketAsyncImpl::DriverOnError(char const *message)
 {
   onError(message);
@@ -243,5 +772,17 @@ void SocketAsyncImpl::DriverDisconnect(DisconnectHandler const &onDisconnect,
   onDisconnect(Address(std::move(peerAddr)), reason);
 }
 
+void SocketAsyncImpl::DriverConnectError(ConnectErrorHandler const &onConnectError,
+    char const *reason)
+{
+  // a connector reports only once
+  auto &&pending = std::get<ConnectPending>(sendQ);
+  if(auto ptr = driver.lock()) {
+    ptr->AsyncUnregister(buff->sock->fd);
+  }
+
+  onConnectError(Address(pending.connectAddr), reason);
+}
+
 
 } // namespace sockpuppet
@@ -2,16 +2,24 @@
 #define SOCKPUPPET_SOCKET_ASYNC_IMPL_H
 
 #include "address_impl.h" // for SockAddrStorage
+#include "file_impl.h" // for FileSlice
 #include "socket_buffered_impl.h" // for SocketBufferedImpl
 #include "sockpuppet/address.h" // for Address
 #include "sockpuppet/socket_async.h" // for Driver
 
+#include <cstddef> // for size_t
+#include <cstdint> // for uint32_t
+#include <deque> // for std::pmr::deque
 #include <future> // for std::future
 #include <memory> // for std::shared_ptr
+#include <memory_resource> // for std::pmr::memory_resource
 #include <mutex> // for std::mutex
+#include <optional> // for std::optional
 #include <queue> // for std::queue
 #include <tuple> // for std::tuple
+#include <utility> // for std::pair
 #include <variant> // for std::variant
+#include <vector> // for std::pmr::vector
 
 namespace sockpuppet {
 
@@ -19,17 +27,51 @@ struct SocketAsyncImpl
 {
   using AddressShared = std::shared_ptr<Address::AddressImpl>;
   using DriverShared = std::shared_ptr<Driver::DriverImpl>;
-  using SendQElement = std::tuple<std::promise<void>, BufferPtr>;
-  using SendQ = std::queue<SendQElement>;
+  using BufferPair = std::pair<BufferPtr, BufferPtr>; // header and payload
+  struct SharedSlice
+  {
+    SharedBufferPtr buffer;
+    size_t offset = 0U; // shared buffers are immutable, so partial sends advance this
+  };
+  using SendQPayload = std::variant<BufferPtr, BufferPair, FileSlice, SharedSlice>;
+  using SendQElement = std::tuple<std::promise<void>, SendQPayload>;
+  using SendQ = std::queue<SendQElement, std::pmr::deque<SendQElement>>;
   using SendToQElement = std::tuple<std::promise<void>, BufferPtr, AddressShared>;
-  using SendToQ = std::queue<SendToQElement>;
+  using SendToQ = std::queue<SendToQElement, std::pmr::deque<SendToQElement>>;
+  struct ConnectPending
+  {
+    ConnectHandler onConnect;
+    AddressShared connectAddr;
+  };
+  struct Relayed
+  {
+    std::function<bool()> onWritable; // the relay does all the IO
+  };
+  using ZeroCopyQElement = std::tuple<std::promise<void>, BufferPtr, uint32_t>;
+  struct ZeroCopy
+  {
+    uint32_t nextSeq = 0U; // sequence number of the next zero-copy send call
+    uint32_t completedSeq = 0U; // all send calls before it have been completed
+    size_t offset = 0U; // partially sent buffers must not be modified
+    bool sendBlocked = false; // out of notification memory until completions are reaped
+    std::pmr::deque<ZeroCopyQElement> inFlight; // sent but possibly still referenced by the OS; by last sequence number
+    std::pmr::vector<std::pair<uint32_t, uint32_t>> completedAhead; // ranges reported beyond a gap at completedSeq
+
+    // records a range of completed send calls; returns true if completedSeq advanced
+    bool Complete(uint32_t first, uint32_t last);
+
+    ZeroCopy(std::pmr::memory_resource *resource);
+  };
 
   std::unique_ptr<SocketBufferedImpl> buff;
   std::weak_ptr<Driver::DriverImpl> driver;
+  std::pmr::memory_resource *resource; // of the driver, for send bookkeeping and source addresses
   std::function<void()> onReadable; // contains use-case-dependent data as bound arguments
   std::function<void(char const *)> onError; // contains use-case-dependent data as bound arguments
   mutable std::mutex sendQMtx;
-  std::variant<SendQ, SendToQ> sendQ; // use-case dependent queue type
+  std::variant<SendQ, SendToQ, ConnectPending, Relayed> sendQ; // use-case dependent queue type
+  size_t sendQBytes = 0U; // enqueued but not yet sent; guarded by sendQMtx
+  std::optional<ZeroCopy> zeroCopy; // guarded by sendQMtx
 
   SocketAsyncImpl(std::unique_ptr<SocketBufferedImpl> &&buff,
                   DriverShared &driver,
@@ -38,9 +80,32 @@ struct SocketAsyncImpl
                   DriverShared &driver,
                   ReceiveHandler onReceive,
                   DisconnectHandler onDisconnect);
+  SocketAsyncImpl(std::unique_ptr<SocketBufferedImpl> &&buff,
+                  DriverShared &driver,
+                  ReceiveViewHandler onReceiveView,
+                  DisconnectHandler onDisconnect);
+  SocketAsyncImpl(std::unique_ptr<SocketBufferedImpl> &&buff,
+                  DriverShared &driver,
+                  ReceiveIntoProvider provideReceive,
+                  ReceiveFromIntoHandler onReceiveFrom);
+  SocketAsyncImpl(std::unique_ptr<SocketBufferedImpl> &&buff,
+                  DriverShared &driver,
+                  ReceiveIntoProvider provideReceive,
+                  ReceiveIntoHandler onReceive,
+                  DisconnectHandler onDisconnect);
   SocketAsyncImpl(std::unique_ptr<SocketImpl> &&sock,
                   DriverShared &driver,
                   ConnectHandler onConnect);
+  SocketAsyncImpl(std::unique_ptr<SocketImpl> &&sock,
+                  DriverShared &driver,
+                  AddressShared connectAddr,
+                  ConnectHandler onConnect,
+                  ConnectErrorHandler onConnectError);
+  SocketAsyncImpl(std::unique_ptr<SocketImpl> &&sock,
+                  DriverShared &driver,
+                  std::function<void()> onReadable,
+                  std::function<bool()> onWritable,
+                  std::function<void(char const *)> onError);
   SocketAsyncImpl(SocketAsyncImpl const &) = delete;
   SocketAsyncImpl(SocketAsyncImpl &&) = delete;
   ~SocketAsyncImpl();
@@ -48,30 +113,57 @@ struct SocketAsyncImpl
   SocketAsyncImpl &operator=(SocketAsyncImpl &&) = delete;
 
   std::future<void> Send(BufferPtr &&buffer);
+  std::future<void> Send(BufferPtr &&header, BufferPtr &&payload);
+  std::future<void> Send(SharedBufferPtr &&buffer);
+  std::future<void> SendFile(FileSlice &&slice);
   std::future<void> SendTo(BufferPtr &&buffer, AddressShared dstAddr);
 
-  template<typename Queue, typename... Args>
-  std::future<void> DoSend(Args&&... args);
-  template<typename Queue, typename... Args>
-  bool DoSendEnqueue(std::promise<void> promise, Args&&... args);
+  template<typename Queue, typename Payload, typename... Args>
+  std::future<void> DoSend(Payload &&payload, Args&&... args);
+  template<typename Queue, typename Payload, typename... Args>
+  bool DoSendEnqueue(std::promise<void> promise, Payload &&payload, Args&&... args);
+
+  size_t SendQueueSize() const;
+  void EnableZeroCopy();
+  // must not access the socket, which may have been destroyed
+  static void ResumeReceive(std::weak_ptr<Driver::DriverImpl> const &driver,
+                            SocketAsyncImpl const *sock);
 
   // in thread context of DriverImpl
   SOCKET DriverGetFd() const;
   void DriverQuery(short &events);
-  void DriverOnReadable();
+  // numaNode is the node the driver thread is bound to, negative if unbound
+  void DriverOnReadable(int numaNode);
   void DriverConnect(ConnectHandler const &onConnect);
   void DriverReceive(ReceiveHandler const &onReceive);
+  void DriverReceiveView(ReceiveViewHandler const &onReceiveView);
   void DriverReceiveFrom(ReceiveFromHandler const &onReceiveFrom);
+  void DriverReceiveInto(ReceiveIntoProvider const &provideReceive,
+                         ReceiveIntoHandler const &onReceive);
+  void DriverReceiveFromInto(ReceiveIntoProvider const &provideReceive,
+                             ReceiveFromIntoHandler const &onReceiveFrom);
+  void DriverDeferReceive();
 
   /// @return  true if there is no more data to send, false otherwise
   bool DriverOnWritable();
   bool DriverSend(SendQ &q);
+  bool DriverSendZeroCopy(SendQ &q, ZeroCopy &zc);
+  bool DriverSendGather(SendQ &q, BufferPair &pair);
+  bool DriverSendShared(SendQ &q, SharedSlice &slice);
+  bool DriverSendFile(SendQ &q, FileSlice &slice);
   bool DriverSendTo(SendToQ &q);
+  void DriverConnected(ConnectPending &pending);
 
+  /// @param  events  Poll events to request send polling in again
+  ///                 once sends held back for notification memory may resume.
+  /// @return  true if zero-copy send completions were reaped, false otherwise
+  bool DriverOnErrorQueue(short &events);
   void DriverOnError(char const *message);
   void DriverDisconnect(DisconnectHandler const &onDisconnect,
                         AddressShared peerAddr,
                         char const *errorMessage);
+  void DriverConnectError(ConnectErrorHandler const &onConnectError,
+                          char const *errorMessage);
 };
 
 } // namespace sockpuppet
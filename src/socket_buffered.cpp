@@ -1,27 +1,93 @@
 #include "sockpuppet/socket_buffered.h"
 #include "address_impl.h" // for Address::AddressImpl
+#include "shared_buffer_pool_impl.h" // for SharedBufferPoolImpl
 #include "socket_buffered_impl.h" // for SocketBufferedImpl
 
-#include <algorithm> // for std::find_if
+#include <algorithm> // for std::is_sorted, std::max, std::min
+#include <atomic> // for std::atomic
 #include <cassert> // for assert
+#include <cstdint> // for uint32_t
+#include <mutex> // for std::mutex
 #include <stdexcept> // for std::runtime_error
+#include <utility> // for std::exchange
 
 namespace sockpuppet {
 
 namespace {
 
-struct BufferEqual
+// the first segment is sized to hold all buffers of a limited pool
+constexpr unsigned int minBaseShift = 4U;
+
+constexpr uint64_t Pack(uint32_t tag, uint32_t slot)
 {
-  BufferPool::Buffer *buf;
+  return (static_cast<uint64_t>(tag) << 32) | slot;
+}
 
-  bool operator()(std::unique_ptr<BufferPool::Buffer> const &storage) const
-  {
-    return (storage.get() == buf);
-  }
-};
+constexpr uint32_t Tag(uint64_t head)
+{
+  return static_cast<uint32_t>(head >> 32);
+}
+
+constexpr uint32_t Slot(uint64_t head)
+{
+  return static_cast<uint32_t>(head);
+}
 
 } // unnamed namespace
 
+// the buffers of one size, of which idle ones are kept on a lock-free
+// stack; the buffer objects are allocated in segments of doubling size
+struct BufferPool::SizeClass
+{
+  static constexpr size_t segmentCount = 32U;
+
+  size_t size = 0U; // reserved per buffer
+  size_t maxCount = 0U; // minus one, so unlimited wraps around
+  unsigned int baseShift = minBaseShift; // segment k holds (1 << baseShift) << k buffers
+  std::atomic<uint64_t> idle{0U}; // top of idle stack: ABA tag << 32 | index + 1; 0 if empty
+  std::atomic<Node *> segments[segmentCount] = {};
+  std::mutex growMtx;
+  size_t count = 0U; // buffers allocated; guarded by growMtx
+
+  // statistics; counted without lock
+  std::atomic<size_t> busy{0U};
+  std::atomic<size_t> highWater{0U};
+  std::atomic<size_t> exhaustions{0U};
+  std::atomic<size_t> reservedSize{0U};
+
+  SizeClass() = default;
+  SizeClass(SizeClass const &) = delete;
+  SizeClass(SizeClass &&) = delete;
+  ~SizeClass();
+  SizeClass &operator=(SizeClass const &) = delete;
+  SizeClass &operator=(SizeClass &&) = delete;
+
+  void Init(size_t size, size_t maxCount);
+  Node *Pop();
+  void Push(Node *node);
+  Node *Grow();
+  Node *Allocate();
+  unsigned int SegmentOf(uint32_t index) const;
+  Node *At(uint32_t index) const;
+
+  void Obtained();
+  void Released(Node &node);
+  void Reserved(Node &node);
+  BufferPoolStats Stats();
+  void Localize();
+};
+
+// the buffer handed out is the base of its node, so the
+// recycler finds the node (and its class) in constant time
+struct BufferPool::Node : public BufferPool::Buffer
+{
+  SizeClass *sizeClass = nullptr;
+  uint32_t index = 0U;
+  std::atomic<uint32_t> next{0U}; // slot (index + 1) of the next idle node
+  BufferShare *share = nullptr; // of the socket holding the buffer if shared
+  size_t reservedSize = 0U; // capacity as of the last release
+};
+
 void BufferPool::Recycler::operator()(Buffer *buf)
 {
   assert(pool);
@@ -30,72 +96,329 @@ void BufferPool::Recycler::operator()(Buffer *buf)
 }
 
 
-BufferPool::BufferPool(size_t maxCount, size_t reserveSize)
-  : m_maxCount(maxCount - 1U)
+BufferPool::SizeClass::~SizeClass()
 {
+#ifndef NDEBUG
+  // buffers still pending -> will segfault later
+  // make sure pool is released after all of its users
+  size_t idleCount = 0U;
+  for(auto slot = Slot(idle.load()); slot != 0U; slot = At(slot - 1U)->next.load()) {
+    ++idleCount;
+  }
+  assert(idleCount == count);
+#endif // NDEBUG
+
+  for(auto &&segment : segments) {
+    delete[] segment.load();
+  }
+}
+
+void BufferPool::SizeClass::Init(size_t size, size_t maxCount)
+{
+  this->size = size;
+  this->maxCount = maxCount - 1U;
+  while((size_t(1U) << baseShift) < maxCount) {
+    ++baseShift;
+  }
+
   // with given limit, pre-allocate the buffers now
+  // (the buffer objects in a single array)
   for(size_t i = 0U; i < maxCount; ++i) {
-    auto &&buf = m_idle.emplace(std::make_unique<Buffer>());
-    buf->reserve(reserveSize);
+    Push(Allocate());
   }
 }
 
-BufferPool::BufferPtr BufferPool::Get()
+BufferPool::Node *BufferPool::SizeClass::Pop()
 {
-  std::lock_guard<std::mutex> lock(m_mtx);
+  // the tag changes with every push, so a node popped and pushed
+  // again meanwhile (ABA) makes the exchange fail like any other change
+  auto head = idle.load(std::memory_order_acquire);
+  while(Slot(head) != 0U) {
+    auto node = At(Slot(head) - 1U);
+    auto next = node->next.load(std::memory_order_relaxed);
+    if(idle.compare_exchange_weak(head, Pack(Tag(head), next),
+                                  std::memory_order_acquire,
+                                  std::memory_order_acquire)) {
+      return node;
+    }
+  }
+  return nullptr;
+}
 
-  if(m_idle.empty()) {
-    if(m_busy.size() <= m_maxCount) {
-      // allocate a new buffer already in the busy list
-      auto &&buf = m_busy.emplace_back(
-        std::make_unique<Buffer>());
+void BufferPool::SizeClass::Push(Node *node)
+{
+  auto head = idle.load(std::memory_order_relaxed);
+  do {
+    node->next.store(Slot(head), std::memory_order_relaxed);
+  } while(!idle.compare_exchange_weak(head, Pack(Tag(head) + 1U, node->index + 1U),
+                                      std::memory_order_release,
+                                      std::memory_order_relaxed));
+}
+
+BufferPool::Node *BufferPool::SizeClass::Grow()
+{
+  std::lock_guard<std::mutex> lock(growMtx);
 
-      // bind to recycler and return
-      return {buf.get(), Recycler{this}};
-    } else {
-      throw std::runtime_error("out of buffers");
+  // a buffer may have been released while waiting for the lock
+  if(auto node = Pop()) {
+    return node;
+  }
+  return Allocate();
+}
+
+BufferPool::Node *BufferPool::SizeClass::Allocate()
+{
+  if((count > maxCount) || (count >= UINT32_MAX)) {
+    exhaustions.fetch_add(1U, std::memory_order_relaxed);
+    throw std::runtime_error("out of buffers");
+  }
+
+  // segments are never moved or freed while the pool exists,
+  // so other threads may access nodes without taking the lock
+  auto const index = static_cast<uint32_t>(count);
+  auto const segment = SegmentOf(index);
+  if(!segments[segment].load(std::memory_order_relaxed)) {
+    auto const first = ((size_t(1U) << segment) - 1U) << baseShift;
+    auto const length = size_t(1U) << (baseShift + segment);
+    auto nodes = new Node[length];
+    for(size_t i = 0U; i < length; ++i) {
+      nodes[i].sizeClass = this;
+      nodes[i].index = static_cast<uint32_t>(first + i);
     }
-  } else {
-    // move from idle to busy
-    auto &&buf = m_busy.emplace_back(std::move(m_idle.top()));
-    m_idle.pop();
+    segments[segment].store(nodes, std::memory_order_release);
+  }
+  ++count;
 
-    // clear previous content
-    buf->clear();
+  auto node = At(index);
+  node->reserve(size);
+  node->reservedSize = node->capacity();
+  reservedSize.fetch_add(node->reservedSize, std::memory_order_relaxed);
+  return node;
+}
 
-    // bind to recycler and return
-    return {buf.get(), Recycler{this}};
+unsigned int BufferPool::SizeClass::SegmentOf(uint32_t index) const
+{
+  // floor(log2((index >> base) + 1))
+  auto const scaled = (static_cast<size_t>(index) >> baseShift) + 1U;
+  unsigned int segment = 0U;
+  while((scaled >> (segment + 1U)) != 0U) {
+    ++segment;
   }
+  return segment;
 }
 
-BufferPool::~BufferPool()
+BufferPool::Node *BufferPool::SizeClass::At(uint32_t index) const
 {
-  // buffers still pending -> will segfault later
-  // make sure pool is released after all of its users
-  assert(m_busy.empty());
+  auto const segment = SegmentOf(index);
+  auto const first = ((size_t(1U) << segment) - 1U) << baseShift;
+  return segments[segment].load(std::memory_order_acquire) + (index - first);
 }
 
-void BufferPool::Recycle(Buffer *buf)
+void BufferPool::SizeClass::Obtained()
+{
+  auto const nowBusy = busy.fetch_add(1U, std::memory_order_relaxed) + 1U;
+  auto high = highWater.load(std::memory_order_relaxed);
+  while((nowBusy > high) &&
+        !highWater.compare_exchange_weak(high, nowBusy, std::memory_order_relaxed)) {
+  }
+}
+
+void BufferPool::SizeClass::Released(Node &node)
+{
+  // the user may have grown the buffer, which it keeps while idle
+  Reserved(node);
+  busy.fetch_sub(1U, std::memory_order_relaxed);
+}
+
+void BufferPool::SizeClass::Reserved(Node &node)
+{
+  auto const capacity = node.capacity();
+  if(capacity > node.reservedSize) {
+    reservedSize.fetch_add(capacity - node.reservedSize, std::memory_order_relaxed);
+  } else if(capacity < node.reservedSize) {
+    reservedSize.fetch_sub(node.reservedSize - capacity, std::memory_order_relaxed);
+  }
+  node.reservedSize = capacity;
+}
+
+void BufferPool::SizeClass::Localize()
 {
-  std::lock_guard<std::mutex> lock(m_mtx);
+  // take all idle nodes first, so none is reallocated twice
+  std::vector<Node *> taken;
+  while(auto node = Pop()) {
+    taken.push_back(node);
+  }
+  for(auto node : taken) {
+    // reserving maps pages only; filling them makes this thread the first to touch
+    Buffer local;
+    local.reserve(std::max(size, node->capacity()));
+    local.resize(local.capacity());
+    local.clear();
+    node->swap(local);
+    Reserved(*node);
+  }
+  for(auto node : taken) {
+    Push(node);
+  }
+}
 
-  auto it = std::find_if(begin(m_busy), end(m_busy), BufferEqual{buf});
-  if(it == end(m_busy)) {
-    throw std::logic_error("returned invalid buffer");
+BufferPoolStats BufferPool::SizeClass::Stats()
+{
+  BufferPoolStats stats;
+  {
+    std::lock_guard<std::mutex> lock(growMtx);
+    stats.allocations = count;
   }
+  stats.busy = std::min(busy.load(std::memory_order_relaxed), stats.allocations);
+  stats.idle = stats.allocations - stats.busy;
+  stats.highWater = highWater.load(std::memory_order_relaxed);
+  stats.exhaustions = exhaustions.load(std::memory_order_relaxed);
+  stats.reservedSize = reservedSize.load(std::memory_order_relaxed);
+  return stats;
+}
+
 
-  // move from busy to idle
-  m_idle.push(std::move(*it));
-  m_busy.erase(it);
+BufferPoolStats &BufferPoolStats::operator+=(BufferPoolStats const &other)
+{
+  idle += other.idle;
+  busy += other.busy;
+  highWater += other.highWater;
+  allocations += other.allocations;
+  exhaustions += other.exhaustions;
+  reservedSize += other.reservedSize;
+  return *this;
 }
 
 
+BufferPool::BufferPool(size_t maxCount, size_t reserveSize)
+  : m_classes(std::make_unique<SizeClass[]>(1U))
+  , m_classCount(1U)
+{
+  // the reserve size only applies to pre-allocated buffers
+  m_classes[0].Init(maxCount ? reserveSize : 0U, maxCount);
+}
+
+BufferPool::BufferPool(std::vector<size_t> const &classSizes, size_t maxCount)
+  : m_classes(std::make_unique<SizeClass[]>(classSizes.size()))
+  , m_classCount(classSizes.size())
+{
+  if(classSizes.empty() ||
+     !std::is_sorted(classSizes.begin(), classSizes.end())) {
+    throw std::logic_error("invalid buffer size classes");
+  }
+  for(size_t i = 0U; i < m_classCount; ++i) {
+    m_classes[i].Init(classSizes[i], maxCount);
+  }
+}
+
+BufferPool::BufferPtr BufferPool::Get()
+{
+  auto buffer = Get(m_classes[0]);
+  buffer->clear(); // of previous content
+  return buffer;
+}
+
+BufferPool::BufferPtr BufferPool::Get(size_t size)
+{
+  size_t i = 0U;
+  while((i + 1U < m_classCount) && (m_classes[i].size < size)) {
+    ++i;
+  }
+  auto buffer = Get(m_classes[i]);
+  buffer->clear(); // of previous content
+  return buffer;
+}
+
+BufferPoolStats BufferPool::Stats() const
+{
+  BufferPoolStats stats;
+  for(size_t i = 0U; i < m_classCount; ++i) {
+    stats += m_classes[i].Stats();
+  }
+  return stats;
+}
+
+void BufferPool::Localize()
+{
+  for(size_t i = 0U; i < m_classCount; ++i) {
+    m_classes[i].Localize();
+  }
+}
+
+BufferPool::~BufferPool() = default;
+
+BufferPool::BufferPtr BufferPool::Get(BufferShare &share)
+{
+  auto buffer = GetForReceipt();
+  static_cast<Node *>(buffer.get())->share = &share;
+  return buffer;
+}
+
+BufferPool::BufferPtr BufferPool::GetForReceipt()
+{
+  // the content is overwritten by receipt; keeping the previous size
+  // spares resizing from filling what is overwritten anyway
+  return Get(m_classes[0]);
+}
+
+BufferPool::BufferPtr BufferPool::Get(SizeClass &sizeClass)
+{
+  auto node = sizeClass.Pop();
+  if(!node) {
+    node = sizeClass.Grow();
+  }
+
+  sizeClass.Obtained();
+
+  // bind to recycler and return
+  return {node, Recycler{this}};
+}
+
+void BufferPool::Recycle(Buffer *buf)
+{
+  auto node = static_cast<Node *>(buf);
+  auto share = std::exchange(node->share, nullptr);
+  node->sizeClass->Released(*node);
+  node->sizeClass->Push(node);
+
+  // account the buffer only once it may be obtained again
+  if(share) {
+    share->pool.Released(*share);
+  }
+}
+
+
+SharedBufferPool::SharedBufferPool(size_t budget, size_t bufferSize)
+  : impl(std::make_shared<SharedBufferPoolImpl>(budget, bufferSize))
+{
+}
+
+BufferPoolStats SharedBufferPool::Stats() const
+{
+  return impl->Stats();
+}
+
+SharedBufferPool::SharedBufferPool(SharedBufferPool &&other) noexcept = default;
+
+SharedBufferPool::~SharedBufferPool() = default;
+
+SharedBufferPool &SharedBufferPool::operator=(SharedBufferPool &&other) noexcept = default;
+
+
 SocketUdpBuffered::SocketUdpBuffered(SocketUdp &&sock,
-    size_t rxBufCount, size_t rxBufSize)
+    size_t rxBufCount, size_t rxBufSize, ReceiveSizing sizing)
   : impl(std::make_unique<SocketBufferedImpl>(
       std::move(sock.impl),
       rxBufCount,
-      rxBufSize))
+      rxBufSize,
+      sizing))
+{
+}
+
+SocketUdpBuffered::SocketUdpBuffered(SocketUdp &&sock, SharedBufferPool &pool)
+  : impl(std::make_unique<SocketBufferedImpl>(
+      std::move(sock.impl),
+      pool.impl))
 {
 }
 
@@ -116,6 +439,11 @@ Address SocketUdpBuffered::LocalAddress() const
   return Address(impl->sock->GetSockName());
 }
 
+BufferPoolStats SocketUdpBuffered::ReceiveBufferStats() const
+{
+  return impl->Stats();
+}
+
 SocketUdpBuffered::SocketUdpBuffered(SocketUdpBuffered &&other) noexcept = default;
 
 SocketUdpBuffered::~SocketUdpBuffered() = default;
@@ -124,11 +452,19 @@ SocketUdpBuffered &SocketUdpBuffered::operator=(SocketUdpBuffered &&other) noexc
 
 
 SocketTcpBuffered::SocketTcpBuffered(SocketTcp &&sock,
-    size_t rxBufCount, size_t rxBufSize)
+    size_t rxBufCount, size_t rxBufSize, ReceiveSizing sizing)
   : impl(std::make_unique<SocketBufferedImpl>(
       std::move(sock.impl),
       rxBufCount,
-      rxBufSize))
+      rxBufSize,
+      sizing))
+{
+}
+
+SocketTcpBuffered::SocketTcpBuffered(SocketTcp &&sock, SharedBufferPool &pool)
+  : impl(std::make_unique<SocketBufferedImpl>(
+      std::move(sock.impl),
+      pool.impl))
 {
 }
 
@@ -143,6 +479,24 @@ std::optional<BufferPtr> SocketTcpBuffered::Receive(Duration timeout)
   return impl->Receive(timeout);
 }
 
+void SocketTcpBuffered::EnableReceiveRing(size_t capacity)
+{
+  impl->EnableRing(capacity);
+}
+
+std::optional<std::string_view> SocketTcpBuffered::ReceiveView(Duration timeout)
+{
+  return impl->ReceiveView(timeout);
+}
+
+void SocketTcpBuffered::Consume(size_t size)
+{
+  if(!impl->ring) {
+    throw std::logic_error("receive ring is not enabled");
+  }
+  impl->ring->Consume(size);
+}
+
 Address SocketTcpBuffered::LocalAddress() const
 {
   return Address(impl->sock->GetSockName());
@@ -153,6 +507,21 @@ Address SocketTcpBuffered::PeerAddress() const
   return Address(impl->sock->GetPeerName());
 }
 
+void SocketTcpBuffered::SetOptions(TcpOptions const &options)
+{
+  impl->sock->SetSockOptTcp(options);
+}
+
+TcpInfo SocketTcpBuffered::Info() const
+{
+  return impl->sock->GetSockOptTcpInfo();
+}
+
+BufferPoolStats SocketTcpBuffered::ReceiveBufferStats() const
+{
+  return impl->Stats();
+}
+
 SocketTcpBuffered::SocketTcpBuffered(SocketTcpBuffered &&other) noexcept = default;
 
 SocketTcpBuffered::~SocketTcpBuffered() = default;
@@ -1,14 +1,64 @@
 #include "socket_buffered_impl.h"
+#include "numa.h" // for CurrentNumaNode
+#include "wait.h" // for WaitReadable
+
+#include <algorithm> // for std::max
+#include <stdexcept> // for std::logic_error
+#include <string> // for std::string
 
 namespace sockpuppet {
 
+namespace {
+
+// the buffer is overwritten by receipt right away; it still has the size of
+// its previous receipt, so growing it fills only what that one left out
+void ResizeForReceipt(std::string &buffer, size_t size)
+{
+  buffer.resize(size);
+}
+
+std::pair<char *, size_t> RingWritable(std::shared_ptr<RingBuffer> const &ring)
+{
+  if(!ring) {
+    throw std::logic_error("receive ring is not enabled");
+  }
+  auto writable = ring->Writable();
+  if(writable.second == 0U) {
+    // the handler waits for more data than fits into the ring
+    throw std::runtime_error("receive ring is full");
+  }
+  return writable;
+}
+
+} // unnamed namespace
+
 SocketBufferedImpl::SocketBufferedImpl(std::unique_ptr<SocketImpl> &&sock,
-    size_t rxBufCount, size_t rxBufSize)
+    size_t rxBufCount, size_t rxBufSize, ReceiveSizing sizing)
   : sock(std::move(sock))
   , rxBufSize(rxBufSize ?
                 rxBufSize :
                 this->sock->GetSockOptRcvBuf())
-  , pool(std::make_unique<BufferPool>(rxBufCount, this->rxBufSize))
+  , numaNode(-1)
+{
+  // buffers of limited pools are allocated right away by this thread
+  if(auto node = CurrentNumaNode()) {
+    numaNode = static_cast<int>(*node);
+  }
+
+  if(sizing == ReceiveSizing::Adaptive) {
+    classes = std::make_unique<ReceiveSizeClasses>(this->rxBufSize, rxBufCount);
+  } else {
+    pool = std::make_unique<BufferPool>(rxBufCount, this->rxBufSize);
+  }
+}
+
+SocketBufferedImpl::SocketBufferedImpl(std::unique_ptr<SocketImpl> &&sock,
+    std::shared_ptr<SharedBufferPoolImpl> shared)
+  : sock(std::move(sock))
+  , rxBufSize(shared->bufferSize)
+  , shared(std::move(shared))
+  , share(this->shared->Attach())
+  , numaNode(-1)
 {
 }
 
@@ -16,57 +66,198 @@ SocketBufferedImpl::SocketBufferedImpl(SocketBufferedImpl &&other) noexcept = de
 
 SocketBufferedImpl::~SocketBufferedImpl() = default;
 
-BufferPtr SocketBufferedImpl::GetBuffer()
+BufferPtr SocketBufferedImpl::GetBuffer(bool datagram)
+{
+  if(!classes) {
+    auto buffer = pool->GetForReceipt();
+    ResizeForReceipt(*buffer, rxBufSize);
+    return buffer;
+  }
+
+  std::optional<size_t> expected;
+  if(datagram) {
+    expected = sock->GetNextDatagramSize();
+  } else if(auto pending = sock->GetPendingSize()) {
+    expected = pending;
+  } // else TCP data is yet to arrive or the connection is closing
+
+  auto const i = classes->Select(expected);
+  auto buffer = classes->pools[i]->GetForReceipt();
+  ResizeForReceipt(*buffer, classes->sizes[i]);
+  return buffer;
+}
+
+std::optional<BufferPtr> SocketBufferedImpl::GetBuffer(bool datagram, Duration &timeout)
 {
-  auto buffer = pool->Get();
-  buffer->resize(rxBufSize);
+  if(!shared) {
+    return GetBuffer(datagram);
+  }
+
+  auto const start = Clock::now();
+  auto buffer = shared->Get(*share, timeout);
+  if(!buffer) {
+    return {std::nullopt}; // timeout exceeded
+  }
+  if(timeout.count() > 0) {
+    auto const waited = std::chrono::duration_cast<Duration>(Clock::now() - start);
+    timeout = std::max(timeout - waited, Duration(0));
+  }
+  ResizeForReceipt(**buffer, rxBufSize);
   return buffer;
 }
 
+std::optional<BufferPtr> SocketBufferedImpl::GetBufferOrDefer(bool datagram)
+{
+  if(!shared) {
+    return GetBuffer(datagram);
+  }
+
+  auto buffer = shared->GetOrDefer(*share, onAvailable);
+  if(buffer) {
+    ResizeForReceipt(**buffer, rxBufSize);
+  }
+  return buffer;
+}
+
+void SocketBufferedImpl::Received(BufferPool::Buffer &buffer, size_t size)
+{
+  buffer.resize(size);
+  if(classes) {
+    classes->Record(size);
+  }
+}
+
+BufferPoolStats SocketBufferedImpl::Stats() const
+{
+  if(shared) {
+    return shared->Stats();
+  }
+  if(classes) {
+    BufferPoolStats stats;
+    for(auto &&classPool : classes->pools) {
+      stats += classPool->Stats();
+    }
+    return stats;
+  }
+  return pool->Stats();
+}
+
+void SocketBufferedImpl::Localize(int node)
+{
+  if((node < 0) || (node == numaNode)) {
+    return;
+  }
+  numaNode = node;
+
+  if(classes) {
+    for(auto &&classPool : classes->pools) {
+      classPool->Localize();
+    }
+  } else if(pool) {
+    pool->Localize();
+  } // else shared pools are left to the sockets of all drivers
+}
+
 std::optional<BufferPtr> SocketBufferedImpl::Receive(Duration timeout)
 {
-  auto buffer = GetBuffer();
+  auto buffer = GetBuffer(false, timeout);
+  if(!buffer) {
+    return {std::nullopt}; // timeout exceeded
+  }
 
   auto received = sock->Receive(
-      const_cast<char *>(buffer->data()),
-      buffer->size(), timeout);
+      const_cast<char *>((*buffer)->data()),
+      (*buffer)->size(), timeout);
   if(received) {
-    buffer->resize(*received);
+    Received(**buffer, *received);
     return buffer;
   }
   return {std::nullopt};
 }
 
-BufferPtr SocketBufferedImpl::Receive()
+std::optional<BufferPtr> SocketBufferedImpl::Receive()
 {
-  auto buffer = GetBuffer();
+  auto buffer = GetBufferOrDefer(false);
+  if(!buffer) {
+    return {std::nullopt}; // deferred
+  }
 
   auto size = sock->Receive(
-      const_cast<char *>(buffer->data()),
-      buffer->size());
-  buffer->resize(size);
+      const_cast<char *>((*buffer)->data()),
+      (*buffer)->size());
+  Received(**buffer, size);
 
   return buffer;
 }
 
+void SocketBufferedImpl::EnableRing(size_t capacity)
+{
+  if(ring && ring->size) {
+    throw std::logic_error("receive ring holds unconsumed data");
+  }
+  ring = std::make_shared<RingBuffer>(capacity);
+
+  // leave the shared pool to the other sockets
+  share.reset();
+}
+
+std::optional<std::string_view> SocketBufferedImpl::ReceiveView(Duration timeout)
+{
+  auto [data, size] = RingWritable(ring);
+
+  auto received = sock->Receive(data, size, timeout);
+  if(received) {
+    ring->Commit(*received);
+    return ring->Readable();
+  }
+  return {std::nullopt};
+}
+
+size_t SocketBufferedImpl::ReceiveRing()
+{
+  auto [data, size] = RingWritable(ring);
+
+  auto received = sock->Receive(data, size);
+  ring->Commit(received);
+  return received;
+}
+
 std::optional<std::pair<BufferPtr, Address>>
 SocketBufferedImpl::ReceiveFrom(Duration timeout)
 {
+  // a shared buffer is awaited beforehand, other buffers may
+  // depend on the size of the datagram which requires it to be readable
+  std::optional<BufferPtr> buffer;
+  if(shared && !(buffer = GetBuffer(true, timeout))) {
+    return {std::nullopt}; // timeout exceeded
+  }
   if(!WaitReadable(this->sock->fd, timeout)) {
     return {std::nullopt}; // timeout exceeded
   }
-  return SocketBufferedImpl::ReceiveFrom();
+  if(!buffer) {
+    buffer = GetBuffer(true);
+  }
+  return ReceiveFrom(std::move(*buffer));
 }
 
-std::pair<BufferPtr, Address>
-SocketBufferedImpl::ReceiveFrom()
+std::optional<std::pair<BufferPtr, Address>>
+SocketBufferedImpl::ReceiveFrom(std::pmr::memory_resource *resource)
 {
-  auto buffer = GetBuffer();
+  auto buffer = GetBufferOrDefer(true);
+  if(!buffer) {
+    return {std::nullopt}; // deferred
+  }
+  return ReceiveFrom(std::move(*buffer), resource);
+}
 
+std::pair<BufferPtr, Address>
+SocketBufferedImpl::ReceiveFrom(BufferPtr buffer, std::pmr::memory_resource *resource)
+{
   auto [size, from] = sock->ReceiveFrom(
       const_cast<char *>(buffer->data()),
-      buffer->size());
-  buffer->resize(size);
+      buffer->size(),
+      resource);
+  Received(*buffer, size);
 
   return {
     std::move(buffer),
@@ -1,13 +1,19 @@
 #ifndef SOCKPUPPET_SOCKET_BUFFERED_IMPL_H
 #define SOCKPUPPET_SOCKET_BUFFERED_IMPL_H
 
+#include "receive_size_classes.h" // for ReceiveSizeClasses
+#include "ring_buffer.h" // for RingBuffer
+#include "shared_buffer_pool_impl.h" // for SharedBufferPoolImpl
 #include "socket_impl.h" // for SocketImpl
 #include "sockpuppet/address.h" // for Address
 #include "sockpuppet/socket_buffered.h" // for BufferPool
 
 #include <cstddef> // for size_t
+#include <functional> // for std::function
 #include <memory> // for std::unique_ptr
+#include <memory_resource> // for std::pmr::memory_resource
 #include <optional> // for std::optional
+#include <string_view> // for std::string_view
 #include <utility> // for std::pair
 
 namespace sockpuppet {
@@ -17,23 +23,53 @@ struct SocketBufferedImpl
   std::unique_ptr<SocketImpl> sock;
   size_t rxBufSize;
   std::unique_ptr<BufferPool> pool;
+  std::unique_ptr<ReceiveSizeClasses> classes; // replaces the pool if adaptive
+  std::shared_ptr<RingBuffer> ring; // replaces the pool if enabled
+  std::shared_ptr<SharedBufferPoolImpl> shared; // replaces the pool if given
+  ShareUnique share; // destroyed before the above
+  std::function<void()> onAvailable; // resumes driven receipt deferred for lack of shared buffers
+  int numaNode; // node the receive buffers were allocated on; negative if unknown
 
   SocketBufferedImpl(std::unique_ptr<SocketImpl> &&sock,
                      size_t rxBufCount,
-                     size_t rxBufSize);
+                     size_t rxBufSize,
+                     ReceiveSizing sizing = ReceiveSizing::Fixed);
+  SocketBufferedImpl(std::unique_ptr<SocketImpl> &&sock,
+                     std::shared_ptr<SharedBufferPoolImpl> shared);
   SocketBufferedImpl(SocketBufferedImpl const &) = delete;
   SocketBufferedImpl(SocketBufferedImpl &&other) noexcept;
   ~SocketBufferedImpl();
 
-  BufferPtr GetBuffer();
+  // with adaptive receive sizing, datagram sizes require a readable socket
+  BufferPtr GetBuffer(bool datagram);
+  // a shared buffer may be unavailable; blocking receipt waits for one within
+  // timeout (reduced by the time waited), while driven receipt is deferred
+  std::optional<BufferPtr> GetBuffer(bool datagram, Duration &timeout);
+  std::optional<BufferPtr> GetBufferOrDefer(bool datagram);
+  void Received(BufferPool::Buffer &buffer, size_t size);
+  // of the pool in use, i.e. of all size classes or of all sharing sockets
+  BufferPoolStats Stats() const;
+  // reallocates the idle receive buffers by the calling (driver) thread
+  // if it runs on a different NUMA node than the one they were allocated on
+  void Localize(int node);
 
   std::optional<BufferPtr> Receive(Duration timeout);
-  BufferPtr Receive();
+  // assumes a readable socket; returns nullopt if receipt is deferred
+  std::optional<BufferPtr> Receive();
+
+  void EnableRing(size_t capacity);
+  std::optional<std::string_view> ReceiveView(Duration timeout);
+  // assumes a readable socket; returns the number of bytes appended to the ring
+  size_t ReceiveRing();
 
   std::optional<std::pair<BufferPtr, Address>>
   ReceiveFrom(Duration timeout);
+  // assumes a readable socket; returns nullopt if receipt is deferred
+  std::optional<std::pair<BufferPtr, Address>>
+  ReceiveFrom(std::pmr::memory_resource *resource);
   std::pair<BufferPtr, Address>
-  ReceiveFrom();
+  ReceiveFrom(BufferPtr buffer,
+              std::pmr::memory_resource *resource = std::pmr::get_default_resource());
 };
 
 } // namespace sockpuppet
@@ -1,13 +1,30 @@
 #include "socket_impl.h"
 #include "error_code.h" // for SocketError
+#include "sigpipe.h" // for WithoutSigPipe
 
-#ifndef _WIN32
+#ifdef _WIN32
+# include <ws2tcpip.h> // for TCP_KEEPIDLE
+#else
 # include <fcntl.h> // for ::fcntl
+# ifdef __linux__
+#  include <linux/errqueue.h> // for sock_extended_err
+# endif // __linux__
+# include <netinet/in.h> // for IPPROTO_TCP
+# include <netinet/tcp.h> // for TCP_NODELAY
+# include <sys/ioctl.h> // for ::ioctl
+# ifdef __linux__
+#  include <sys/sendfile.h> // for ::sendfile
+# endif // __linux__
 # include <sys/socket.h> // for ::socket
+# include <sys/uio.h> // for iovec
 # include <unistd.h> // for ::close
 #endif // _WIN32
 
+#include <algorithm> // for std::min
 #include <cassert> // for assert
+#include <cerrno> // for EINPROGRESS
+#include <limits> // for std::numeric_limits
+#include <stdexcept> // for std::logic_error
 #include <string_view> // for std::string_view
 
 namespace sockpuppet {
@@ -58,14 +75,61 @@ void SetBlocking(SOCKET fd, bool blocking, char const *errorMessage)
   }
 }
 
-void SetSockOpt(SOCKET fd, int id, int value, char const *errorMessage)
+void SetSockOpt(SOCKET fd, int level, int id, int value, char const *errorMessage)
 {
-  if(::setsockopt(fd, SOL_SOCKET, id,
+  if(::setsockopt(fd, level, id,
        reinterpret_cast<char const *>(&value), sizeof(value))) {
     throw std::system_error(SocketError(), errorMessage);
   }
 }
 
+void SetSockOpt(SOCKET fd, int id, int value, char const *errorMessage)
+{
+  SetSockOpt(fd, SOL_SOCKET, id, value, errorMessage);
+}
+
+// unused where all options are supported
+[[noreturn, maybe_unused]] void ThrowUnsupported(char const *option)
+{
+  throw std::logic_error(std::string("socket option ") + option +
+                         " is not supported on this platform");
+}
+
+int ToInt(size_t value)
+{
+  if(value > static_cast<size_t>(std::numeric_limits<int>::max())) {
+    throw std::logic_error("socket option value out of range");
+  }
+  return static_cast<int>(value);
+}
+
+[[maybe_unused]] int ToMilliseconds(Duration duration)
+{
+  if(duration.count() < 0) {
+    throw std::logic_error("socket option value must not be negative");
+  }
+  return ToInt(static_cast<size_t>(duration.count()));
+}
+
+// keep-alive times are configured in whole seconds
+int ToSeconds(Duration duration)
+{
+  auto const count = std::chrono::duration_cast<std::chrono::seconds>(duration).count();
+  if((count < 1) || (count > std::numeric_limits<int>::max())) {
+    throw std::logic_error("socket option value out of range");
+  }
+  return static_cast<int>(count);
+}
+
+bool IsConnectPending(std::error_code const &error)
+{
+#ifdef _WIN32
+  return (error.value() == WSAEWOULDBLOCK);
+#else
+  return (error.value() == EINPROGRESS);
+#endif // _WIN32
+}
+
 template<typename T>
 T GetSockOpt(SOCKET fd, int id, char const *errorMessage)
 {
@@ -133,10 +197,11 @@ SocketImpl::ReceiveFrom(char *data, size_t size, Duration timeout)
 }
 
 std::pair<size_t, Address>
-SocketImpl::ReceiveFrom(char *data, size_t size)
+SocketImpl::ReceiveFrom(char *data, size_t size, std::pmr::memory_resource *resource)
 {
   constexpr int flags = 0;
-  auto sas = std::make_shared<SockAddrStorage>();
+  auto sas = std::allocate_shared<SockAddrStorage>(
+      std::pmr::polymorphic_allocator<SockAddrStorage>(resource));
   auto received = ::recvfrom(fd,
                              data, size,
                              flags,
@@ -171,6 +236,144 @@ size_t SocketImpl::SendSome(char const *data, size_t size)
   return SendNow(fd, data, size);
 }
 
+size_t SocketImpl::SendSomeGather(char const *header, size_t headerSize,
+    char const *payload, size_t payloadSize)
+{
+#ifdef _WIN32
+  WSABUF buffers[2] = {
+    {static_cast<ULONG>(headerSize), const_cast<char *>(header)},
+    {static_cast<ULONG>(payloadSize), const_cast<char *>(payload)}
+  };
+  DWORD sent = 0U;
+  if(::WSASend(fd, buffers, 2U, &sent, 0U, nullptr, nullptr)) {
+    throw std::system_error(SocketError(), "failed to send");
+  }
+#else
+  iovec buffers[2] = {
+    {const_cast<char *>(header), headerSize},
+    {const_cast<char *>(payload), payloadSize}
+  };
+  msghdr msg{};
+  msg.msg_iov = buffers;
+  msg.msg_iovlen = 2U;
+  auto sent = ::sendmsg(fd, &msg, sendFlags);
+  if(sent < 0) {
+    throw std::system_error(SocketError(), "failed to send");
+  }
+#endif // _WIN32
+  assert(static_cast<size_t>(sent) <= headerSize + payloadSize);
+  return static_cast<size_t>(sent);
+}
+
+size_t SocketImpl::SendZeroCopy(char const *data, size_t size)
+{
+#ifdef MSG_ZEROCOPY
+  auto sent = ::send(fd,
+                     data, size,
+                     sendFlags | MSG_ZEROCOPY);
+  if(sent < 0) {
+    if(errno == ENOBUFS) {
+      return 0U; // retry after completions have been reaped
+    }
+    throw std::system_error(SocketError(), "failed to send");
+  }
+  assert(static_cast<size_t>(sent) <= size);
+  return static_cast<size_t>(sent);
+#else
+  (void)data;
+  (void)size;
+  ThrowUnsupported("zero-copy");
+#endif // MSG_ZEROCOPY
+}
+
+std::optional<std::pair<uint32_t, uint32_t>> SocketImpl::ReceiveZeroCopyCompletion()
+{
+#if defined(MSG_ERRQUEUE) && defined(SO_EE_ORIGIN_ZEROCOPY)
+  char control[CMSG_SPACE(sizeof(sock_extended_err)) + CMSG_SPACE(sizeof(sockaddr_storage))];
+  msghdr msg{};
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  if(::recvmsg(fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+    if((errno == EAGAIN) || (errno == EWOULDBLOCK)) {
+      return std::nullopt;
+    }
+    throw std::system_error(SocketError(), "failed to receive from error queue");
+  }
+
+  for(auto cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if(((cmsg->cmsg_level == SOL_IP) && (cmsg->cmsg_type == IP_RECVERR)) ||
+       ((cmsg->cmsg_level == SOL_IPV6) && (cmsg->cmsg_type == IPV6_RECVERR))) {
+      auto err = reinterpret_cast<sock_extended_err const *>(CMSG_DATA(cmsg));
+      if(err->ee_origin == SO_EE_ORIGIN_ZEROCOPY) {
+        // [ee_info, ee_data] is the range of completed sends
+        return std::make_pair(err->ee_info, err->ee_data);
+      }
+      throw std::system_error(SocketError(static_cast<int>(err->ee_errno)),
+                              "socket error queue reported an error");
+    }
+  }
+  throw std::logic_error("unexpected socket error queue message");
+#else
+  return std::nullopt;
+#endif // MSG_ERRQUEUE
+}
+
+size_t SocketImpl::SendFile(FileSlice &slice, Duration timeout)
+{
+  auto const size = slice.size;
+  if(timeout.count() < 0) {
+    while(slice.size > 0U) {
+      (void)WaitWritable(fd, timeout);
+      (void)SendFileSome(slice);
+    }
+  } else if(timeout.count() == 0) {
+    if(WaitWritable(fd, timeout)) {
+      (void)SendFileSome(slice);
+    }
+  } else {
+    DeadlineLimited deadline(timeout);
+    do {
+      if(!WaitWritable(fd, deadline.Remaining())) {
+        break; // timeout exceeded
+      }
+      deadline.Tick();
+      (void)SendFileSome(slice);
+    } while((slice.size > 0U) && deadline.TimeLeft());
+  }
+  return size - slice.size;
+}
+
+size_t SocketImpl::SendFileSome(FileSlice &slice)
+{
+  if(slice.size == 0U) {
+    return 0U;
+  }
+
+#ifdef __linux__
+  // the kernel copies from the page cache without a user-space round trip
+  auto offset = static_cast<off_t>(slice.offset);
+  auto sent = WithoutSigPipe([&]() {
+    return ::sendfile(fd, slice.file.fd, &offset, slice.size);
+  });
+  if(sent < 0) {
+    throw std::system_error(SocketError(), "failed to send file");
+  } else if(sent == 0) {
+    throw std::runtime_error("unexpected end of file");
+  }
+#else
+  char buffer[65536];
+  auto const read = slice.file.ReadAt(buffer,
+                                      std::min(slice.size, sizeof(buffer)),
+                                      slice.offset);
+  auto sent = SendNow(fd, buffer, read);
+#endif // __linux__
+
+  assert(static_cast<size_t>(sent) <= slice.size);
+  slice.offset += static_cast<size_t>(sent);
+  slice.size -= static_cast<size_t>(sent);
+  return static_cast<size_t>(sent);
+}
+
 // UDP send will block only rarely,
 // if the user enqueues faster than the NIC can send
 // causing the OS send buffer to fill up
@@ -207,6 +410,16 @@ void SocketImpl::Connect(SockAddrView const &connectAddr)
   }
 }
 
+void SocketImpl::ConnectNonBlocking(SockAddrView const &connectAddr)
+{
+  if(::connect(fd, connectAddr.addr, connectAddr.addrLen)) {
+    auto error = SocketError(); // cache before risking another
+    if(!IsConnectPending(error)) {
+      throw std::system_error(error, "failed to connect to " + to_string(connectAddr));
+    }
+  }
+}
+
 void SocketImpl::Bind(SockAddrView const &bindAddr)
 {
   if(::bind(fd, bindAddr.addr, bindAddr.addrLen)) {
@@ -264,6 +477,102 @@ void SocketImpl::SetSockOptNoSigPipe()
 #endif // SO_NOSIGPIPE
 }
 
+void SocketImpl::SetSockOptTcp(TcpOptions const &options)
+{
+  if(options.noDelay) {
+    SetSockOpt(fd, IPPROTO_TCP, TCP_NODELAY, *options.noDelay ? 1 : 0,
+               "failed to set socket option no-delay");
+  }
+  if(options.cork) {
+#if defined(TCP_CORK)
+    SetSockOpt(fd, IPPROTO_TCP, TCP_CORK, *options.cork ? 1 : 0,
+               "failed to set socket option cork");
+#elif defined(TCP_NOPUSH)
+    SetSockOpt(fd, IPPROTO_TCP, TCP_NOPUSH, *options.cork ? 1 : 0,
+               "failed to set socket option cork");
+#else
+    ThrowUnsupported("cork");
+#endif
+  }
+  if(options.quickAck) {
+#ifdef TCP_QUICKACK
+    SetSockOpt(fd, IPPROTO_TCP, TCP_QUICKACK, *options.quickAck ? 1 : 0,
+               "failed to set socket option quick ack");
+#else
+    ThrowUnsupported("quick ack");
+#endif // TCP_QUICKACK
+  }
+  if(options.keepAlive) {
+    SetSockOpt(fd, SO_KEEPALIVE, *options.keepAlive ? 1 : 0,
+               "failed to set socket option keep-alive");
+  }
+  if(options.keepAliveIdle) {
+#if defined(TCP_KEEPIDLE)
+    SetSockOpt(fd, IPPROTO_TCP, TCP_KEEPIDLE, ToSeconds(*options.keepAliveIdle),
+               "failed to set socket option keep-alive idle time");
+#elif defined(TCP_KEEPALIVE)
+    SetSockOpt(fd, IPPROTO_TCP, TCP_KEEPALIVE, ToSeconds(*options.keepAliveIdle),
+               "failed to set socket option keep-alive idle time");
+#else
+    ThrowUnsupported("keep-alive idle time");
+#endif
+  }
+  if(options.keepAliveInterval) {
+#ifdef TCP_KEEPINTVL
+    SetSockOpt(fd, IPPROTO_TCP, TCP_KEEPINTVL, ToSeconds(*options.keepAliveInterval),
+               "failed to set socket option keep-alive interval");
+#else
+    ThrowUnsupported("keep-alive interval");
+#endif // TCP_KEEPINTVL
+  }
+  if(options.keepAliveCount) {
+#ifdef TCP_KEEPCNT
+    SetSockOpt(fd, IPPROTO_TCP, TCP_KEEPCNT, *options.keepAliveCount,
+               "failed to set socket option keep-alive probe count");
+#else
+    ThrowUnsupported("keep-alive probe count");
+#endif // TCP_KEEPCNT
+  }
+  if(options.userTimeout) {
+#ifdef TCP_USER_TIMEOUT
+    SetSockOpt(fd, IPPROTO_TCP, TCP_USER_TIMEOUT,
+               ToMilliseconds(*options.userTimeout),
+               "failed to set socket option user timeout");
+#else
+    ThrowUnsupported("user timeout");
+#endif // TCP_USER_TIMEOUT
+  }
+  if(options.notSentLowWat) {
+#ifdef TCP_NOTSENT_LOWAT
+    SetSockOpt(fd, IPPROTO_TCP, TCP_NOTSENT_LOWAT, ToInt(*options.notSentLowWat),
+               "failed to set socket option not-sent low water mark");
+#else
+    ThrowUnsupported("not-sent low water mark");
+#endif // TCP_NOTSENT_LOWAT
+  }
+  if(options.congestion) {
+#ifdef TCP_CONGESTION
+    auto &&name = *options.congestion;
+    if(::setsockopt(fd, IPPROTO_TCP, TCP_CONGESTION,
+         name.data(), static_cast<socklen_t>(name.size()))) {
+      throw std::system_error(SocketError(),
+          "failed to set socket option congestion control");
+    }
+#else
+    ThrowUnsupported("congestion control");
+#endif // TCP_CONGESTION
+  }
+}
+
+void SocketImpl::SetSockOptZeroCopy()
+{
+#ifdef SO_ZEROCOPY
+  SetSockOpt(fd, SO_ZEROCOPY, 1, "failed to set socket option zero-copy");
+#else
+  ThrowUnsupported("zero-copy");
+#endif // SO_ZEROCOPY
+}
+
 size_t SocketImpl::GetSockOptRcvBuf() const
 {
   auto size = GetSockOpt<int>(fd, SO_RCVBUF, "failed to get socket receive buffer size");
@@ -273,6 +582,42 @@ size_t SocketImpl::GetSockOptRcvBuf() const
   return static_cast<size_t>(size);
 }
 
+size_t SocketImpl::GetPendingSize() const
+{
+#ifdef _WIN32
+  unsigned long size = 0U;
+  if(::ioctlsocket(fd, static_cast<int>(FIONREAD), &size)) {
+#else
+  int size = 0;
+  if(::ioctl(fd, FIONREAD, &size)) {
+#endif // _WIN32
+    throw std::system_error(SocketError(), "failed to get socket pending size");
+  }
+  return static_cast<size_t>(size);
+}
+
+// used for UDP only
+size_t SocketImpl::GetNextDatagramSize() const
+{
+#ifdef __linux__
+  // with MSG_TRUNC, the full datagram size is returned regardless of buffer size
+  char dummy;
+  auto size = ::recv(fd, &dummy, sizeof(dummy), MSG_PEEK | MSG_TRUNC);
+  if(size < 0) {
+    throw std::system_error(SocketError(), "failed to get socket datagram size");
+  }
+  return static_cast<size_t>(size);
+#else
+  return GetPendingSize();
+#endif // __linux__
+}
+
+std::error_code SocketImpl::GetSockOptError() const
+{
+  auto error = GetSockOpt<int>(fd, SO_ERROR, "failed to get socket error");
+  return SocketError(error);
+}
+
 std::shared_ptr<SockAddrStorage> SocketImpl::GetSockName() const
 {
   auto sas = std::make_shared<SockAddrStorage>();
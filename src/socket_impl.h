@@ -2,6 +2,7 @@
 #define SOCKPUPPET_SOCKET_IMPL_H
 
 #include "address_impl.h" // for SockAddrView
+#include "file_impl.h" // for FileSlice
 #include "sockpuppet/address.h" // for Address
 #include "sockpuppet/socket.h" // for SocketTcp
 #include "wait.h" // for DeadlineLimited
@@ -14,8 +15,11 @@ using SOCKET = int;
 #endif // _WIN32
 
 #include <cstddef> // for size_t
+#include <cstdint> // for uint32_t
 #include <memory> // for std::shared_ptr
+#include <memory_resource> // for std::pmr::memory_resource
 #include <optional> // for std::optional
+#include <system_error> // for std::error_code
 #include <utility> // for std::pair
 
 namespace sockpuppet {
@@ -46,8 +50,10 @@ struct SocketImpl
 
   std::optional<std::pair<size_t, Address>>
   ReceiveFrom(char *data, size_t size, Duration timeout);
+  // the source address is allocated from resource
   std::pair<size_t, Address>
-  ReceiveFrom(char *data, size_t size);
+  ReceiveFrom(char *data, size_t size,
+              std::pmr::memory_resource *resource = std::pmr::get_default_resource());
 
   // waits for writable (repeatedly if needed)
   virtual size_t Send(char const *data,
@@ -56,6 +62,26 @@ struct SocketImpl
   // assumes a writable socket
   virtual size_t SendSome(char const *data,
                           size_t size);
+  // assumes a writable socket; sends both parts as if they were contiguous
+  virtual size_t SendSomeGather(char const *header,
+                                size_t headerSize,
+                                char const *payload,
+                                size_t payloadSize);
+  // assumes a writable socket with zero-copy enabled;
+  // data must be kept unmodified until its completion is reported,
+  // returns zero if the OS is temporarily out of notification memory
+  size_t SendZeroCopy(char const *data,
+                      size_t size);
+  // non-blocking; reports a range of completed zero-copy send sequence numbers
+  // (both inclusive) or nullopt if no zero-copy completion is pending;
+  // ranges are not guaranteed to be reported in order
+  std::optional<std::pair<uint32_t, uint32_t>> ReceiveZeroCopyCompletion();
+
+  // waits for writable (repeatedly if needed); advances the slice
+  size_t SendFile(FileSlice &slice,
+                  Duration timeout);
+  // assumes a writable socket; advances the slice
+  virtual size_t SendFileSome(FileSlice &slice);
 
   size_t SendTo(char const *data,
                 size_t size,
@@ -68,6 +94,8 @@ struct SocketImpl
   void Bind(SockAddrView const &bindAddr);
 
   virtual void Connect(SockAddrView const &connectAddr);
+  // assumes a non-blocking socket; completion is signalled by writable
+  virtual void ConnectNonBlocking(SockAddrView const &connectAddr);
 
   void Listen();
 
@@ -79,7 +107,16 @@ struct SocketImpl
   void SetSockOptReuseAddr();
   void SetSockOptBroadcast();
   void SetSockOptNoSigPipe();
+  void SetSockOptTcp(TcpOptions const &options);
+  virtual void SetSockOptZeroCopy();
   size_t GetSockOptRcvBuf() const;
+  // number of bytes receivable right away; TLS may report more than it yields
+  virtual size_t GetPendingSize() const;
+  // size of the next datagram of a readable UDP socket;
+  // the total pending size where the OS cannot tell the datagram size
+  size_t GetNextDatagramSize() const;
+  std::error_code GetSockOptError() const;
+  TcpInfo GetSockOptTcpInfo() const;
   std::shared_ptr<SockAddrStorage> GetSockName() const;
   std::shared_ptr<SockAddrStorage> GetPeerName() const;
 
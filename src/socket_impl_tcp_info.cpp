@@ -0,0 +1,41 @@
+#include "socket_impl.h"
+#include "error_code.h" // for SocketError
+
+#ifdef __linux__
+// the kernel's tcp_info is more recent than the one of <netinet/tcp.h>,
+// thus this is kept apart from the other socket options
+# include <linux/tcp.h> // for tcp_info
+# include <netinet/in.h> // for IPPROTO_TCP
+# include <sys/socket.h> // for ::getsockopt
+#endif // __linux__
+
+#include <stdexcept> // for std::logic_error
+#include <system_error> // for std::system_error
+
+namespace sockpuppet {
+
+TcpInfo SocketImpl::GetSockOptTcpInfo() const
+{
+#ifdef __linux__
+  // older kernels fill fewer fields and leave the remainder zeroed
+  tcp_info info{};
+  socklen_t size = sizeof(info);
+  if(::getsockopt(fd, IPPROTO_TCP, TCP_INFO, &info, &size)) {
+    throw std::system_error(SocketError(), "failed to get socket TCP info");
+  }
+
+  TcpInfo ret;
+  ret.rtt = std::chrono::microseconds(info.tcpi_rtt);
+  ret.rttVar = std::chrono::microseconds(info.tcpi_rttvar);
+  ret.congestionWindow = size_t(info.tcpi_snd_cwnd) * info.tcpi_snd_mss;
+  ret.retransmits = info.tcpi_total_retrans;
+  ret.bytesInFlight = size_t(info.tcpi_unacked) * info.tcpi_snd_mss;
+  ret.bytesNotSent = info.tcpi_notsent_bytes;
+  ret.deliveryRate = info.tcpi_delivery_rate;
+  return ret;
+#else
+  throw std::logic_error("socket TCP info is not supported on this platform");
+#endif // __linux__
+}
+
+} // namespace sockpuppet
@@ -5,9 +5,12 @@
 #include "wait.h" // for DeadlineLimited
 
 #include <openssl/bio.h> // for BIO
+#include <openssl/pem.h> // for PEM_read_bio_X509
 
 #include <cassert> // for assert
+#include <chrono> // for std::chrono::duration_cast
 #include <stdexcept> // for std::logic_error
+#include <utility> // for std::move
 
 namespace sockpuppet {
 
@@ -129,8 +132,81 @@ BIO_METHOD *BIO_s_sockpuppet()
   return instance.get();
 }
 
-void ConfigureCtx(SSL_CTX *ctx,
-    char const *certFilePath, char const *keyFilePath)
+struct X509Deleter
+{
+  void operator()(X509 *ptr) const noexcept
+  {
+    X509_free(ptr);
+  }
+};
+using X509Ptr = std::unique_ptr<X509, X509Deleter>;
+
+struct PKeyDeleter
+{
+  void operator()(EVP_PKEY *ptr) const noexcept
+  {
+    EVP_PKEY_free(ptr);
+  }
+};
+using PKeyPtr = std::unique_ptr<EVP_PKEY, PKeyDeleter>;
+
+// called by OpenSSL for sessions negotiated by connecting sockets,
+// i.e. at the end of the handshake or with tickets received later on
+int NewSession(SSL *ssl, SSL_SESSION *session)
+{
+  auto *sock = static_cast<SocketTlsImpl *>(SSL_get_app_data(ssl));
+  if(!sock || sock->peer.empty()) {
+    return 0; // OpenSSL releases the session
+  }
+
+  try {
+    sock->context->Store(sock->peer, session);
+    return 1; // took over the reference
+  } catch(...) {
+    return 0;
+  }
+}
+
+void ConfigureSessions(SSL_CTX *ctx, TlsSessionOptions const &options)
+{
+  // the internal cache serves resumption by session ID on the server;
+  // sessions of connecting sockets are kept per server address instead
+  long mode = SSL_SESS_CACHE_OFF;
+  if(options.serverCacheSize > 0U) {
+    mode |= SSL_SESS_CACHE_SERVER;
+    (void)SSL_CTX_sess_set_cache_size(ctx, static_cast<long>(options.serverCacheSize));
+  } else {
+    mode |= SSL_SESS_CACHE_NO_INTERNAL_STORE;
+  }
+  if(options.clientCacheSize > 0U) {
+    mode |= SSL_SESS_CACHE_CLIENT;
+    SSL_CTX_sess_set_new_cb(ctx, NewSession);
+  }
+  (void)SSL_CTX_set_session_cache_mode(ctx, mode);
+
+  static unsigned char const sessionIdContext[] = "sockpuppet";
+  if(SSL_CTX_set_session_id_context(ctx, sessionIdContext, sizeof(sessionIdContext) - 1U) <= 0) {
+    throw std::logic_error("failed to set TLS session ID context");
+  }
+
+  if(!options.tickets) {
+    // TLS 1.3 then issues tickets that refer to the server-side cache
+    (void)SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+    if((options.serverCacheSize == 0U) && (SSL_CTX_set_num_tickets(ctx, 0U) <= 0)) {
+      throw std::logic_error("failed to disable TLS session tickets");
+    }
+  }
+
+  if(options.timeout) {
+    auto const seconds = std::chrono::duration_cast<std::chrono::seconds>(*options.timeout).count();
+    if(seconds <= 0) {
+      throw std::logic_error("invalid TLS session timeout");
+    }
+    (void)SSL_CTX_set_timeout(ctx, static_cast<long>(seconds));
+  }
+}
+
+void ConfigureCtx(SSL_CTX *ctx, TlsSessionOptions const &options)
 {
   constexpr int flags =
       SSL_MODE_ENABLE_PARTIAL_WRITE | // dont block when sending long payloads
@@ -144,6 +220,12 @@ void ConfigureCtx(SSL_CTX *ctx,
     throw std::logic_error("failed to set TLS ECDH");
   }
 
+  ConfigureSessions(ctx, options);
+}
+
+void LoadFiles(SSL_CTX *ctx,
+    char const *certFilePath, char const *keyFilePath)
+{
   if(SSL_CTX_use_certificate_file(ctx, certFilePath, SSL_FILETYPE_PEM) <= 0) {
     throw std::runtime_error("failed to set certificate");
   }
@@ -152,11 +234,35 @@ void ConfigureCtx(SSL_CTX *ctx,
   }
 }
 
-AcceptorTlsImpl::CtxPtr CreateCtx(SSL_METHOD const *method,
-    char const *certFilePath, char const *keyFilePath)
+BioPtr MemoryBio(std::string_view pem)
+{
+  // read-only view of the caller's memory
+  if(auto bio = BioPtr(BIO_new_mem_buf(pem.data(), static_cast<int>(pem.size())))) {
+    return bio;
+  }
+  throw std::logic_error("failed to create memory BIO");
+}
+
+void LoadPem(SSL_CTX *ctx,
+    std::string_view certPem, std::string_view keyPem)
+{
+  auto cert = X509Ptr(PEM_read_bio_X509(
+      MemoryBio(certPem).get(), nullptr, nullptr, nullptr));
+  if(!cert || (SSL_CTX_use_certificate(ctx, cert.get()) <= 0)) {
+    throw std::runtime_error("failed to set certificate");
+  }
+  auto key = PKeyPtr(PEM_read_bio_PrivateKey(
+      MemoryBio(keyPem).get(), nullptr, nullptr, nullptr));
+  if(!key || (SSL_CTX_use_PrivateKey(ctx, key.get()) <= 0)) {
+    throw std::runtime_error("failed to set private key");
+  }
+}
+
+TlsContextImpl::CtxPtr CreateCtx(TlsSessionOptions const &options)
 {
-  if(auto ctx = AcceptorTlsImpl::CtxPtr(SSL_CTX_new(method))) {
-    ConfigureCtx(ctx.get(), certFilePath, keyFilePath);
+  // the role of each socket is set on connect/accept
+  if(auto ctx = TlsContextImpl::CtxPtr(SSL_CTX_new(TLS_method()))) {
+    ConfigureCtx(ctx.get(), options);
     return ctx;
   }
   throw std::logic_error("failed to create SSL context");
@@ -173,6 +279,8 @@ void ConfigureSsl(SSL *ssl, SocketTlsImpl *sock)
   BIO_set_data(rbio.get(), sock);
   BIO_set_data(wbio.get(), sock);
   SSL_set_bio(ssl, rbio.release(), wbio.release()); // SSL takes ownership of BIOs
+
+  (void)SSL_set_app_data(ssl, sock); // for the session callback
 }
 
 SocketTlsImpl::SslPtr CreateSsl(SSL_CTX *ctx, SocketTlsImpl *sock)
@@ -186,6 +294,80 @@ SocketTlsImpl::SslPtr CreateSsl(SSL_CTX *ctx, SocketTlsImpl *sock)
 
 } // unnamed namespace
 
+void TlsContextImpl::CtxDeleter::operator()(SSL_CTX *ptr) const noexcept
+{
+  SSL_CTX_free(ptr);
+}
+
+void TlsContextImpl::SessionDeleter::operator()(SSL_SESSION *ptr) const noexcept
+{
+  SSL_SESSION_free(ptr);
+}
+
+TlsContextImpl::TlsContextImpl(char const *certFilePath, char const *keyFilePath,
+    TlsSessionOptions const &options)
+  : sslGuard() // must be created before call to SSL_CTX_new
+  , ctx(CreateCtx(options))
+  , clientCacheSize(options.clientCacheSize)
+{
+  LoadFiles(ctx.get(), certFilePath, keyFilePath);
+}
+
+TlsContextImpl::TlsContextImpl(std::string_view certPem, std::string_view keyPem,
+    TlsSessionOptions const &options)
+  : sslGuard()
+  , ctx(CreateCtx(options))
+  , clientCacheSize(options.clientCacheSize)
+{
+  LoadPem(ctx.get(), certPem, keyPem);
+}
+
+TlsContextImpl::~TlsContextImpl() = default;
+
+void TlsContextImpl::Resume(SSL *ssl, std::string const &peer)
+{
+  std::lock_guard<std::mutex> lock(mtx);
+
+  auto it = sessions.find(peer);
+  if(it == sessions.end()) {
+    return;
+  }
+  if(SSL_SESSION_is_resumable(it->second.get())) {
+    // an expired session is refused by the server and replaced after a full handshake
+    (void)SSL_set_session(ssl, it->second.get()); // takes its own reference
+  } else {
+    sessions.erase(it);
+  }
+}
+
+void TlsContextImpl::Store(std::string const &peer, SSL_SESSION *session)
+{
+  std::lock_guard<std::mutex> lock(mtx);
+
+  auto it = sessions.find(peer);
+  if(it == sessions.end()) {
+    if(sessions.size() >= clientCacheSize) {
+      sessions.erase(sessions.begin()); // make room at the expense of an arbitrary server
+    }
+    it = sessions.emplace(peer, nullptr).first;
+  }
+  it->second.reset(session); // the latest session replaces any earlier one
+}
+
+void TlsContextImpl::Handshaken(bool isResumed)
+{
+  ++handshakes;
+  if(isResumed) {
+    ++resumed;
+  }
+}
+
+TlsSessionStats TlsContextImpl::Stats() const
+{
+  return TlsSessionStats{handshakes, resumed};
+}
+
+
 void SocketTlsImpl::SslDeleter::operator()(SSL *ptr) const noexcept
 {
   SSL_free(ptr);
@@ -193,18 +375,25 @@ void SocketTlsImpl::SslDeleter::operator()(SSL *ptr) const noexcept
 
 SocketTlsImpl::SocketTlsImpl(int family, int type, int protocol,
     char const *certFilePath, char const *keyFilePath)
+  : SocketTlsImpl(family, type, protocol,
+      std::make_shared<TlsContextImpl>(certFilePath, keyFilePath))
+{
+}
+
+SocketTlsImpl::SocketTlsImpl(int family, int type, int protocol,
+    std::shared_ptr<TlsContextImpl> context)
   : SocketImpl(family, type, protocol)
-  , sslGuard() // must be created before call to SSL_CTX_new
-  , ssl(CreateSsl( // context is reference-counted by itself -> free temporary handle
-          CreateCtx(TLS_client_method(), certFilePath, keyFilePath).get(),
-          this))
+  , sslGuard()
+  , context(std::move(context))
+  , ssl(CreateSsl(this->context->ctx.get(), this))
 {
 }
 
-SocketTlsImpl::SocketTlsImpl(SOCKET fd, SSL_CTX *ctx)
+SocketTlsImpl::SocketTlsImpl(SOCKET fd, std::shared_ptr<TlsContextImpl> context)
   : SocketImpl(fd)
   , sslGuard()
-  , ssl(CreateSsl(ctx, this))
+  , context(std::move(context))
+  , ssl(CreateSsl(this->context->ctx.get(), this))
 {
 }
 
@@ -274,14 +463,60 @@ size_t SocketTlsImpl::SendSome(char const *data, size_t size)
   return Write(data, size);
 }
 
+size_t SocketTlsImpl::SendSomeGather(char const *header, size_t headerSize,
+    char const *payload, size_t payloadSize)
+{
+  // OpenSSL encrypts from a single buffer; the payload follows once
+  // the header is complete, so failed writes are retried with identical data
+  size_t sent = 0U;
+  if(headerSize > 0U) {
+    sent = SendSome(header, headerSize);
+    if(sent < headerSize) {
+      return sent;
+    }
+  }
+  return sent + SendSome(payload, payloadSize);
+}
+
+size_t SocketTlsImpl::SendFileSome(FileSlice &)
+{
+  // file data has to be encrypted in user space and OpenSSL requires
+  // write retries with identical data which a file can't guarantee
+  throw std::logic_error("file send is not supported with TLS");
+}
+
 void SocketTlsImpl::Connect(SockAddrView const &connectAddr)
 {
   SocketImpl::Connect(connectAddr);
 
   SSL_set_connect_state(ssl.get());
+  ResumeSession(connectAddr);
   // the TLS handshake will be performed during Send/Receive
 }
 
+void SocketTlsImpl::ConnectNonBlocking(SockAddrView const &connectAddr)
+{
+  SocketImpl::ConnectNonBlocking(connectAddr);
+
+  SSL_set_connect_state(ssl.get());
+  ResumeSession(connectAddr);
+  // the TLS handshake will be performed during Send/Receive
+}
+
+void SocketTlsImpl::SetSockOptZeroCopy()
+{
+  // data is encrypted into OpenSSL's own buffers before sending anyway
+  throw std::logic_error("zero-copy send is not supported with TLS");
+}
+
+size_t SocketTlsImpl::GetPendingSize() const
+{
+  // decrypted but not yet read data plus still encrypted data, which
+  // is at least as large as the user data it carries
+  return static_cast<size_t>(SSL_pending(ssl.get())) +
+         SocketImpl::GetPendingSize();
+}
+
 void SocketTlsImpl::DriverQuery(short &events)
 {
   if(!SSL_is_init_finished(ssl.get())) {
@@ -346,11 +581,26 @@ void SocketTlsImpl::Shutdown()
   }
 }
 
+void SocketTlsImpl::ResumeSession(SockAddrView const &connectAddr)
+{
+  peer.assign(reinterpret_cast<char const *>(connectAddr.addr), connectAddr.addrLen);
+  context->Resume(ssl.get(), peer);
+}
+
+void SocketTlsImpl::CountHandshake()
+{
+  if(!isHandshaken && SSL_is_init_finished(ssl.get())) {
+    isHandshaken = true;
+    context->Handshaken(SSL_session_reused(ssl.get()) == 1);
+  }
+}
+
 size_t SocketTlsImpl::Read(char *data, size_t size)
 {
   if(HandleLastError()) {
     for(int i = 1; i <= handshakeStepsMax; ++i) {
       auto res = SSL_read(ssl.get(), data, static_cast<int>(size));
+      CountHandshake();
       if(res <= 0) {
         if(!HandleResult(res)) {
           break;
@@ -372,7 +622,7 @@ size_t SocketTlsImpl::BioRead(char *data, size_t size)
   }
 
   // (try to) receive handshake / user data and update remaining time
-  auto received = UnderDeadline([=]() -> std::optional<size_t> {
+  auto received = UnderDeadline([this, data, size]() -> std::optional<size_t> {
     return sockpuppet::Receive(this->fd, data, size, remainingTime);
   }, remainingTime);
   if(received) {
@@ -394,6 +644,7 @@ size_t SocketTlsImpl::Write(char const *data, size_t size)
 
       size_t written = 0U;
       auto res = SSL_write_ex(ssl.get(), remaining.data(), remaining.size(), &written);
+      CountHandshake();
       if(res <= 0) {
         pendingSend = remaining;
         if(!HandleResult(res)) {
@@ -478,16 +729,17 @@ bool SocketTlsImpl::HandleError(int error)
 }
 
 
-void AcceptorTlsImpl::CtxDeleter::operator()(SSL_CTX *ptr) const noexcept
+AcceptorTlsImpl::AcceptorTlsImpl(int family, int type, int protocol,
+    char const *certFilePath, char const *keyFilePath)
+  : AcceptorTlsImpl(family, type, protocol,
+      std::make_shared<TlsContextImpl>(certFilePath, keyFilePath))
 {
-  SSL_CTX_free(ptr);
 }
 
 AcceptorTlsImpl::AcceptorTlsImpl(int family, int type, int protocol,
-    char const *certFilePath, char const *keyFilePath)
+    std::shared_ptr<TlsContextImpl> context)
   : SocketImpl(family, type, protocol)
-  , sslGuard()
-  , ctx(CreateCtx(TLS_server_method(), certFilePath, keyFilePath))
+  , context(std::move(context))
 {
 }
 
@@ -496,7 +748,7 @@ AcceptorTlsImpl::~AcceptorTlsImpl() = default;
 std::pair<SocketTcp, Address> AcceptorTlsImpl::Accept()
 {
   auto [clientFd, clientAddr] = sockpuppet::Accept(this->fd);
-  auto clientSock = std::make_unique<SocketTlsImpl>(clientFd, ctx.get());
+  auto clientSock = std::make_unique<SocketTlsImpl>(clientFd, context);
 
   SSL_set_accept_state(clientSock->ssl.get());
   // the TLS handshake will be performed during Send/Receive
@@ -3,16 +3,66 @@
 
 #ifdef SOCKPUPPET_WITH_TLS
 
+#include "sockpuppet/socket.h" // for TlsSessionOptions
 #include "socket_impl.h" // for SocketImpl
 #include "ssl_guard.h" // for SslGuard
 
 #include <openssl/ssl.h> // for SSL_CTX
 
+#include <atomic> // for std::atomic
+#include <map> // for std::map
 #include <memory> // for std::unique_ptr
+#include <mutex> // for std::mutex
+#include <string> // for std::string
 #include <string_view> // for std::string_view
 
 namespace sockpuppet {
 
+// certificate, private key and caches to be shared by any number of sockets
+// both connecting and accepting; sockets keep the OpenSSL context alive by themselves
+struct TlsContextImpl
+{
+  struct CtxDeleter
+  {
+    void operator()(SSL_CTX *ptr) const noexcept;
+  };
+  using CtxPtr = std::unique_ptr<SSL_CTX, CtxDeleter>;
+
+  struct SessionDeleter
+  {
+    void operator()(SSL_SESSION *ptr) const noexcept;
+  };
+  using SessionPtr = std::unique_ptr<SSL_SESSION, SessionDeleter>;
+
+  SslGuard sslGuard;  ///< Guard to initialize OpenSSL
+  CtxPtr ctx;  ///< OpenSSL context serving client and server sockets alike
+  size_t clientCacheSize;  ///< Maximum number of server addresses to keep sessions of
+  std::mutex mtx;  ///< Guards the client-side session cache
+  std::map<std::string, SessionPtr> sessions;  ///< Latest session per server address
+  std::atomic<size_t> handshakes = 0U;  ///< Completed handshakes of all sockets
+  std::atomic<size_t> resumed = 0U;  ///< Completed handshakes that resumed a session
+
+  TlsContextImpl(char const *certFilePath,
+                 char const *keyFilePath,
+                 TlsSessionOptions const &options = TlsSessionOptions());
+  TlsContextImpl(std::string_view certPem,
+                 std::string_view keyPem,
+                 TlsSessionOptions const &options = TlsSessionOptions());
+  TlsContextImpl(TlsContextImpl const &) = delete;
+  TlsContextImpl(TlsContextImpl &&) = delete;
+  ~TlsContextImpl();
+  TlsContextImpl &operator=(TlsContextImpl const &) = delete;
+  TlsContextImpl &operator=(TlsContextImpl &&) = delete;
+
+  // offers the latest session with given server to resume on connect
+  void Resume(SSL *ssl, std::string const &peer);
+  // keeps a session negotiated with given server; takes ownership
+  void Store(std::string const &peer, SSL_SESSION *session);
+
+  void Handshaken(bool isResumed);
+  TlsSessionStats Stats() const;
+};
+
 // the interface matches SocketImpl but some implicit differences exist:
 //   may be readable but no user data can be received (only handshake data)
 //   may be writable but no user data can be sent (handshake pending)
@@ -28,20 +78,27 @@ struct SocketTlsImpl final : public SocketImpl
   using SslPtr = std::unique_ptr<SSL, SslDeleter>;
 
   SslGuard sslGuard;  ///< Guard to initialize OpenSSL
+  std::shared_ptr<TlsContextImpl> context;  ///< Configuration and session cache shared with other sockets
   SslPtr ssl;  ///< OpenSSL session
+  std::string peer;  ///< Server address as session cache key; empty unless connecting
   int lastError = SSL_ERROR_NONE;  ///< OpenSSL error cache
   std::string_view pendingSend;  ///< Buffer view to verify OpenSSL_write retry requirements
   Duration remainingTime;  ///< Use-case dependent timeout
   bool isReadable = false;  ///< Flag whether Driver has deemed us readable
   bool isWritable = false;  ///< Flag whether Driver has deemed us writable
   bool driverSendSuppressed = false;  ///< Flag whether Driver send polling was suppressed
+  bool isHandshaken = false;  ///< Flag whether handshake completion has been counted
 
   SocketTlsImpl(int family,
                 int type,
                 int protocol,
                 char const *certFilePath,
                 char const *keyFilePath);
-  SocketTlsImpl(SOCKET fd, SSL_CTX *ctx);
+  SocketTlsImpl(int family,
+                int type,
+                int protocol,
+                std::shared_ptr<TlsContextImpl> context);
+  SocketTlsImpl(SOCKET fd, std::shared_ptr<TlsContextImpl> context);
   ~SocketTlsImpl() override;
 
   // waits for readable
@@ -59,13 +116,25 @@ struct SocketTlsImpl final : public SocketImpl
   // assumes a writable socket
   size_t SendSome(char const *data,
                   size_t size) override;
+  size_t SendSomeGather(char const *header,
+                        size_t headerSize,
+                        char const *payload,
+                        size_t payloadSize) override;
+
+  size_t SendFileSome(FileSlice &slice) override;
 
   void Connect(SockAddrView const &connectAddr) override;
+  void ConnectNonBlocking(SockAddrView const &connectAddr) override;
+
+  void SetSockOptZeroCopy() override;
+  size_t GetPendingSize() const override;
 
   void DriverQuery(short &events) override;
   void DriverPending() override;
 
   void Shutdown();
+  void ResumeSession(SockAddrView const &connectAddr);
+  void CountHandshake();
   size_t Read(char *data,
               size_t size);
   size_t BioRead(char *data,
@@ -82,20 +151,17 @@ struct SocketTlsImpl final : public SocketImpl
 
 struct AcceptorTlsImpl : public SocketImpl
 {
-  struct CtxDeleter
-  {
-    void operator()(SSL_CTX *ptr) const noexcept;
-  };
-  using CtxPtr = std::unique_ptr<SSL_CTX, CtxDeleter>;
-
-  SslGuard sslGuard;  ///< Guard to initialize OpenSSL
-  CtxPtr ctx;  ///< OpenSSL context to be shared with all accepted clients
+  std::shared_ptr<TlsContextImpl> context;  ///< Shared with all accepted clients
 
   AcceptorTlsImpl(int family,
                   int type,
                   int protocol,
                   char const *certFilePath,
                   char const *keyFilePath);
+  AcceptorTlsImpl(int family,
+                  int type,
+                  int protocol,
+                  std::shared_ptr<TlsContextImpl> context);
   ~AcceptorTlsImpl() override;
 
   std::pair<SocketTcp, Address> Accept() override;
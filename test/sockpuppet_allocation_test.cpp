@@ -0,0 +1,174 @@
+#include "sockpuppet/socket_async.h" // for SocketTcpAsync
+
+#include <atomic> // for std::atomic
+#include <cstdint> // for uintptr_t
+#include <cstdlib> // for std::malloc
+#include <iostream> // for std::cout
+#include <memory_resource> // for std::pmr::synchronized_pool_resource
+#include <new> // for std::bad_alloc
+
+using namespace sockpuppet;
+
+namespace {
+
+size_t const warmupCount = 1000U;
+size_t const messageCount = 1000U;
+size_t const messageSize = 100U;
+
+// heap allocations while counting
+std::atomic<bool> counting(false);
+std::atomic<size_t> allocations(0U);
+
+void *Allocate(size_t size)
+{
+  if(counting) {
+    ++allocations;
+  }
+  if(auto ptr = std::malloc(size ? size : 1U)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+// the original pointer is stored in front of the aligned one
+void *AllocateAligned(size_t size, size_t alignment)
+{
+  auto raw = static_cast<char *>(Allocate(size + alignment + sizeof(void *)));
+  auto const address = reinterpret_cast<uintptr_t>(raw + sizeof(void *));
+  auto aligned = raw + sizeof(void *) + (alignment - address % alignment) % alignment;
+  reinterpret_cast<void **>(aligned)[-1] = raw;
+  return aligned;
+}
+
+void FreeAligned(void *ptr)
+{
+  if(ptr) {
+    std::free(static_cast<void **>(ptr)[-1]);
+  }
+}
+
+bool check(char const *message, bool success)
+{
+  std::cout << message << " - " << (success ? "ok" : "fail") << std::endl;
+  return success;
+}
+
+// sends messages one at a time and steps the driver until each has been received
+template<typename SendFn>
+size_t CountAllocations(Driver &driver, BufferPool &pool,
+    std::atomic<size_t> &received, SendFn send)
+{
+  auto transfer = [&](size_t count) {
+    for(size_t i = 0U; i < count; ++i) {
+      auto buffer = pool.Get();
+      buffer->assign(messageSize, 'a');
+      (void)send(std::move(buffer));
+
+      auto const expected = received + messageSize;
+      while(received < expected) {
+        driver.Step(std::chrono::milliseconds(10));
+      }
+    }
+  };
+
+  // let the pools of the memory resource and the buffers grow
+  transfer(warmupCount);
+
+  allocations = 0U;
+  counting = true;
+  transfer(messageCount);
+  counting = false;
+  return allocations;
+}
+
+bool TestTcp(Driver &driver, BufferPool &pool)
+{
+  Acceptor acceptor((Address()));
+  (void)acceptor.Listen(Duration(0));
+  SocketTcp clientSock(acceptor.LocalAddress());
+  auto serverSock = acceptor.Listen().value().first;
+
+  std::atomic<size_t> received(0U);
+  SocketTcpAsync server({std::move(serverSock), 4U, 1500U},
+      driver,
+      [&](BufferPtr buffer) { received += buffer->size(); },
+      [](Address, char const *) {});
+  SocketTcpAsync client({std::move(clientSock), 4U, 1500U},
+      driver,
+      [](BufferPtr) {},
+      [](Address, char const *) {});
+
+  auto count = CountAllocations(driver, pool, received,
+      [&](BufferPtr buffer) { return client.Send(std::move(buffer)); });
+  std::cout << count << " allocations for " << messageCount << " messages" << std::endl;
+  return check("steady-state TCP send and receipt should not allocate", count == 0U);
+}
+
+bool TestUdp(Driver &driver, BufferPool &pool)
+{
+  std::atomic<size_t> received(0U);
+  SocketUdpAsync server({Address(), 4U, 1500U},
+      driver,
+      [&](BufferPtr buffer, Address) { received += buffer->size(); });
+  SocketUdpAsync client({Address(), 4U, 1500U},
+      driver,
+      [](BufferPtr, Address) {});
+  auto const serverAddr = server.LocalAddress();
+
+  auto count = CountAllocations(driver, pool, received,
+      [&](BufferPtr buffer) { return client.SendTo(std::move(buffer), serverAddr); });
+  std::cout << count << " allocations for " << messageCount << " messages" << std::endl;
+  return check("steady-state UDP send and receipt should not allocate", count == 0U);
+}
+
+} // unnamed namespace
+
+// counts all heap allocations of the test, including those of the library
+
+void *operator new(size_t size)
+{
+  return Allocate(size);
+}
+
+void *operator new(size_t size, std::align_val_t alignment)
+{
+  return AllocateAligned(size, static_cast<size_t>(alignment));
+}
+
+void operator delete(void *ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+  std::free(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept
+{
+  FreeAligned(ptr);
+}
+
+void operator delete(void *ptr, size_t, std::align_val_t) noexcept
+{
+  FreeAligned(ptr);
+}
+
+int main(int, char **)
+{
+  bool success = true;
+
+  // send bookkeeping and source addresses are recycled by the pool resource
+  std::pmr::synchronized_pool_resource resource;
+  Driver driver(&resource);
+  BufferPool pool(4U, messageSize);
+
+  std::cout << "test case #1: TCP send and receipt" << std::endl;
+  success &= TestTcp(driver, pool);
+
+  std::cout << "test case #2: UDP send and receipt" << std::endl;
+  success &= TestUdp(driver, pool);
+
+  return (success ? EXIT_SUCCESS : EXIT_FAILURE);
+}
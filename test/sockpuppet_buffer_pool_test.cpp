@@ -0,0 +1,414 @@
+#include "sockpuppet/socket_async.h" // for SocketTcpAsync
+#include "sockpuppet/socket_buffered.h" // for BufferPool
+
+#include <algorithm> // for std::all_of
+#include <atomic> // for std::atomic
+#include <chrono> // for std::chrono::steady_clock
+#include <cstdint> // for uintptr_t
+#include <cstdlib> // for EXIT_SUCCESS
+#include <iostream> // for std::cout
+#include <mutex> // for std::mutex
+#include <set> // for std::set
+#include <stdexcept> // for std::runtime_error
+#include <string> // for std::string
+#include <thread> // for std::thread
+#include <utility> // for std::pair
+#include <vector> // for std::vector
+
+#ifdef __linux__
+# include <sys/syscall.h> // for SYS_move_pages
+# include <unistd.h> // for ::syscall
+#endif // __linux__
+
+using namespace sockpuppet;
+using namespace std::chrono;
+
+namespace {
+
+size_t const threadCount = 8U;
+size_t const iterations = 200000U;
+size_t const window = 8U; // buffers held by each thread at a time
+
+bool check(char const *message, bool success)
+{
+  std::cout << message << " - " << (success ? "ok" : "fail") << std::endl;
+  return success;
+}
+
+bool TestLimited()
+{
+  bool success = true;
+
+  BufferPool pool(4U, 100U);
+  std::vector<BufferPtr> buffers;
+  for(size_t i = 0U; i < 4U; ++i) {
+    buffers.push_back(pool.Get());
+  }
+  success &= check("pre-allocated buffers should have the reserved size",
+      buffers.front()->capacity() >= 100U);
+
+  try {
+    (void)pool.Get();
+    success &= check("pool should refuse to exceed its limit", false);
+  } catch(std::runtime_error const &e) {
+    success &= check(e.what(), true);
+  }
+
+  auto const recycled = buffers.back().get();
+  buffers.back()->assign("stale");
+  buffers.pop_back();
+  auto buffer = pool.Get();
+  success &= check("pool should hand out the released buffer cleared",
+      (buffer.get() == recycled) && buffer->empty());
+
+  return success;
+}
+
+bool TestUnlimited()
+{
+  bool success = true;
+
+  // spans several of the internal segments
+  BufferPool pool;
+  std::vector<BufferPtr> buffers;
+  std::set<BufferPool::Buffer *> first;
+  for(size_t i = 0U; i < 1000U; ++i) {
+    buffers.push_back(pool.Get());
+    first.insert(buffers.back().get());
+  }
+  success &= check("pool should grow with distinct buffers",
+      first.size() == 1000U);
+
+  buffers.clear();
+  std::set<BufferPool::Buffer *> second;
+  for(size_t i = 0U; i < 1000U; ++i) {
+    buffers.push_back(pool.Get());
+    second.insert(buffers.back().get());
+  }
+  success &= check("pool should reuse all released buffers",
+      first == second);
+
+  return success;
+}
+
+bool TestSizeClasses()
+{
+  bool success = true;
+
+  try {
+    BufferPool unordered({4096U, 256U}, 0U);
+    success &= check("pool should refuse size classes out of order", false);
+  } catch(std::logic_error const &e) {
+    success &= check(e.what(), true);
+  }
+
+  BufferPool pool({256U, 4096U}, 2U);
+  auto small = pool.Get(100U);
+  auto large = pool.Get(1000U);
+  success &= check("pool should pick the smallest class fitting the size",
+      (small->capacity() >= 256U) && (small->capacity() < 4096U) &&
+      (large->capacity() >= 4096U));
+
+  auto oversized = pool.Get(10000U);
+  success &= check("pool should pick the largest class for oversized buffers",
+      oversized->capacity() >= 4096U);
+
+  try {
+    (void)pool.Get(4096U);
+    success &= check("pool should refuse to exceed the limit of a class", false);
+  } catch(std::runtime_error const &e) {
+    success &= check(e.what(), true);
+  }
+  success &= check("pool should still hand out buffers of other classes",
+      pool.Get()->capacity() < 4096U);
+
+  return success;
+}
+
+bool TestStats()
+{
+  bool success = true;
+
+  // limited classes allocate all of their buffers up front
+  BufferPool pool({256U, 4096U}, 2U);
+  std::vector<BufferPtr> buffers;
+  buffers.push_back(pool.Get(100U));
+  buffers.push_back(pool.Get(100U));
+  buffers.push_back(pool.Get(1000U));
+  try {
+    (void)pool.Get(100U);
+  } catch(std::runtime_error const &) {
+  }
+  buffers.front()->resize(1000U);
+  buffers.erase(buffers.begin());
+
+  auto const stats = pool.Stats();
+  success &= check("stats should count the buffers of all size classes",
+      (stats.allocations == 4U) && (stats.busy == 2U) && (stats.idle == 2U));
+  success &= check("stats should record the maximum number of busy buffers",
+      stats.highWater == 3U);
+  success &= check("stats should count requests refused",
+      stats.exhaustions == 1U);
+  success &= check("stats should count buffers grown by the user",
+      stats.reservedSize >= 1000U + 256U + 2U * 4096U);
+
+  buffers.clear();
+  success &= check("stats should count all buffers idle once released",
+      (pool.Stats().busy == 0U) && (pool.Stats().idle == 4U));
+
+  return success;
+}
+
+#ifdef __linux__
+// whether the pages of the memory are backed, i.e. have been touched
+bool IsResident(char const *data, size_t size)
+{
+  auto const pageSize = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+  auto const first = reinterpret_cast<uintptr_t>(data) / pageSize * pageSize;
+  std::vector<void *> pages;
+  for(auto page = first; page < reinterpret_cast<uintptr_t>(data) + size; page += pageSize) {
+    pages.push_back(reinterpret_cast<void *>(page));
+  }
+
+  // without target nodes, the status is the node of each page or -ENOENT
+  std::vector<int> status(pages.size());
+  if(::syscall(SYS_move_pages, 0, pages.size(), pages.data(),
+               nullptr, status.data(), 0)) {
+    return false;
+  }
+  return std::all_of(status.begin(), status.end(), [](int node) { return node >= 0; });
+}
+#endif // __linux__
+
+bool TestNuma()
+{
+  bool success = true;
+
+  // buffers preallocated here are reallocated by the (driver) thread localizing;
+  // large enough to be mapped freshly rather than taken from the heap
+  size_t const bufferSize = 1U << 20U;
+  BufferPool pool(1U, bufferSize);
+  auto const before = pool.Get()->data();
+  std::thread(&BufferPool::Localize, &pool).join();
+  auto buffer = pool.Get();
+  success &= check("pool should reallocate idle buffers when localizing",
+      (buffer->data() != before) && (buffer->capacity() >= bufferSize) &&
+      (pool.Stats().allocations == 1U));
+#ifdef __linux__
+  success &= check("localizing thread should have touched the buffer pages",
+      IsResident(buffer->data(), buffer->capacity()));
+#endif // __linux__
+  buffer.reset();
+
+  Driver driver;
+  try {
+    driver.SetNumaNode(100000U);
+    success &= check("driver should refuse an unknown NUMA node", false);
+  } catch(std::runtime_error const &e) {
+    success &= check(e.what(), true);
+  }
+
+  std::thread([&driver]() { driver.Step(Duration(0)); }).join();
+  success &= check("unbound driver should not report a NUMA node",
+      !driver.NumaNode());
+
+  try {
+    driver.SetNumaNode(0U);
+    std::thread([&driver]() { driver.Step(Duration(0)); }).join();
+    success &= check("driver should run on the NUMA node set",
+        driver.NumaNode() == 0U);
+  } catch(std::exception const &e) {
+    std::cout << "NUMA binding is not supported: " << e.what() << std::endl;
+  }
+
+  return success;
+}
+
+bool TestConcurrent()
+{
+  // buffers are tagged by their holder, so one handed out twice is detected
+  BufferPool pool;
+  std::atomic<size_t> corrupted(0U);
+  auto worker = [&](size_t id) {
+    std::vector<std::pair<BufferPtr, std::string>> held(window);
+    for(size_t i = 0U; i < iterations; ++i) {
+      auto &&[buffer, tag] = held[i % window];
+      if(buffer && (*buffer != tag)) {
+        ++corrupted;
+      }
+      buffer = pool.Get();
+      tag = std::to_string(id) + ":" + std::to_string(i);
+      buffer->assign(tag);
+    }
+  };
+
+  auto const start = steady_clock::now();
+  std::vector<std::thread> threads;
+  for(size_t id = 0U; id < threadCount; ++id) {
+    threads.emplace_back(worker, id);
+  }
+  for(auto &&thread : threads) {
+    thread.join();
+  }
+  auto const elapsed = duration<double>(steady_clock::now() - start).count();
+
+  std::cout << threadCount << " threads: "
+            << static_cast<double>(threadCount * iterations) / elapsed / 1e6
+            << " million get/release pairs per second" << std::endl;
+  return check("no buffer should be handed out twice", corrupted == 0U);
+}
+
+// client and server side of a new connection
+std::pair<SocketTcp, SocketTcp> Connect(Acceptor &acceptor)
+{
+  (void)acceptor.Listen(Duration(0));
+  SocketTcp client(acceptor.LocalAddress());
+  return {std::move(client), acceptor.Listen().value().first};
+}
+
+void Send(SocketTcp &client, char const *data)
+{
+  (void)client.Send(data, std::char_traits<char>::length(data));
+}
+
+bool TestSharedBlocking()
+{
+  bool success = true;
+
+  try {
+    SharedBufferPool tooSmall(99U, 100U);
+    success &= check("shared pool should refuse a budget below the buffer size", false);
+  } catch(std::logic_error const &e) {
+    success &= check(e.what(), true);
+  }
+
+  // the budget allows for one buffer per socket
+  Acceptor acceptor((Address()));
+  SharedBufferPool pool(200U, 100U);
+  auto [clientA, serverA] = Connect(acceptor);
+  auto [clientB, serverB] = Connect(acceptor);
+  SocketTcpBuffered a(std::move(serverA), pool);
+  SocketTcpBuffered b(std::move(serverB), pool);
+
+  Send(clientA, "a1");
+  auto held = a.Receive(seconds(1)).value();
+  Send(clientA, "a2");
+  success &= check("socket should defer receipt beyond its share",
+      !a.Receive(milliseconds(100)));
+
+  Send(clientB, "b");
+  success &= check("other socket should receive within its share",
+      *b.Receive(seconds(1)).value() == "b");
+  auto const stats = pool.Stats();
+  success &= check("shared pool stats should count deferred receipt",
+      (stats.busy == 1U) && (stats.highWater == 2U) && (stats.exhaustions == 1U) &&
+      (b.ReceiveBufferStats().allocations == stats.allocations));
+
+  std::thread release([&held]() {
+    std::this_thread::sleep_for(milliseconds(100));
+    held.reset();
+  });
+  auto deferred = a.Receive(seconds(1));
+  release.join();
+  success &= check("socket should receive once its buffer is released",
+      deferred && (**deferred == "a2"));
+
+  return success;
+}
+
+bool TestSharedDriven()
+{
+  bool success = true;
+
+  // a single buffer for the socket to receive into
+  Acceptor acceptor((Address()));
+  SharedBufferPool pool(100U, 100U);
+  auto [client, server] = Connect(acceptor);
+
+  Driver driver;
+  std::mutex mtx;
+  std::vector<BufferPtr> held;
+  std::atomic<bool> disconnected(false);
+  SocketTcpAsync sock(SocketTcpBuffered(std::move(server), pool),
+      driver,
+      [&](BufferPtr buffer) {
+        std::lock_guard<std::mutex> lock(mtx);
+        held.push_back(std::move(buffer));
+      },
+      [&](Address, char const *) {
+        disconnected = true;
+      });
+  auto thread = std::thread(&Driver::Run, &driver);
+
+  auto heldCount = [&]() {
+    std::lock_guard<std::mutex> lock(mtx);
+    return held.size();
+  };
+  auto awaitHeld = [&]() {
+    for(int i = 0; (i < 100) && (heldCount() == 0U); ++i) {
+      std::this_thread::sleep_for(milliseconds(10));
+    }
+  };
+  // buffers are released without the lock that the receive handler takes
+  auto releaseHeld = [&]() {
+    std::vector<BufferPtr> released;
+    std::lock_guard<std::mutex> lock(mtx);
+    released.swap(held);
+    return released;
+  };
+
+  Send(client, "1");
+  awaitHeld();
+  Send(client, "2");
+  std::this_thread::sleep_for(milliseconds(100));
+  success &= check("socket should defer receipt while out of buffers",
+      (heldCount() == 1U) && !disconnected);
+
+  auto released = releaseHeld();
+  success &= check("socket should have received the first data",
+      (released.size() == 1U) && (*released.front() == "1"));
+  released.clear();
+  awaitHeld();
+  released = releaseHeld();
+  success &= check("socket should resume receipt once a buffer is released",
+      (released.size() == 1U) && (*released.front() == "2"));
+  released.clear();
+
+  driver.Stop();
+  thread.join();
+
+  return success;
+}
+
+} // unnamed namespace
+
+int main(int, char **)
+{
+  bool success = true;
+
+  std::cout << "test case #1: limited pool" << std::endl;
+  success &= TestLimited();
+
+  std::cout << "test case #2: unlimited pool" << std::endl;
+  success &= TestUnlimited();
+
+  std::cout << "test case #3: size classes" << std::endl;
+  success &= TestSizeClasses();
+
+  std::cout << "test case #4: usage statistics" << std::endl;
+  success &= TestStats();
+
+  std::cout << "test case #5: NUMA locality" << std::endl;
+  success &= TestNuma();
+
+  std::cout << "test case #6: concurrent use" << std::endl;
+  success &= TestConcurrent();
+
+  std::cout << "test case #7: shared pool with blocking receipt" << std::endl;
+  success &= TestSharedBlocking();
+
+  std::cout << "test case #8: shared pool with driven receipt" << std::endl;
+  success &= TestSharedDriven();
+
+  return (success ? EXIT_SUCCESS : EXIT_FAILURE);
+}
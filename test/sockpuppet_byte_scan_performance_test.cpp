@@ -0,0 +1,105 @@
+#include "../src/byte_scan.h" // for FindAllBytes
+
+#include <chrono> // for std::chrono::steady_clock
+#include <cstdlib> // for EXIT_SUCCESS
+#include <iostream> // for std::cout
+#include <random> // for std::default_random_engine
+#include <string> // for std::string
+#include <utility> // for std::pair
+#include <vector> // for std::vector
+
+using namespace sockpuppet;
+using namespace std::chrono;
+
+namespace {
+
+size_t const textSize = 64U * 1024U * 1024U;
+size_t const repetitions = 10U;
+
+// printable lines of random length, as in line-oriented text protocols
+std::string MakeText(size_t size, size_t minLine, size_t maxLine)
+{
+  std::default_random_engine generator;
+  std::uniform_int_distribution<size_t> lineLength(minLine, maxLine);
+  std::uniform_int_distribution<int> character('!', '~');
+
+  std::string text;
+  text.reserve(size);
+  while(text.size() < size) {
+    for(auto length = lineLength(generator); length > 0U; --length) {
+      text.push_back(static_cast<char>(character(generator)));
+    }
+    text.push_back('\n');
+  }
+  text.resize(size);
+  return text;
+}
+
+bool check(char const *message, bool success)
+{
+  std::cout << message << " - " << (success ? "ok" : "fail") << std::endl;
+  return success;
+}
+
+template<typename Fn>
+double Throughput(Fn &&findAll, std::string const &text, std::vector<size_t> &offsets)
+{
+  auto const start = steady_clock::now();
+  for(size_t i = 0U; i < repetitions; ++i) {
+    offsets.clear();
+    findAll(text, '\n', offsets);
+  }
+  auto const elapsed = duration<double>(steady_clock::now() - start).count();
+  return static_cast<double>(text.size() * repetitions) / elapsed / 1e9;
+}
+
+} // unnamed namespace
+
+int main(int, char **)
+{
+  bool success = true;
+
+  std::cout << "vectorized scan uses " << FindAllBytesIsa() << std::endl;
+
+  {
+    // matches at block borders and in the unaligned tail
+    std::vector<size_t> simd;
+    std::vector<size_t> reference;
+    auto const text = MakeText(1000U, 0U, 40U);
+    for(size_t offset = 0U; offset < 64U; ++offset) {
+      for(size_t size = 0U; offset + size <= 200U; ++size) {
+        auto view = std::string_view(text).substr(offset, size);
+        simd.clear();
+        reference.clear();
+        FindAllBytes(view, '\n', simd);
+        FindAllBytesMemchr(view, '\n', reference);
+        if(simd != reference) {
+          success &= check("vectorized scan should match memchr", false);
+          break;
+        }
+      }
+    }
+  }
+
+  for(auto [minLine, maxLine] : {std::pair<size_t, size_t>{8U, 32U},
+                                 std::pair<size_t, size_t>{40U, 120U},
+                                 std::pair<size_t, size_t>{1000U, 4000U}}) {
+    auto const text = MakeText(textSize, minLine, maxLine);
+    std::cout << "lines of " << minLine << " to " << maxLine << " bytes" << std::endl;
+
+    std::vector<size_t> simd;
+    std::vector<size_t> reference;
+    simd.reserve(textSize / minLine);
+    reference.reserve(textSize / minLine);
+
+    auto const simdThroughput = Throughput(FindAllBytes, text, simd);
+    auto const memchrThroughput = Throughput(FindAllBytesMemchr, text, reference);
+    std::cout << "  " << FindAllBytesIsa() << ": " << simdThroughput << " GB/s\n"
+              << "  memchr: " << memchrThroughput << " GB/s" << std::endl;
+
+    success &= check("vectorized scan should find all line ends",
+        simd == reference);
+  }
+
+  return (success ? EXIT_SUCCESS : EXIT_FAILURE);
+}
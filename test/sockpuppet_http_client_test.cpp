@@ -0,0 +1,319 @@
+#include "sockpuppet_test_common.h" // for MakeTestSocket
+
+#include "sockpuppet/http_async.h" // for HttpClientAsync
+
+#include <atomic> // for std::atomic
+#include <cstdlib> // for EXIT_SUCCESS
+#include <functional> // for std::function
+#include <future> // for std::future
+#include <iostream> // for std::cout
+#include <list> // for std::list
+#include <memory> // for std::shared_ptr
+#include <mutex> // for std::mutex
+#include <optional> // for std::optional
+#include <string> // for std::string
+#include <thread> // for std::thread
+#include <vector> // for std::vector
+
+using namespace sockpuppet;
+using namespace std::chrono;
+
+namespace {
+
+HttpResponse const health(200U, "text/plain", "OK");
+
+// answers requests without body with canned data; a response of
+// nullopt closes the connection and an empty one is never sent
+struct ScriptedServer
+{
+  using Script = std::function<std::optional<std::string>(std::string_view request)>;
+
+  struct Peer
+  {
+    std::string pending;
+    std::optional<SocketTcpAsync> sock;
+  };
+
+  Driver &driver;
+  Script script;
+  std::atomic<size_t> connectCount;
+  std::mutex mtx;
+  std::list<Peer> peers;
+  AcceptorAsync acceptor;
+
+  ScriptedServer(Driver &driver, Script script)
+    : driver(driver)
+    , script(std::move(script))
+    , connectCount(0U)
+    , acceptor(MakeTestSocket<Acceptor>(Address()),
+               driver,
+               std::bind(&ScriptedServer::HandleConnect,
+                         this,
+                         std::placeholders::_1,
+                         std::placeholders::_2))
+  {
+  }
+
+  void HandleConnect(SocketTcp clientSock, Address)
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    auto it = peers.emplace(peers.end());
+    it->sock.emplace(
+        SocketTcpBuffered(std::move(clientSock)),
+        driver,
+        std::bind(&ScriptedServer::HandleReceive, this, it, std::placeholders::_1),
+        [this, it](Address, char const *) {
+          std::lock_guard<std::mutex> lock(mtx);
+          peers.erase(it);
+        });
+    ++connectCount;
+  }
+
+  void HandleReceive(std::list<Peer>::iterator it, BufferPtr buffer)
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    it->pending.append(*buffer);
+    buffer.reset(); // belongs to the pool of the socket which may be closed below
+    for(auto end = it->pending.find("\r\n\r\n");
+        end != std::string::npos;
+        end = it->pending.find("\r\n\r\n")) {
+      auto const request = it->pending.substr(0U, end + 4U);
+      it->pending.erase(0U, end + 4U);
+
+      auto response = script(request);
+      if(!response) {
+        peers.erase(it);
+        return;
+      }
+      if(!response->empty()) {
+        (void)it->sock->Send(TestData::ToBufferPtr(response->data(), response->size()));
+      }
+    }
+  }
+};
+
+HttpClientAsync MakeClient(Driver &driver, size_t pipelineDepth = 1U)
+{
+  return MakeTestSocket<HttpClientAsync>(
+        driver,
+        1U, // connections per host
+        pipelineDepth,
+        seconds(60), // idle timeout
+        seconds(1), // connect timeout
+        4096U); // maximum response size
+}
+
+// result of a request as "<status> <body>" or "error: <reason>"
+std::future<std::string> Request(HttpClientAsync &client, Address const &serverAddr,
+    std::string_view method, std::string_view target, std::string_view body = {},
+    Duration timeout = seconds(2))
+{
+  auto promise = std::make_shared<std::promise<std::string>>();
+  auto future = promise->get_future();
+  client.Request(serverAddr, method, target, {}, body,
+      [promise](HttpResponseView const &response) {
+        promise->set_value(std::to_string(response.status) + " " +
+                           std::string(response.body));
+      },
+      [promise](char const *reason) {
+        promise->set_value(std::string("error: ") + reason);
+      },
+      timeout);
+  return future;
+}
+
+std::string Await(std::future<std::string> future)
+{
+  if(future.wait_for(seconds(5)) != std::future_status::ready) {
+    return "no result";
+  }
+  auto result = future.get();
+  std::cout << result << std::endl;
+  return result;
+}
+
+bool check(char const *message, bool success)
+{
+  std::cout << message << " - " << (success ? "ok" : "fail") << std::endl;
+  return success;
+}
+
+bool TestKeepAlive(Driver &serverDriver, Driver &clientDriver)
+{
+  bool success = true;
+
+  HttpResponse echo(200U);
+  HttpServerAsync server(MakeTestSocket<Acceptor>(Address()),
+      serverDriver,
+      [&echo](HttpRequest const &request) -> HttpResponse const & {
+        if(request.method == "POST") {
+          echo = HttpResponse(200U, "text/plain", request.body);
+          return echo;
+        }
+        return health;
+      });
+  auto client = MakeClient(clientDriver, 4U);
+
+  // requests beyond the pipeline depth wait for earlier responses
+  std::vector<std::future<std::string>> results;
+  for(int i = 0; i < 10; ++i) {
+    results.push_back(Request(client, server.LocalAddress(), "GET", "/health"));
+  }
+  results.push_back(Request(client, server.LocalAddress(), "POST", "/echo", "hello"));
+
+  bool allAnswered = true;
+  for(size_t i = 0U; i + 1U < results.size(); ++i) {
+    allAnswered &= (Await(std::move(results[i])) == "200 OK");
+  }
+  success &= check("client should receive pipelined responses in order", allAnswered);
+  success &= check("client should send a request body",
+      Await(std::move(results.back())) == "200 hello");
+  success &= check("client should reuse a single connection",
+      (client.ConnectionCount() == 1U) && (server.ConnectionCount() == 1U));
+
+  return success;
+}
+
+bool TestFraming(Driver &serverDriver, Driver &clientDriver)
+{
+  bool success = true;
+
+  ScriptedServer server(serverDriver,
+    [](std::string_view request) -> std::optional<std::string> {
+      if(request.find("HEAD ") == 0U) {
+        return "HTTP/1.1 200 OK\r\nContent-Length: 100\r\n\r\n";
+      } else if(request.find(" /chunked ") != std::string_view::npos) {
+        // the client receives the first chunk separately
+        return "HTTP/1.1 100 Continue\r\n\r\n"
+               "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+               "5\r\nhello\r\n";
+      } else if(request.find(" /length ") != std::string_view::npos) {
+        return "HTTP/1.1 200 OK\r\nContent-Length: 4\r\n\r\ndata";
+      }
+      return "HTTP/1.0 200 OK\r\n\r\nuntil close";
+    });
+  auto serverAddr = server.acceptor.LocalAddress();
+  auto client = MakeClient(clientDriver);
+
+  {
+    auto result = Request(client, serverAddr, "GET", "/chunked");
+    std::this_thread::sleep_for(milliseconds(100));
+    {
+      std::lock_guard<std::mutex> lock(server.mtx);
+      static char const rest[] = "6;ext=1\r\n world\r\n0\r\nX-Trailer: 1\r\n\r\n";
+      (void)server.peers.front().sock->Send(TestData::ToBufferPtr(rest, sizeof(rest) - 1U));
+    }
+    success &= check("client should decode a chunked response after an interim one",
+        Await(std::move(result)) == "200 hello world");
+  }
+  success &= check("client should receive a content-length response",
+      Await(Request(client, serverAddr, "GET", "/length")) == "200 data");
+  success &= check("client should not expect a body in response to HEAD",
+      Await(Request(client, serverAddr, "HEAD", "/length")) == "200 ");
+  success &= check("client should reuse the connection",
+      (client.ConnectionCount() == 1U) && (server.connectCount == 1U));
+
+  {
+    auto result = Request(client, serverAddr, "GET", "/close");
+    std::this_thread::sleep_for(milliseconds(100));
+    {
+      std::lock_guard<std::mutex> lock(server.mtx);
+      server.peers.clear();
+    }
+    success &= check("client should receive a response delimited by close",
+        Await(std::move(result)) == "200 until close");
+  }
+  success &= check("client should drop the closed connection",
+      client.ConnectionCount() == 0U);
+
+  return success;
+}
+
+bool TestRetry(Driver &serverDriver, Driver &clientDriver)
+{
+  bool success = true;
+
+  // the first connection is closed without a response
+  ScriptedServer *ptr = nullptr;
+  ScriptedServer server(serverDriver,
+    [&ptr](std::string_view) -> std::optional<std::string> {
+      if(ptr->connectCount == 1U) {
+        return std::nullopt;
+      }
+      return "HTTP/1.1 200 OK\r\nContent-Length: 7\r\n\r\nretried";
+    });
+  ptr = &server;
+  auto serverAddr = server.acceptor.LocalAddress();
+  auto client = MakeClient(clientDriver);
+
+  success &= check("client should retry an idempotent request",
+      Await(Request(client, serverAddr, "GET", "/")) == "200 retried");
+  success &= check("client should have connected again",
+      server.connectCount == 2U);
+
+  server.connectCount = 1U; // close the next connection again
+  auto result = Await(Request(client, serverAddr, "POST", "/", "data"));
+  success &= check("client should not retry a non-idempotent request",
+      result.find("error: ") == 0U);
+
+  return success;
+}
+
+bool TestErrors(Driver &serverDriver, Driver &clientDriver)
+{
+  bool success = true;
+
+  ScriptedServer server(serverDriver,
+    [](std::string_view) -> std::optional<std::string> {
+      return std::string(); // never answer
+    });
+  auto client = MakeClient(clientDriver);
+
+  success &= check("client should report a request timeout",
+      Await(Request(client, server.acceptor.LocalAddress(), "GET", "/",
+                    {}, milliseconds(100))) == "error: request timed out");
+  success &= check("client should close the connection of the timed out request",
+      client.ConnectionCount() == 0U);
+
+  // a bound but not listening socket refuses connections
+  Acceptor notListening(Address{});
+  success &= check("client should report a connect error",
+      Await(Request(client, notListening.LocalAddress(), "GET", "/")).find("error: ") == 0U);
+
+  return success;
+}
+
+} // unnamed namespace
+
+int main(int, char **)
+{
+  bool success = true;
+
+  // the server is run by a separate driver to send partial responses
+  Driver serverDriver;
+  auto serverThread = std::thread(&Driver::Run, &serverDriver);
+  Driver clientDriver;
+  auto clientThread = std::thread(&Driver::Run, &clientDriver);
+
+  std::cout << "test case #1: keep-alive and pipelining" << std::endl;
+  success &= TestKeepAlive(serverDriver, clientDriver);
+
+  std::cout << "test case #2: response framing" << std::endl;
+  success &= TestFraming(serverDriver, clientDriver);
+
+  std::cout << "test case #3: retry on connection close" << std::endl;
+  success &= TestRetry(serverDriver, clientDriver);
+
+  std::cout << "test case #4: timeout and connect error" << std::endl;
+  success &= TestErrors(serverDriver, clientDriver);
+
+  for(auto [driver, thread] : {std::make_pair(&serverDriver, &serverThread),
+                               std::make_pair(&clientDriver, &clientThread)}) {
+    if(thread->joinable()) {
+      driver->Stop();
+      thread->join();
+    }
+  }
+
+  return (success ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -0,0 +1,278 @@
+#include "sockpuppet_test_common.h" // for MakeTestSocket
+
+#include "sockpuppet/http_async.h" // for HttpServerAsync
+
+#include <cstdlib> // for EXIT_SUCCESS
+#include <fstream> // for std::ifstream
+#include <iostream> // for std::cout
+#include <iterator> // for std::istreambuf_iterator
+#include <string> // for std::string
+#include <thread> // for std::thread
+
+using namespace sockpuppet;
+using namespace std::chrono;
+
+namespace {
+
+HttpResponse const health(200U, "text/plain", "OK");
+HttpResponse const notFound(404U);
+
+struct Server
+{
+  HttpServerAsync http;
+  HttpResponse echo; // reused for all echo responses
+
+  Server(Driver &driver, Duration idleTimeout = seconds(60))
+    : http(MakeTestSocket<Acceptor>(Address()),
+           driver,
+           std::bind(&Server::HandleRequest, this, std::placeholders::_1),
+           idleTimeout,
+           1024U)
+    , echo(200U)
+  {
+  }
+
+  HttpResponse const &HandleRequest(HttpRequest const &request)
+  {
+    if(request.target == "/health") {
+      return health;
+    } else if((request.method == "POST") && (request.target == "/echo")) {
+      echo = HttpResponse(200U,
+                          request.Header("content-type").value_or(""),
+                          request.body);
+      return echo;
+    }
+    return notFound;
+  }
+};
+
+std::string WithConnectionHeader(HttpResponse const &response,
+    std::string_view value)
+{
+  return response.wire.substr(0U, response.headSize) +
+         "Connection: " + std::string(value) + "\r\n" +
+         response.wire.substr(response.headSize);
+}
+
+// receive until the expected amount of data or the connection is closed
+std::string ReceiveResponses(SocketTcp &client, size_t size, bool expectClose, bool &closed)
+{
+  std::string received;
+  char buffer[1024];
+  closed = false;
+  try {
+    while(received.size() < size) {
+      auto rx = client.Receive(buffer, sizeof(buffer), seconds(1));
+      if(!rx) {
+        break;
+      }
+      received.append(buffer, *rx);
+    }
+
+    // look for the close (or unexpected data) on connections not used anymore
+    // as a TLS socket waits for readable on send after its receipt timed out
+    if(expectClose) {
+      if(auto rx = client.Receive(buffer, sizeof(buffer), seconds(1))) {
+        received.append(buffer, *rx);
+      }
+    }
+  } catch(std::exception const &e) {
+    std::cout << e.what() << std::endl;
+    closed = true;
+  }
+  return received;
+}
+
+bool check(char const *message, bool success)
+{
+  std::cout << message << " - " << (success ? "ok" : "fail") << std::endl;
+  return success;
+}
+
+bool TestPipelined(Driver &driver)
+{
+  bool success = true;
+
+  Server server(driver);
+  auto client = MakeTestSocket<SocketTcp>(server.http.LocalAddress());
+
+  // requests back-to-back, some of them split across sends
+  std::string const requests =
+      "GET /health HTTP/1.1\r\nHost: test\r\n\r\n"
+      "POST /echo HTTP/1.1\r\nContent-Type: text/plain\r\nContent-Length: 5\r\n\r\nhello"
+      "HEAD /health HTTP/1.1\r\n\r\n"
+      "GET /nothing HTTP/1.1\r\n\r\n";
+  auto const expected =
+      health.wire +
+      HttpResponse(200U, "text/plain", "hello").wire +
+      health.wire.substr(0U, health.headSize + 2U) +
+      notFound.wire;
+  (void)client.Send(requests.data(), 50U);
+  std::this_thread::sleep_for(milliseconds(50));
+  (void)client.Send(requests.data() + 50U, requests.size() - 50U);
+
+  bool closed;
+  auto received = ReceiveResponses(client, expected.size(), false, closed);
+  success &= check("server should answer pipelined requests in order",
+      received == expected);
+  success &= check("server should keep the connection open",
+      !closed && (server.http.ConnectionCount() == 1U));
+
+  // another round on the same connection
+  static char const request[] = "GET /health HTTP/1.1\r\n\r\n";
+  (void)client.Send(request, sizeof(request) - 1U);
+  received = ReceiveResponses(client, health.wire.size(), false, closed);
+  success &= check("server should answer subsequent requests on the same connection",
+      received == health.wire);
+
+  return success;
+}
+
+bool TestConnectionClose(Driver &driver)
+{
+  bool success = true;
+
+  Server server(driver);
+  {
+    auto client = MakeTestSocket<SocketTcp>(server.http.LocalAddress());
+    static char const request[] =
+        "GET /health HTTP/1.1\r\nConnection: close\r\n\r\n"
+        "GET /health HTTP/1.1\r\n\r\n";
+    (void)client.Send(request, sizeof(request) - 1U);
+
+    bool closed;
+    auto expected = WithConnectionHeader(health, "close");
+    auto received = ReceiveResponses(client, expected.size(), true, closed);
+    success &= check("server should answer the last request only and close",
+        (received == expected) && closed);
+  }
+  {
+    auto client = MakeTestSocket<SocketTcp>(server.http.LocalAddress());
+    static char const request[] = "GET /health HTTP/1.0\r\nConnection: Keep-Alive\r\n\r\n";
+    (void)client.Send(request, sizeof(request) - 1U);
+
+    bool closed;
+    auto expected = WithConnectionHeader(health, "keep-alive");
+    auto received = ReceiveResponses(client, expected.size(), false, closed);
+    success &= check("server should keep an HTTP/1.0 connection open on request",
+        (received == expected) && !closed);
+
+    static char const lastRequest[] = "GET /health HTTP/1.0\r\n\r\n";
+    (void)client.Send(lastRequest, sizeof(lastRequest) - 1U);
+    expected = WithConnectionHeader(health, "close");
+    received = ReceiveResponses(client, expected.size(), true, closed);
+    success &= check("server should close an HTTP/1.0 connection by default",
+        (received == expected) && closed);
+  }
+
+  return success;
+}
+
+bool TestRejected(Driver &driver)
+{
+  bool success = true;
+
+  Server server(driver);
+  for(auto [request, status] : {
+        std::pair<std::string, unsigned int>{"GARBAGE\r\n\r\n", 400U},
+        {"GET / HTTP/2.0\r\n\r\n", 505U},
+        {"POST /echo HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n", 501U},
+        {"POST /echo HTTP/1.1\r\nContent-Length: 5000\r\n\r\n", 413U},
+        {"GET / HTTP/1.1\r\n" + std::string(2000U, 'x'), 431U}}) {
+    auto client = MakeTestSocket<SocketTcp>(server.http.LocalAddress());
+    (void)client.Send(request.data(), request.size());
+
+    bool closed;
+    auto expected = WithConnectionHeader(HttpResponse(status), "close");
+    auto received = ReceiveResponses(client, expected.size(), true, closed);
+    std::cout << "status " << status << ": ";
+    success &= check("server should reject the request and close",
+        (received == expected) && closed);
+  }
+
+  return success;
+}
+
+bool TestIdleTimeout(Driver &driver)
+{
+  bool success = true;
+
+  Server server(driver, milliseconds(100));
+  auto client = MakeTestSocket<SocketTcp>(server.http.LocalAddress());
+  std::this_thread::sleep_for(milliseconds(50));
+  success &= check("server should hold the new connection",
+      server.http.ConnectionCount() == 1U);
+
+  std::this_thread::sleep_for(milliseconds(200));
+  success &= check("server should close the idle connection",
+      server.http.ConnectionCount() == 0U);
+
+  return success;
+}
+
+bool TestFile(Driver &driver, char const *filePath)
+{
+  bool success = true;
+
+  auto const file = HttpResponse::File(200U, "application/octet-stream", filePath);
+  HttpServerAsync http(MakeTestSocket<Acceptor>(Address()),
+                       driver,
+                       [&file](HttpRequest const &request) -> HttpResponse const & {
+                         return (request.target == "/file" ? file : health);
+                       });
+  auto client = MakeTestSocket<SocketTcp>(http.LocalAddress());
+
+  // the file body is sent in order with the responses around it
+  static char const requests[] =
+      "GET /file HTTP/1.1\r\n\r\n"
+      "HEAD /file HTTP/1.1\r\n\r\n"
+      "GET /health HTTP/1.1\r\n\r\n";
+  std::ifstream content(filePath, std::ios::binary);
+  auto const expected =
+      file.wire +
+      std::string(std::istreambuf_iterator<char>(content), {}) +
+      file.wire +
+      health.wire;
+  (void)client.Send(requests, sizeof(requests) - 1U);
+
+  bool closed;
+  auto received = ReceiveResponses(client, expected.size(), false, closed);
+  success &= check("server should send the file as body of its response",
+      received == expected);
+  success &= check("server should keep the connection open",
+      !closed && (http.ConnectionCount() == 1U));
+
+  return success;
+}
+
+} // unnamed namespace
+
+int main(int, char **argv)
+{
+  bool success = true;
+
+  Driver driver;
+  auto thread = std::thread(&Driver::Run, &driver);
+
+  std::cout << "test case #1: keep-alive and pipelining" << std::endl;
+  success &= TestPipelined(driver);
+
+  std::cout << "test case #2: connection close" << std::endl;
+  success &= TestConnectionClose(driver);
+
+  std::cout << "test case #3: rejected requests" << std::endl;
+  success &= TestRejected(driver);
+
+  std::cout << "test case #4: idle timeout" << std::endl;
+  success &= TestIdleTimeout(driver);
+
+  std::cout << "test case #5: file response" << std::endl;
+  success &= TestFile(driver, argv[0]);
+
+  if(thread.joinable()) {
+    driver.Stop();
+    thread.join();
+  }
+
+  return (success ? EXIT_SUCCESS : EXIT_FAILURE);
+}
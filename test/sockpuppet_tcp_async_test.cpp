@@ -5,6 +5,7 @@
 #include <iostream> // for std::cout
 #include <map> // for std::map
 #include <mutex> // for std::mutex
+#include <string_view> // for std::string_view
 #include <thread> // for std::thread
 
 using namespace sockpuppet;
@@ -14,6 +15,11 @@ namespace {
 size_t const clientCount = 3U;
 size_t const clientSendCount = 5U;
 size_t const clientSendSize = 1000U;
+#ifdef TEST_TLS
+size_t const clientFileSendSize = 0U; // not supported with TLS
+#else
+size_t const clientFileSendSize = 1000U;
+#endif // TEST_TLS
 
 std::promise<void> promisedClientsConnect;
 std::promise<void> promisedClientsDisconnect;
@@ -29,6 +35,7 @@ struct Server
   size_t bytesReceived;
   std::map<Address, SocketTcpAsync> serverHandlers;
   std::mutex mtx;
+  char arena[1500U]; // as a decoder receiving in place would provide
 
   Server(Address bindAddress,
          Driver &driver)
@@ -61,17 +68,62 @@ struct Server
     bytesReceived += ptr->size();
   }
 
+  size_t HandleReceiveView(std::string_view view)
+  {
+    // consume whole records only to have the remainder passed again
+    constexpr size_t recordSize = 100U;
+    static_assert(clientSendSize % recordSize == 0U);
+    auto consumed = view.size() - view.size() % recordSize;
+    std::lock_guard<std::mutex> lock(mtx);
+    bytesReceived += consumed;
+    return consumed;
+  }
+
+  std::pair<char *, size_t> ProvideReceive()
+  {
+    return {arena, sizeof(arena)};
+  }
+
+  void HandleReceiveInto(size_t size)
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    bytesReceived += size;
+  }
+
   void HandleConnect(SocketTcp clientSock, Address clientAddr)
   {
     std::lock_guard<std::mutex> lock(mtx);
 
-    (void)serverHandlers.emplace(
-          std::make_pair(
-            std::move(clientAddr),
-            SocketTcpAsync({std::move(clientSock), 1U},
-                           driver,
-                           std::bind(&Server::HandleReceive, this, std::placeholders::_1),
-                           std::bind(&Server::HandleDisconnect, this, std::placeholders::_1))));
+    if(serverHandlers.size() % 3U == 0U) {
+      (void)serverHandlers.emplace(
+            std::make_pair(
+              std::move(clientAddr),
+              SocketTcpAsync({std::move(clientSock), 1U},
+                             driver,
+                             std::bind(&Server::HandleReceive, this, std::placeholders::_1),
+                             std::bind(&Server::HandleDisconnect, this, std::placeholders::_1))));
+    } else if(serverHandlers.size() % 3U == 1U) {
+      // another connection receives into a ring instead of pool buffers
+      SocketTcpBuffered buff(std::move(clientSock));
+      buff.EnableReceiveRing(1500U);
+      (void)serverHandlers.emplace(
+            std::make_pair(
+              std::move(clientAddr),
+              SocketTcpAsync(std::move(buff),
+                             driver,
+                             std::bind(&Server::HandleReceiveView, this, std::placeholders::_1),
+                             std::bind(&Server::HandleDisconnect, this, std::placeholders::_1))));
+    } else {
+      // or into memory provided by the handler
+      (void)serverHandlers.emplace(
+            std::make_pair(
+              std::move(clientAddr),
+              SocketTcpAsync({std::move(clientSock)},
+                             driver,
+                             std::bind(&Server::ProvideReceive, this),
+                             std::bind(&Server::HandleReceiveInto, this, std::placeholders::_1),
+                             std::bind(&Server::HandleDisconnect, this, std::placeholders::_1))));
+    }
 
     if((bytesReceived > 0U) && (serverHandlers.size() == 1U)) {
       promisedLoneClientConnect.set_value();
@@ -124,7 +176,7 @@ bool check(char const *message, bool success)
 
 } // unnamed namespace
 
-int main(int, char **)
+int main(int, char **argv)
 {
   using namespace std::chrono;
 
@@ -147,11 +199,16 @@ int main(int, char **)
             << std::endl;
 
   {
-    BufferPool clientSendPool(clientCount * clientSendCount, clientSendSize);
+    BufferPool clientSendPool(clientCount * clientSendCount + 1U, clientSendSize);
     std::unique_ptr<SocketTcpAsync> clients[clientCount];
 
+    // sent by all clients without copying
+    auto message = clientSendPool.Get();
+    message->assign(clientSendSize, 'b');
+    SharedBufferPtr broadcast = std::move(message);
+
     std::vector<std::future<void>> futures;
-    futures.reserve(clientCount * clientSendCount);
+    futures.reserve(clientCount * (clientSendCount + 1U));
     for(auto &&client : clients)
     {
       client.reset(new SocketTcpAsync(
@@ -163,12 +220,28 @@ int main(int, char **)
       std::cout << "client " << to_string(client->LocalAddress())
                 << " connected and sending to server" << std::endl;
 
+#if defined(__linux__) && !defined(TEST_TLS)
+      if(&client == &clients[0]) {
+        // sends complete only after the OS has released the buffers
+        client->EnableZeroCopy();
+      }
+#endif // __linux__ && !TEST_TLS
+
       for(size_t i = 0U; i < clientSendCount; ++i) {
         auto buffer = clientSendPool.Get();
         buffer->assign(clientSendSize, 'a');
         futures.push_back(
               client->Send(std::move(buffer)));
       }
+
+      futures.push_back(
+            client->Send(broadcast));
+
+      if((clientFileSendSize > 0U) && (&client == &clients[1])) {
+        // a region of the test executable is sent in order with the buffers
+        futures.push_back(
+              client->SendFile(argv[0], 0U, clientFileSendSize));
+      }
     }
 
     success &= check("wait for all clients to be connected",
@@ -182,6 +255,21 @@ int main(int, char **)
 
     success &= check("all clients should still be connected before leaving the scope",
         server->ClientCount() == clientCount);
+
+    success &= check("send queues should be drained",
+        clients[0]->SendQueueSize() == 0U);
+
+    success &= check("shared buffer should be released by all send queues",
+        broadcast.use_count() == 1);
+
+#ifdef __linux__
+    auto info = clients[0]->Info();
+    std::cout << "client transport: rtt " << info.rtt.count()
+              << "us, congestion window " << info.congestionWindow
+              << " bytes" << std::endl;
+    success &= check("transport info should be available",
+        info.congestionWindow > 0U);
+#endif // __linux__
   }
 
   success &= check("wait for all clients to disconnect",
@@ -190,8 +278,9 @@ int main(int, char **)
   success &= check("all data should be received",
       server->BytesReceived() ==
           clientCount
-          * clientSendCount
-          * clientSendSize);
+          * (clientSendCount + 1U)
+          * clientSendSize
+          + clientFileSendSize);
 
   // try the disconnect the other way around
   loneClient.reset(new SocketTcpAsync(
@@ -5,6 +5,8 @@
 #include <atomic> // for std::atomic
 #include <iostream> // for std::cout
 #include <stdexcept> // for std::exception
+#include <string> // for std::string
+#include <string_view> // for std::string_view
 #include <thread> // for std::thread
 
 using namespace sockpuppet;
@@ -14,9 +16,45 @@ constexpr size_t testDataSize = 100U * 1024 * 1024;
 static TestData const testData(testDataSize);
 static std::atomic<bool> success(true);
 
-void ServerHandler(std::pair<SocketTcp, Address> p)
+void ServerRingHandler(SocketTcpBuffered clientSock)
 {
-  SocketTcpBuffered clientSock(std::move(p.first), 0U, 1500U);
+  // small enough to have data wrap around the end of the ring
+  clientSock.EnableReceiveRing(4096U);
+
+  std::string received;
+  received.reserve(testDataSize);
+
+  // receive until disconnect
+  std::string_view unconsumed;
+  try {
+    for(;;) {
+      auto view = clientSock.ReceiveView().value();
+
+      // consume in fixed-size records only, as if parsing a framed protocol
+      constexpr size_t recordSize = 1000U;
+      auto consumed = view.size() - view.size() % recordSize;
+      received.append(view.data(), consumed);
+      clientSock.Consume(consumed);
+      unconsumed = view.substr(consumed);
+    }
+  } catch(std::exception const &) {
+  }
+  received.append(unconsumed);
+
+  if(received != testData.referenceData) {
+    std::cerr << "ring received data does not match reference data" << std::endl;
+    success = false;
+  }
+}
+
+void ServerHandler(std::pair<SocketTcp, Address> p, bool ring, ReceiveSizing sizing)
+{
+  if(ring) {
+    ServerRingHandler(SocketTcpBuffered(std::move(p.first)));
+    return;
+  }
+
+  SocketTcpBuffered clientSock(std::move(p.first), 0U, 1500U, sizing);
 
   std::vector<BufferPtr> storage;
   storage.reserve(testDataSize / TestData::tcpPacketSizeMin);
@@ -39,13 +77,13 @@ void ServerHandler(std::pair<SocketTcp, Address> p)
   }
 }
 
-void Server(Acceptor serverSock)
+void Server(Acceptor serverSock, bool ring, ReceiveSizing sizing)
 try {
   std::cout << "server listening at "
             << to_string(serverSock.LocalAddress())
             << std::endl;
 
-  ServerHandler(serverSock.Listen().value());
+  ServerHandler(serverSock.Listen().value(), ring, sizing);
 } catch (std::exception const &e) {
   std::cerr << e.what() << std::endl;
   success = false;
@@ -67,13 +105,14 @@ try {
   success = false;
 }
 
-void Test(Duration perPacketSendTimeout)
+void Test(Duration perPacketSendTimeout, bool ring = false,
+          ReceiveSizing sizing = ReceiveSizing::Fixed)
 {
   auto serverSock = MakeTestSocket<Acceptor>(Address());
   auto serverAddr = serverSock.LocalAddress();
 
   // start client and server threads
-  std::thread server(Server, std::move(serverSock));
+  std::thread server(Server, std::move(serverSock), ring, sizing);
 
   // wait for server to come up
   std::this_thread::sleep_for(1s);
@@ -100,5 +139,11 @@ int main(int, char **)
   std::cout << "test case #3: non-blocking send" << std::endl;
   Test(Duration(0));
 
+  std::cout << "test case #4: receive into ring" << std::endl;
+  Test(Duration(-1), true);
+
+  std::cout << "test case #5: adaptive receive sizing" << std::endl;
+  Test(Duration(-1), false, ReceiveSizing::Adaptive);
+
   return (success ? EXIT_SUCCESS : EXIT_FAILURE);
 }
@@ -0,0 +1,234 @@
+#include "sockpuppet_test_common.h" // for MakeTestSocket
+
+#include "sockpuppet/socket_async.h" // for ConnectorAsync
+
+#include <atomic> // for std::atomic
+#include <cstdlib> // for EXIT_SUCCESS
+#include <iostream> // for std::cout
+#include <memory> // for std::unique_ptr
+#include <mutex> // for std::mutex
+#include <thread> // for std::thread
+#include <vector> // for std::vector
+
+using namespace sockpuppet;
+using namespace std::chrono;
+
+namespace {
+
+size_t const clientCount = 3U;
+
+std::promise<void> promisedClientsConnect;
+std::promise<void> promisedServerReceive;
+std::promise<void> promisedConnectError;
+std::atomic<bool> unexpected(false);
+
+struct Server
+{
+  AcceptorAsync sock;
+  Driver &driver;
+  std::vector<SocketTcpAsync> serverHandlers;
+  std::mutex mtx;
+
+  Server(Address bindAddress,
+         Driver &driver)
+    : sock(MakeTestSocket<Acceptor>(bindAddress),
+           driver,
+           std::bind(&Server::HandleConnect,
+                     this,
+                     std::placeholders::_1,
+                     std::placeholders::_2))
+    , driver(driver)
+  {
+  }
+
+  void HandleConnect(SocketTcp clientSock, Address)
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+
+    serverHandlers.emplace_back(
+          SocketTcpBuffered(std::move(clientSock), 1U),
+          driver,
+          std::bind(&Server::HandleReceive, this, std::placeholders::_1),
+          [](Address, char const *) {});
+  }
+
+  void HandleReceive(BufferPtr)
+  {
+    promisedServerReceive.set_value();
+  }
+};
+
+struct Clients
+{
+  Driver &driver;
+  std::vector<ConnectorAsync> connectors;
+  std::vector<SocketTcpAsync> clients;
+  std::mutex mtx;
+
+  Clients(Address connectAddress,
+          Driver &driver)
+    : driver(driver)
+  {
+    // start all connects at once; none of these calls blocks
+    connectors.reserve(clientCount);
+    for(size_t i = 0U; i < clientCount; ++i) {
+      connectors.emplace_back(
+            MakeTestSocket<ConnectorAsync>(
+              connectAddress,
+              driver,
+              std::bind(&Clients::HandleConnect,
+                        this,
+                        std::placeholders::_1,
+                        std::placeholders::_2),
+              std::bind(&Clients::HandleError,
+                        this,
+                        std::placeholders::_1,
+                        std::placeholders::_2),
+              seconds(1)));
+    }
+  }
+
+  size_t ClientCount()
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    return clients.size();
+  }
+
+  void HandleConnect(SocketTcp sock, Address)
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+
+    clients.emplace_back(
+          SocketTcpBuffered(std::move(sock)),
+          driver,
+          [](BufferPtr) {},
+          [](Address, char const *) {});
+
+    if(clients.size() == clientCount) {
+      promisedClientsConnect.set_value();
+    }
+  }
+
+  void HandleError(Address, char const *reason)
+  {
+    std::cerr << reason << std::endl;
+  }
+};
+
+void HandleConnectUnexpected(SocketTcp, Address)
+{
+  std::cerr << "unexpected connect" << std::endl;
+  unexpected = true;
+}
+
+void HandleConnectError(Address addr, char const *reason)
+{
+  std::cout << "connect to " << to_string(addr)
+            << " failed (" << reason << ")" << std::endl;
+
+  promisedConnectError.set_value();
+}
+
+void HandleConnectErrorUnexpected(Address, char const *reason)
+{
+  std::cerr << "unexpected connect error (" << reason << ")" << std::endl;
+  unexpected = true;
+}
+
+bool check(char const *message, bool success)
+{
+  std::cout << message << " - " << (success ? "ok" : "fail") << std::endl;
+  return success;
+}
+
+} // unnamed namespace
+
+int main(int, char **)
+{
+  bool success = true;
+
+  auto futureClientsConnect = promisedClientsConnect.get_future();
+  auto futureServerReceive = promisedServerReceive.get_future();
+  auto futureConnectError = promisedConnectError.get_future();
+
+  Driver driver;
+  auto thread = std::thread(&Driver::Run, &driver);
+
+  auto server = std::make_unique<Server>(Address(), driver);
+  auto serverAddr = server->sock.LocalAddress();
+
+  std::cout << "server listening at "
+            << to_string(serverAddr)
+            << std::endl;
+
+  {
+    Clients clients(serverAddr, driver);
+
+    success &= check("wait for all clients to be connected",
+        futureClientsConnect.wait_for(seconds(1)) == std::future_status::ready);
+
+    if(clients.ClientCount() > 0U) {
+      static char const hello[] = "hello";
+      (void)clients.clients.front().Send(
+            TestData::ToBufferPtr(hello, sizeof(hello)));
+
+      success &= check("wait for server to receive from connected client",
+          futureServerReceive.wait_for(seconds(1)) == std::future_status::ready);
+    }
+  }
+
+  {
+    // resolve by host name, possibly racing IPv6 and IPv4 candidates
+    std::promise<void> promisedConnect;
+    auto futureConnect = promisedConnect.get_future();
+
+    ConnectorAsync byName(
+          Address("localhost", std::to_string(serverAddr.Port())),
+          driver,
+          [&](SocketTcp, Address) { promisedConnect.set_value(); },
+          HandleConnectErrorUnexpected,
+          seconds(1));
+
+    success &= check("wait for connect by host name",
+        futureConnect.wait_for(seconds(2)) == std::future_status::ready);
+  }
+
+  {
+    // a bound but not listening socket refuses connections
+    Acceptor notListening(Address{});
+
+    ConnectorAsync refused(
+          notListening.LocalAddress(),
+          driver,
+          HandleConnectUnexpected,
+          HandleConnectError,
+          seconds(1));
+
+    success &= check("wait for connect error",
+        futureConnectError.wait_for(seconds(2)) == std::future_status::ready);
+  }
+
+  {
+    // destroying a connector cancels its pending connect and timeout
+    Driver stepped;
+    {
+      ConnectorAsync cancelled(
+            serverAddr,
+            stepped,
+            HandleConnectUnexpected,
+            HandleConnectErrorUnexpected,
+            milliseconds(1));
+    }
+    stepped.Step(milliseconds(10));
+
+    success &= check("cancelled connect should not report",
+        !unexpected);
+  }
+
+  if(thread.joinable()) {
+    driver.Stop();
+    thread.join();
+  }
+
+  return (success ? EXIT_SUCCESS : EXIT_FAILURE);
+}
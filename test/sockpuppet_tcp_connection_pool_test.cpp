@@ -0,0 +1,229 @@
+#include "sockpuppet_test_common.h" // for MakeTestSocket
+
+#include "sockpuppet/socket_async.h" // for ConnectionPool
+
+#include <atomic> // for std::atomic
+#include <cstdlib> // for EXIT_SUCCESS
+#include <iostream> // for std::cout
+#include <memory> // for std::unique_ptr
+#include <mutex> // for std::mutex
+#include <optional> // for std::optional
+#include <thread> // for std::thread
+#include <vector> // for std::vector
+
+using namespace sockpuppet;
+using namespace std::chrono;
+
+namespace {
+
+static char const hello[] = "hello";
+
+struct Server
+{
+  AcceptorAsync sock;
+  Driver &driver;
+  std::vector<SocketTcpAsync> serverHandlers;
+  std::atomic<size_t> connectCount;
+  std::atomic<size_t> disconnectCount;
+  std::mutex mtx;
+
+  Server(Address bindAddress,
+         Driver &driver)
+    : sock(MakeTestSocket<Acceptor>(bindAddress),
+           driver,
+           std::bind(&Server::HandleConnect,
+                     this,
+                     std::placeholders::_1,
+                     std::placeholders::_2))
+    , driver(driver)
+    , connectCount(0U)
+    , disconnectCount(0U)
+  {
+  }
+
+  void HandleConnect(SocketTcp clientSock, Address)
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+
+    serverHandlers.emplace_back(
+          SocketTcpBuffered(std::move(clientSock), 1U),
+          driver,
+          std::bind(&Server::HandleReceive, this, std::placeholders::_1),
+          [this](Address, char const *) { ++disconnectCount; });
+    ++connectCount;
+  }
+
+  void HandleReceive(BufferPtr buffer)
+  {
+    // echo back on the most recent connection, which is the only one in use
+    std::lock_guard<std::mutex> lock(mtx);
+    (void)serverHandlers.back().Send(std::move(buffer));
+  }
+
+  void Push()
+  {
+    // send without having been asked on the most recent connection
+    std::lock_guard<std::mutex> lock(mtx);
+    (void)serverHandlers.back().Send(TestData::ToBufferPtr(hello, sizeof(hello)));
+  }
+
+  void CloseAll()
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+    serverHandlers.clear();
+  }
+};
+
+// request/response exchange on a leased connection
+struct Exchange
+{
+  std::optional<SocketTcpLease> lease;
+  std::promise<void> promisedResponse;
+
+  void Acquire(ConnectionPool &pool, Address const &serverAddr)
+  {
+    pool.Acquire(serverAddr,
+        std::bind(&Exchange::HandleReceive, this, std::placeholders::_1),
+        [](Address, char const *reason) {
+          std::cerr << "unexpected disconnect (" << reason << ")" << std::endl;
+        },
+        std::bind(&Exchange::HandleLease, this, std::placeholders::_1),
+        [](Address, char const *reason) {
+          std::cerr << "unexpected connect error (" << reason << ")" << std::endl;
+        });
+  }
+
+  void HandleLease(SocketTcpLease l)
+  {
+    lease.emplace(std::move(l));
+    (void)lease->Send(TestData::ToBufferPtr(hello, sizeof(hello)));
+  }
+
+  void HandleReceive(BufferPtr)
+  {
+    // response complete; return the connection to the pool
+    lease.reset();
+    promisedResponse.set_value();
+  }
+};
+
+bool check(char const *message, bool success)
+{
+  std::cout << message << " - " << (success ? "ok" : "fail") << std::endl;
+  return success;
+}
+
+} // unnamed namespace
+
+int main(int, char **)
+{
+  bool success = true;
+
+  Driver driver;
+  auto thread = std::thread(&Driver::Run, &driver);
+
+  Server server(Address(), driver);
+  auto serverAddr = server.sock.LocalAddress();
+
+  std::cout << "server listening at "
+            << to_string(serverAddr)
+            << std::endl;
+
+  {
+    auto pool = MakeTestSocket<ConnectionPool>(
+          driver,
+          1U, // connections per host
+          milliseconds(200), // idle timeout
+          seconds(1)); // connect timeout
+
+    {
+      // the second exchange waits for the first to release the connection
+      Exchange first;
+      Exchange second;
+      auto futureFirst = first.promisedResponse.get_future();
+      auto futureSecond = second.promisedResponse.get_future();
+      first.Acquire(pool, serverAddr);
+      second.Acquire(pool, serverAddr);
+
+      success &= check("wait for exchanges on shared connection",
+          futureFirst.wait_for(seconds(2)) == std::future_status::ready &&
+          futureSecond.wait_for(seconds(2)) == std::future_status::ready);
+      success &= check("connection should have been reused",
+          server.connectCount == 1U);
+    }
+
+    {
+      auto const deadline = steady_clock::now() + seconds(2);
+      while((server.disconnectCount < 1U) && (steady_clock::now() < deadline)) {
+        std::this_thread::sleep_for(milliseconds(10));
+      }
+      success &= check("idle connection should have been evicted",
+          server.disconnectCount == 1U);
+    }
+
+    {
+      Exchange reconnect;
+      auto future = reconnect.promisedResponse.get_future();
+      reconnect.Acquire(pool, serverAddr);
+
+      success &= check("wait for exchange on new connection",
+          future.wait_for(seconds(2)) == std::future_status::ready);
+    }
+
+    {
+      // the pool notices the server closing the idle connection
+      server.CloseAll();
+      std::this_thread::sleep_for(milliseconds(100));
+
+      Exchange afterClose;
+      auto future = afterClose.promisedResponse.get_future();
+      afterClose.Acquire(pool, serverAddr);
+
+      success &= check("wait for exchange after peer closed idle connection",
+          future.wait_for(seconds(2)) == std::future_status::ready);
+      success &= check("closed connection should not have been reused",
+          server.connectCount == 3U);
+    }
+
+    {
+      // the pool drops an idle connection the peer sends to unasked
+      server.Push();
+      std::this_thread::sleep_for(milliseconds(100));
+
+      Exchange afterPush;
+      auto future = afterPush.promisedResponse.get_future();
+      afterPush.Acquire(pool, serverAddr);
+
+      success &= check("wait for exchange after unsolicited receipt",
+          future.wait_for(seconds(2)) == std::future_status::ready);
+      success &= check("connection receiving unasked should not have been reused",
+          server.connectCount == 4U);
+    }
+
+    {
+      // a bound but not listening socket refuses connections
+      Acceptor notListening(Address{});
+      std::promise<void> promisedError;
+      auto futureError = promisedError.get_future();
+
+      pool.Acquire(notListening.LocalAddress(),
+          [](BufferPtr) {},
+          [](Address, char const *) {},
+          [](SocketTcpLease) { std::cerr << "unexpected lease" << std::endl; },
+          [&](Address, char const *reason) {
+            std::cout << "connect failed (" << reason << ")" << std::endl;
+            promisedError.set_value();
+          });
+
+      success &= check("wait for connect error",
+          futureError.wait_for(seconds(2)) == std::future_status::ready);
+    }
+  }
+
+  if(thread.joinable()) {
+    driver.Stop();
+    thread.join();
+  }
+
+  return (success ? EXIT_SUCCESS : EXIT_FAILURE);
+}
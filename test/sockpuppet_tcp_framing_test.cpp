@@ -0,0 +1,210 @@
+#include "sockpuppet_test_common.h" // for MakeTestSocket
+
+#include "sockpuppet/socket_async.h" // for Framing
+
+#include <algorithm> // for std::replace
+#include <cstdlib> // for EXIT_SUCCESS
+#include <future> // for std::promise
+#include <iostream> // for std::cout
+#include <mutex> // for std::mutex
+#include <optional> // for std::optional
+#include <string> // for std::string
+#include <thread> // for std::thread
+#include <vector> // for std::vector
+
+using namespace sockpuppet;
+using namespace std::chrono;
+
+namespace {
+
+size_t const messageCount = 500U;
+size_t const maxMessageSize = 1000U;
+
+struct Server
+{
+  AcceptorAsync sock;
+  Driver &driver;
+  Framing framing;
+  std::optional<SocketTcpAsync> connection;
+  std::vector<std::string> messages;
+  std::promise<std::string> promisedDisconnect;
+  std::mutex mtx;
+
+  Server(Driver &driver, Framing framing)
+    : sock(MakeTestSocket<Acceptor>(Address()),
+           driver,
+           std::bind(&Server::HandleConnect,
+                     this,
+                     std::placeholders::_1,
+                     std::placeholders::_2))
+    , driver(driver)
+    , framing(std::move(framing))
+  {
+  }
+
+  void HandleConnect(SocketTcp clientSock, Address)
+  {
+    std::lock_guard<std::mutex> lock(mtx);
+
+    // the ring fits a message of maximum size along with its framing
+    SocketTcpBuffered buffered(std::move(clientSock));
+    buffered.EnableReceiveRing(2U * maxMessageSize);
+
+    connection.emplace(
+          std::move(buffered),
+          driver,
+          framing.Receiver(
+            std::bind(&Server::HandleMessage, this, std::placeholders::_1)),
+          [this](Address, char const *reason) {
+            promisedDisconnect.set_value(reason);
+          });
+  }
+
+  void HandleMessage(std::string_view message)
+  {
+    messages.emplace_back(message);
+  }
+};
+
+std::vector<std::string> MakeMessages(char delimiter)
+{
+  std::vector<std::string> messages;
+  TestData test(messageCount * maxMessageSize);
+  std::string_view data = test.referenceData;
+  for(size_t i = 0U; i < messageCount; ++i) {
+    // include empty and maximum size messages
+    auto size = (i * 37U) % (maxMessageSize + 1U);
+    auto &&message = messages.emplace_back(data.substr(0U, size));
+    data.remove_prefix(size);
+
+    if(delimiter) {
+      std::replace(message.begin(), message.end(), delimiter, ' ');
+    }
+  }
+  return messages;
+}
+
+bool check(char const *message, bool success)
+{
+  std::cout << message << " - " << (success ? "ok" : "fail") << std::endl;
+  return success;
+}
+
+bool TestLengthPrefixed(Driver &driver)
+{
+  bool success = true;
+
+  auto framing = Framing::LengthPrefixed(2U, true, maxMessageSize);
+  auto messages = MakeMessages('\0');
+
+  Server server(driver, framing);
+  auto futureDisconnect = server.promisedDisconnect.get_future();
+  {
+    BufferPool pool; // outlives the client holding its buffers
+    SocketTcpAsync client(
+          SocketTcpBuffered(MakeTestSocket<SocketTcp>(server.sock.LocalAddress())),
+          driver,
+          [](BufferPtr) {},
+          [](Address, char const *) {});
+
+    std::future<void> lastSent;
+    for(auto &&message : messages) {
+      auto header = pool.Get();
+      framing.AppendHeader(*header, message.size());
+      auto payload = pool.Get();
+      payload->assign(message);
+      lastSent = client.Send(std::move(header), std::move(payload));
+    }
+    success &= check("wait for messages to be sent",
+        lastSent.wait_for(seconds(2)) == std::future_status::ready);
+  }
+
+  success &= check("wait for disconnect",
+      futureDisconnect.wait_for(seconds(2)) == std::future_status::ready);
+  success &= check("server should receive all length-prefixed messages",
+      server.messages == messages);
+
+  return success;
+}
+
+bool TestDelimited(Driver &driver)
+{
+  bool success = true;
+
+  auto framing = Framing::Delimited("\r\n", maxMessageSize);
+  auto messages = MakeMessages('\n');
+
+  Server server(driver, framing);
+  auto futureDisconnect = server.promisedDisconnect.get_future();
+  {
+    std::string stream;
+    for(auto &&message : messages) {
+      stream += message;
+      framing.AppendTrailer(stream);
+    }
+
+    // messages and delimiters are split across receipts
+    auto client = MakeTestSocket<SocketTcp>(server.sock.LocalAddress());
+    std::string_view remaining = stream;
+    for(size_t i = 0U; !remaining.empty(); ++i) {
+      auto chunk = remaining.substr(0U, (i % 2U) ? 1U : 1777U);
+      (void)client.Send(chunk.data(), chunk.size());
+      remaining.remove_prefix(chunk.size());
+      if(i % 100U == 0U) {
+        std::this_thread::sleep_for(milliseconds(1));
+      }
+    }
+  }
+
+  success &= check("wait for disconnect",
+      futureDisconnect.wait_for(seconds(2)) == std::future_status::ready);
+  success &= check("server should receive all delimited messages",
+      server.messages == messages);
+
+  return success;
+}
+
+bool TestTooLarge(Driver &driver)
+{
+  bool success = true;
+
+  Server server(driver, Framing::LengthPrefixed(2U, true, maxMessageSize));
+  auto futureDisconnect = server.promisedDisconnect.get_future();
+
+  auto client = MakeTestSocket<SocketTcp>(server.sock.LocalAddress());
+  static char const header[] = {'\x0F', '\xFF'};
+  (void)client.Send(header, sizeof(header));
+
+  success &= check("server should disconnect on a message exceeding the maximum size",
+      futureDisconnect.wait_for(seconds(2)) == std::future_status::ready);
+  success &= check("server should not receive the message",
+      server.messages.empty());
+
+  return success;
+}
+
+} // unnamed namespace
+
+int main(int, char **)
+{
+  bool success = true;
+
+  Driver driver;
+  auto thread = std::thread(&Driver::Run, &driver);
+
+  std::cout << "test case #1: length-prefixed messages" << std::endl;
+  success &= TestLengthPrefixed(driver);
+
+  std::cout << "test case #2: delimited messages" << std::endl;
+  success &= TestDelimited(driver);
+
+  std::cout << "test case #3: message too large" << std::endl;
+  success &= TestTooLarge(driver);
+
+  if(thread.joinable()) {
+    driver.Stop();
+    thread.join();
+  }
+
+  return (success ? EXIT_SUCCESS : EXIT_FAILURE);
+}
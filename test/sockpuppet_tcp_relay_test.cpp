@@ -0,0 +1,142 @@
+#include "sockpuppet_test_common.h" // for MakeTestSocket
+
+#include "sockpuppet/socket_async.h" // for RelayAsync
+
+#include <cstdlib> // for EXIT_SUCCESS
+#include <future> // for std::async
+#include <iostream> // for std::cout
+#include <optional> // for std::optional
+#include <stdexcept> // for std::logic_error
+#include <string> // for std::string
+#include <thread> // for std::thread
+
+using namespace sockpuppet;
+using namespace std::chrono;
+
+namespace {
+
+// exceeds what the OS buffers on the way from client to server
+size_t const referenceSize = 32U * 1024U * 1024U;
+
+bool check(char const *message, bool success)
+{
+  std::cout << message << " - " << (success ? "ok" : "fail") << std::endl;
+  return success;
+}
+
+} // unnamed namespace
+
+int main(int, char **)
+{
+  bool success = true;
+
+  Driver driver;
+  auto thread = std::thread(&Driver::Run, &driver);
+
+  // client <-> front | relay | back <-> server
+  auto frontAcceptor = MakeTestSocket<Acceptor>(Address());
+  auto backAcceptor = MakeTestSocket<Acceptor>(Address());
+  auto futureFront = std::async(std::launch::async, [&]() -> SocketTcp {
+    return frontAcceptor.Listen(seconds(2)).value().first;
+  });
+  auto futureServer = std::async(std::launch::async, [&]() -> SocketTcp {
+    return backAcceptor.Listen(seconds(2)).value().first;
+  });
+
+  // wait for acceptors to listen
+  std::this_thread::sleep_for(milliseconds(100));
+
+  std::optional<SocketTcp> client(
+        MakeTestSocket<SocketTcp>(frontAcceptor.LocalAddress()));
+  auto back = MakeTestSocket<SocketTcp>(backAcceptor.LocalAddress());
+  auto front = futureFront.get();
+  std::optional<SocketTcp> server(futureServer.get());
+
+#ifdef TEST_TLS
+  try {
+    RelayAsync relay(std::move(front), std::move(back), driver,
+                     [](Address, char const *) {});
+    success &= check("relay of TLS sockets should be rejected", false);
+  } catch(std::logic_error const &e) {
+    std::cout << e.what() << std::endl;
+  }
+#else
+  std::promise<void> promisedEnd;
+  auto futureEnd = promisedEnd.get_future();
+
+  RelayAsync relay(std::move(front), std::move(back), driver,
+      [&](Address addr, char const *reason) {
+        std::cout << "relay ended by " << to_string(addr)
+                  << " (" << reason << ")" << std::endl;
+        promisedEnd.set_value();
+      });
+
+  {
+    TestData test(referenceSize);
+    auto &&reference = test.referenceData;
+
+    auto sender = std::thread([&]() {
+      (void)client->Send(reference.data(), reference.size());
+    });
+
+    // nobody receives at the server yet
+    std::this_thread::sleep_for(milliseconds(200));
+    success &= check("relay should hold back data the server does not take",
+        relay.ForwardedToSecond() < referenceSize);
+
+    std::string received;
+    received.reserve(referenceSize);
+    std::string buffer(65536U, '\0');
+    while(received.size() < referenceSize) {
+      auto rx = server->Receive(buffer.data(), buffer.size(), seconds(2));
+      if(!rx) {
+        break;
+      }
+      received.append(buffer.data(), *rx);
+    }
+    if(sender.joinable()) {
+      sender.join();
+    }
+
+    success &= check("server should receive all data relayed in order",
+        received == reference);
+  }
+
+  {
+    static char const pong[] = "pong";
+    (void)server->Send(pong, sizeof(pong));
+
+    char buffer[16];
+    auto rx = client->Receive(buffer, sizeof(buffer), seconds(1));
+    success &= check("client should receive the relayed response",
+        rx && (std::string(buffer, *rx) == std::string(pong, sizeof(pong))));
+  }
+
+  {
+    // the client's end of stream is passed on as half-close
+    client.reset();
+
+    char buffer[16];
+    try {
+      (void)server->Receive(buffer, sizeof(buffer), seconds(1));
+      success &= check("server should see the connection closed", false);
+    } catch(std::exception const &e) {
+      std::cout << e.what() << std::endl;
+    }
+    server.reset();
+
+    success &= check("wait for relay to end",
+        futureEnd.wait_for(seconds(1)) == std::future_status::ready);
+    success &= check("relay should count all forwarded data",
+        (relay.ForwardedToSecond() == referenceSize) &&
+        (relay.ForwardedToFirst() == sizeof("pong")));
+  }
+#endif // TEST_TLS
+
+  if(thread.joinable()) {
+    driver.Stop();
+    thread.join();
+  }
+
+  return (success ? EXIT_SUCCESS : EXIT_FAILURE);
+}
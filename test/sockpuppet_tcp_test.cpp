@@ -4,7 +4,9 @@
 
 #include <atomic> // for std::atomic
 #include <cstdlib> // for EXIT_SUCCESS
+#include <fstream> // for std::ifstream
 #include <iostream> // for std::cerr
+#include <sstream> // for std::ostringstream
 #include <stdexcept> // for std::runtime_error
 #include <string_view> // for std::string_view
 #include <thread> // for std::thread
@@ -16,6 +18,88 @@ static int const clientCount = 3;
 
 static std::atomic<bool> success(true);
 
+#ifdef TEST_TLS
+std::string ReadFile(char const *path)
+{
+  std::ostringstream content;
+  content << std::ifstream(path).rdbuf();
+  return content.str();
+}
+
+// loaded once and shared by the server and every other client
+TlsContext const &SharedContext()
+{
+  static TlsContext const context = TlsContext::FromMemory(
+      ReadFile("test_cert.pem"), ReadFile("test_key.pem"));
+  return context;
+}
+
+// connects to a server with given session options twice in a row
+TlsSessionStats Reconnect(TlsSessionOptions const &serverOptions)
+{
+  TlsContext serverContext("test_cert.pem", "test_key.pem", serverOptions);
+  TlsContext clientContext("test_cert.pem", "test_key.pem");
+  Acceptor serverSock(Address(), serverContext);
+  (void)serverSock.Listen(Duration(0));
+
+  for(int i = 0; i < 2; ++i) {
+    SocketTcp clientSock(serverSock.LocalAddress(), clientContext);
+
+    // the handshake requires both sides to proceed concurrently
+    std::thread server([&serverSock]() {
+      static char const hello[] = "hello";
+      (void)serverSock.Listen(seconds(1)).value().first.Send(hello, sizeof(hello));
+    });
+    char buffer[256];
+    (void)clientSock.Receive(buffer, sizeof(buffer), seconds(1));
+    server.join();
+  }
+
+  auto const serverStats = serverContext.SessionStats();
+  auto const clientStats = clientContext.SessionStats();
+  if((serverStats.handshakes != clientStats.handshakes) ||
+     (serverStats.resumed != clientStats.resumed)) {
+    std::cerr << "client and server disagree on resumption" << std::endl;
+    success = false;
+  }
+  return clientStats;
+}
+
+void TestResumption()
+{
+  auto stats = Reconnect(TlsSessionOptions());
+  std::cout << "resumed " << stats.resumed << " of " << stats.handshakes
+            << " handshakes using tickets" << std::endl;
+  success = success && (stats.handshakes == 2U) && (stats.resumed == 1U);
+
+  TlsSessionOptions cacheOnly;
+  cacheOnly.tickets = false;
+  stats = Reconnect(cacheOnly);
+  std::cout << "resumed " << stats.resumed << " of " << stats.handshakes
+            << " handshakes using the server cache" << std::endl;
+  success = success && (stats.handshakes == 2U) && (stats.resumed == 1U);
+
+  TlsSessionOptions disabled;
+  disabled.tickets = false;
+  disabled.serverCacheSize = 0U;
+  stats = Reconnect(disabled);
+  std::cout << "resumed " << stats.resumed << " of " << stats.handshakes
+            << " handshakes with resumption disabled" << std::endl;
+  success = success && (stats.handshakes == 2U) && (stats.resumed == 0U);
+}
+#endif // TEST_TLS
+
+SocketTcp Connect(Address const &serverAddr, int index)
+{
+#ifdef TEST_TLS
+  if(index % 2) {
+    return SocketTcp(serverAddr, SharedContext());
+  }
+#endif // TEST_TLS
+  (void)index;
+  return MakeTestSocket<SocketTcp>(serverAddr);
+}
+
 void ServerHandler(std::pair<SocketTcp, Address> p)
 try {
   auto &&clientSock = p.first;
@@ -55,15 +139,36 @@ try {
   success = false;
 }
 
-void Client(Address serverAddr)
+void Client(Address serverAddr, int index)
 try {
-  auto clientSock = MakeTestSocket<SocketTcp>(serverAddr);
+  auto clientSock = Connect(serverAddr, index);
   auto clientAddr = clientSock.LocalAddress();
 
   std::cout << "client " << to_string(clientAddr)
             << " connected to server " << to_string(serverAddr)
             << std::endl;
 
+  clientSock.SetOptions(TcpOptions::LowLatency());
+
+  try {
+    // an unknown congestion control algorithm is rejected
+    TcpOptions unknown;
+    unknown.congestion = "unknown";
+    clientSock.SetOptions(unknown);
+    success = false;
+  } catch(std::exception const &e) {
+    std::cout << e.what() << std::endl;
+  }
+
+  try {
+    TcpOptions negative;
+    negative.userTimeout = Duration(-1);
+    clientSock.SetOptions(negative);
+    success = false;
+  } catch(std::exception const &e) {
+    std::cout << e.what() << std::endl;
+  }
+
   char buffer[256];
   constexpr Duration receiveTimeout = seconds(1);
   if(auto rx = clientSock.Receive(buffer, sizeof(buffer), receiveTimeout)) {
@@ -89,19 +194,56 @@ try {
   success = false;
 }
 
-int main(int, char **)
+#ifndef TEST_TLS
+// the OS raises SIGPIPE on file send to a closed connection unless suppressed
+void TestSendFileClosed(char const *filePath)
+{
+  Acceptor serverSock((Address()));
+  (void)serverSock.Listen(Duration(0));
+  SocketTcp clientSock(serverSock.LocalAddress());
+  (void)serverSock.Listen(seconds(1)).value(); // closed right away
+
+  try {
+    // sending succeeds until the reset of the peer has arrived
+    for(int i = 0; i < 100; ++i) {
+      (void)clientSock.SendFile(filePath);
+      std::this_thread::sleep_for(milliseconds(10));
+    }
+    std::cerr << "file send to closed peer did not fail" << std::endl;
+    success = false;
+  } catch(std::exception const &e) {
+    std::cout << e.what() << std::endl;
+  }
+}
+#endif // TEST_TLS
+
+int main(int, char **argv)
 {
+#ifdef TEST_TLS
+  try {
+    (void)TlsContext::FromMemory("invalid", "invalid");
+    success = false;
+  } catch(std::exception const &e) {
+    std::cout << e.what() << std::endl;
+  }
+
+  Acceptor serverSock(Address(), SharedContext());
+#else // TEST_TLS
   auto serverSock = MakeTestSocket<Acceptor>(Address());
+#endif // TEST_TLS
   auto serverAddr = serverSock.LocalAddress();
 
+  // accepted sockets inherit the options
+  serverSock.SetOptions(TcpOptions::LowLatency());
+
   std::thread server(Server, std::move(serverSock));
 
   // wait for server thread to come up
   std::this_thread::sleep_for(seconds(1));
 
   std::thread clients[clientCount];
-  for(auto &&client : clients) {
-    client = std::thread(Client, serverAddr);
+  for(int i = 0; i < clientCount; ++i) {
+    clients[i] = std::thread(Client, serverAddr, i);
   }
 
   if(server.joinable()) {
@@ -113,5 +255,12 @@ int main(int, char **)
     }
   }
 
+#ifdef TEST_TLS
+  TestResumption();
+  (void)argv;
+#else // TEST_TLS
+  TestSendFileClosed(argv[0]);
+#endif // TEST_TLS
+
   return (success ? EXIT_SUCCESS : EXIT_FAILURE);
 }
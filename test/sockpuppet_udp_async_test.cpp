@@ -1,11 +1,15 @@
 #include "sockpuppet/socket_async.h" // for SocketUdpAsync
 
 #include <iostream> // for std::cout
+#include <string> // for std::string
+#include <string_view> // for std::string_view
 #include <thread> // for std::this_thread
 
 using namespace sockpuppet;
 
 static auto promisedReceipt = std::make_unique<std::promise<void>>();
+static auto promisedReceiptInto = std::make_unique<std::promise<void>>();
+static char receiveArena[1500U];
 static size_t const clientSendCount = 5U;
 static size_t const clientSendSize = 100U;
 
@@ -20,6 +24,23 @@ void HandleReceiveFrom(BufferPtr, Address addr)
   }
 }
 
+std::pair<char *, size_t> ProvideReceive()
+{
+  return {receiveArena, sizeof(receiveArena)};
+}
+
+void HandleReceiveFromInto(size_t size, Address addr)
+{
+  std::cout << "received " << size << " bytes into memory provided from "
+            << to_string(addr) << std::endl;
+
+  if(promisedReceiptInto && (size == clientSendSize) &&
+     (std::string_view(receiveArena, size) == std::string(clientSendSize, 'a'))) {
+    promisedReceiptInto->set_value();
+    promisedReceiptInto.reset();
+  }
+}
+
 void ReceiveFromDummy(BufferPtr, Address)
 {
 }
@@ -46,8 +67,15 @@ int main(int, char **)
 
     auto futureReceipt = promisedReceipt->get_future();
 
+    auto intoSock = SocketUdpAsync(
+        {Address()},
+        driver,
+        ProvideReceive,
+        HandleReceiveFromInto);
+    auto futureReceiptInto = promisedReceiptInto->get_future();
+
     {
-      BufferPool sendPool(clientSendCount, clientSendSize);
+      BufferPool sendPool(clientSendCount + 1U, clientSendSize);
 
       auto clientSock = SocketUdpAsync(
           {Address()},
@@ -64,6 +92,9 @@ int main(int, char **)
         buffer->assign(clientSendSize, 'a');
         futuresSend.emplace_back(clientSock.SendTo(std::move(buffer), serverAddr));
       }
+      auto buffer = sendPool.Get();
+      buffer->assign(clientSendSize, 'a');
+      futuresSend.emplace_back(clientSock.SendTo(std::move(buffer), intoSock.LocalAddress()));
 
       auto deadline = steady_clock::now() + seconds(1);
       for(auto &&future : futuresSend) {
@@ -72,6 +103,7 @@ int main(int, char **)
     }
 
     success &= (futureReceipt.wait_for(seconds(1)) == std::future_status::ready);
+    success &= (futureReceiptInto.wait_for(seconds(1)) == std::future_status::ready);
   }
 
   if(thread.joinable()) {
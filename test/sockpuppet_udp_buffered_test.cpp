@@ -56,10 +56,11 @@ try {
   success = false;
 }
 
-void Test(Duration perPacketSendTimeout)
+void Test(Duration perPacketSendTimeout,
+          ReceiveSizing sizing = ReceiveSizing::Fixed)
 {
   // start client and server threads
-  auto serverSock = SocketUdpBuffered(Address(), 0U, 1500U);
+  auto serverSock = SocketUdpBuffered(Address(), 0U, 1500U, sizing);
   auto serverAddr = serverSock.LocalAddress();
 
   std::thread server(Server, std::move(serverSock));
@@ -89,5 +90,8 @@ int main(int, char **)
   std::cout << "test case #3: non-blocking send" << std::endl;
   Test(Duration(0));
 
+  std::cout << "test case #4: adaptive receive sizing" << std::endl;
+  Test(Duration(-1), ReceiveSizing::Adaptive);
+
   return (success ? EXIT_SUCCESS : EXIT_FAILURE);
 }